@@ -95,7 +95,7 @@ void loop()
         Serial.println("\n-----------------------------------------");
         Serial.println("Received message.");
 
-        Serial.printf("  From chat ID: %s\n", Bot.received_msg.chat.id);
+        Serial.printf("  From chat ID: %lld\n", (long long)Bot.received_msg.chat.id);
         Serial.printf("  From chat type: %s\n", Bot.received_msg.chat.type);
         Serial.printf("  From chat alias: %s\n", Bot.received_msg.chat.username);
         Serial.printf("  From chat name: %s %s\n", Bot.received_msg.chat.first_name,
@@ -106,7 +106,7 @@ void loop()
         else
             Serial.println("  From chat where not all members are admins.");
 
-        Serial.printf("  From user ID: %s\n", Bot.received_msg.from.id);
+        Serial.printf("  From user ID: %lld\n", (long long)Bot.received_msg.from.id);
         Serial.printf("  From user alias: %s\n", Bot.received_msg.from.username);
         Serial.printf("  From user name: %s %s\n", Bot.received_msg.from.first_name,
             Bot.received_msg.from.last_name);
@@ -116,7 +116,7 @@ void loop()
         else
             Serial.println("  From user that is not a Bot.");
 
-        Serial.printf("  Message ID: %d\n", Bot.received_msg.message_id);
+        Serial.printf("  Message ID: %lld\n", (long long)Bot.received_msg.message_id);
         Serial.printf("  Message sent date (UNIX epoch time): %ul\n", Bot.received_msg.date);
         Serial.printf("  Text: %s\n", Bot.received_msg.text);
         Serial.printf("-----------------------------------------\n");
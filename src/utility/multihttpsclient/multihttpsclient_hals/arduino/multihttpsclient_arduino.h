@@ -57,6 +57,10 @@ class MultiHTTPSClient
         uint8_t post(const char* uri, const char* host, char* request_response,
                 const size_t request_len, const size_t request_response_max_size,
                 const unsigned long response_timeout=HTTP_WAIT_RESPONSE_TIMEOUT);
+        uint8_t post_parts(const char* uri, const char* host, const char* const* body_parts,
+                const size_t* body_parts_len, const uint8_t num_body_parts, char* response,
+                const size_t response_max_size,
+                const unsigned long response_timeout=HTTP_WAIT_RESPONSE_TIMEOUT);
 
     private:
         // Private Attributtes
@@ -72,6 +76,7 @@ class MultiHTTPSClient
         // Private Methods
         void release_tls_elements();
         size_t write(const char* request);
+        size_t write(const char* data, const size_t data_len);
         size_t read(char* response, const size_t response_len);
         uint8_t read_response(char* response, const size_t response_max_len,
                 const unsigned long response_timeout);
@@ -228,6 +228,53 @@ uint8_t MultiHTTPSClient::post(const char* uri, const char* host, char* request_
     return rc;
 }
 
+// Make and send a HTTP POST request with the body provided in parts (i.e. to send the same body
+// to different recipients by just changing some part of it without rebuilding the whole body)
+// Body parts are not modified, the request response is returned in response argument
+uint8_t MultiHTTPSClient::post_parts(const char* uri, const char* host,
+        const char* const* body_parts, const size_t* body_parts_len, const uint8_t num_body_parts,
+        char* response, const size_t response_max_size, const unsigned long response_timeout)
+{
+    uint64_t request_len = 0;
+    uint8_t rc = 1;
+
+    // Get full body length
+    for(uint8_t i = 0; i < num_body_parts; i++)
+        request_len = request_len + body_parts_len[i];
+
+    // Create header request
+    snprintf_P(_http_header, HTTP_HEADER_MAX_LENGTH, PSTR("POST %s HTTP/1.1\r\nHost: %s\r\n" \
+        "User-Agent: MultiHTTPSClient\r\nAccept: text/html,application/xml,application/json" \
+        "\r\nContent-Type: application/json\r\nContent-Length: %" PRIu64 "\r\n\r\n"), uri,
+        host, request_len);
+
+    // Send request
+    _printf("HTTP POST request to send:\n%s\n", _http_header);
+    if(write(_http_header) != strlen(_http_header))
+    {
+        _println(F("[HTTPS] Error: Incomplete HTTP request sent (sent less bytes than expected)."));
+        return 1;
+    }
+    for(uint8_t i = 0; i < num_body_parts; i++)
+    {
+        if(write(body_parts[i], body_parts_len[i]) != body_parts_len[i])
+        {
+            _println(F("[HTTPS] Error: Incomplete HTTP request sent (sent less bytes than " \
+                "expected)."));
+            return 1;
+        }
+    }
+    _println(F("[HTTPS] POST request successfully sent."));
+    memset(response, '\0', response_max_size);
+
+    // Wait and read response
+    _println(F("[HTTPS] Waiting for response..."));
+    rc = read_response(response, response_max_size, response_timeout);
+    _printf("[HTTPS] Response: %s\n\n", response);
+
+    return rc;
+}
+
 /**************************************************************************************************/
 
 /* Private Methods */
@@ -260,6 +307,27 @@ size_t MultiHTTPSClient::write(const char* request)
     return written_bytes;
 }
 
+// HTTPS Write (provided length)
+size_t MultiHTTPSClient::write(const char* data, const size_t data_len)
+{
+    size_t written_bytes = 0;
+    int ret;
+
+    while(written_bytes < data_len)
+    {
+        ret = esp_tls_conn_write(_tls, data + written_bytes, data_len - written_bytes);
+        if(ret > 0)
+            written_bytes += ret;
+        else if(ret != MBEDTLS_ERR_SSL_WANT_READ  && ret != MBEDTLS_ERR_SSL_WANT_WRITE)
+        {
+            _printf(F("[HTTPS] Client write error 0x%x\n"), ret);
+            break;
+        }
+    }
+
+    return written_bytes;
+}
+
 // HTTPS Read
 size_t MultiHTTPSClient::read(char* response, const size_t response_len)
 {
@@ -3,7 +3,7 @@
 // Description: Multiplatform HTTPS Client implementation for Generic systems (Windows and Linux).
 // Created on: 11 may. 2019
 // Last modified date: 11 apr. 2020
-// Version: 1.0.3
+// Version: 1.0.4
 /**************************************************************************************************/
 
 #if defined(WIN32) || defined(_WIN32) || defined(__linux__)
@@ -48,6 +48,474 @@ clock_t _millis_t0 = clock();
 
 /**************************************************************************************************/
 
+/* mbedtls Memory Pool */
+
+// Pool blocks header (blocks size is a multiple of the header size, so memory is aligned to it)
+typedef struct mem_pool_block
+{
+    size_t size;
+    size_t used;
+} mem_pool_block;
+
+#define MEM_POOL_ALIGN sizeof(mem_pool_block)
+#define MEM_POOL_ALIGN_SIZE(size) (((size) + MEM_POOL_ALIGN-1) & ~(MEM_POOL_ALIGN-1))
+
+#if defined(MULTIHTTPSCLIENT_MEM_POOL)
+static void mem_pool_unregister(MultiHTTPSClientMemPool* mem_pool);
+#endif
+
+// Memory pool constructor (the whole memory is a free block)
+MultiHTTPSClientMemPool::MultiHTTPSClientMemPool(void* memory, const size_t size)
+{
+    size_t align = (MEM_POOL_ALIGN - ((uintptr_t)memory % MEM_POOL_ALIGN)) % MEM_POOL_ALIGN;
+
+    _memory = (uint8_t*)memory + align;
+    _size = (size > align) ? ((size - align) & ~(MEM_POOL_ALIGN-1)) : 0;
+    memset(&_stats, 0, sizeof(_stats));
+    _stats.size = _size;
+    if(_size >= MEM_POOL_ALIGN)
+    {
+        ((mem_pool_block*)_memory)->size = _size;
+        ((mem_pool_block*)_memory)->used = 0;
+    }
+}
+
+// Memory pool destructor (clients can't free its blocks anymore)
+MultiHTTPSClientMemPool::~MultiHTTPSClientMemPool(void)
+{
+#if defined(MULTIHTTPSCLIENT_MEM_POOL)
+    mem_pool_unregister(this);
+#endif
+}
+
+// Allocate a zero initialized array of num elements of given size (calloc() like)
+// Return NULL if there is not enough free memory
+void* MultiHTTPSClientMemPool::alloc(const size_t num, const size_t size)
+{
+    mem_pool_block* block;
+    mem_pool_block* next;
+    size_t pos = 0;
+    size_t block_size;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if((num == 0) || (size == 0) || (num > (SIZE_MAX - (2*MEM_POOL_ALIGN)) / size))
+        return NULL;
+    block_size = MEM_POOL_ALIGN_SIZE(num * size) + MEM_POOL_ALIGN;
+
+    // Get the first free block where it fits (merging it with next free blocks)
+    while(pos < _size)
+    {
+        block = (mem_pool_block*)(_memory + pos);
+        if(!block->used)
+        {
+            while(pos + block->size < _size)
+            {
+                next = (mem_pool_block*)(_memory + pos + block->size);
+                if(next->used)
+                    break;
+                block->size = block->size + next->size;
+            }
+            if(block->size >= block_size)
+            {
+                // Split the block if the rest can be a free block
+                if(block->size - block_size >= (2*MEM_POOL_ALIGN))
+                {
+                    next = (mem_pool_block*)(_memory + pos + block_size);
+                    next->size = block->size - block_size;
+                    next->used = 0;
+                    block->size = block_size;
+                }
+                block->used = 1;
+                memset(block + 1, 0, block->size - MEM_POOL_ALIGN);
+
+                _stats.current = _stats.current + block->size;
+                if(_stats.current > _stats.peak)
+                    _stats.peak = _stats.current;
+                _stats.allocs = _stats.allocs + 1;
+                return block + 1;
+            }
+        }
+        pos = pos + block->size;
+    }
+    _stats.fails = _stats.fails + 1;
+
+    return NULL;
+}
+
+// Free a block of the pool (next free block is merged with it)
+// Return false if the memory is not from this pool
+bool MultiHTTPSClientMemPool::release(void* ptr)
+{
+    mem_pool_block* block;
+    mem_pool_block* next;
+    size_t pos;
+
+    if(((uint8_t*)ptr < _memory + MEM_POOL_ALIGN) || ((uint8_t*)ptr >= _memory + _size))
+        return false;
+    std::lock_guard<std::mutex> lock(_mutex);
+    block = (mem_pool_block*)ptr - 1;
+    if(!block->used)
+        return true;
+
+    block->used = 0;
+    _stats.current = _stats.current - block->size;
+    _stats.frees = _stats.frees + 1;
+    pos = (size_t)((uint8_t*)block - _memory);
+    if(pos + block->size < _size)
+    {
+        next = (mem_pool_block*)(_memory + pos + block->size);
+        if(!next->used)
+            block->size = block->size + next->size;
+    }
+
+    return true;
+}
+
+// Get the pool usage statistics (current and peak are the bytes of allocated blocks, including
+// their headers)
+void MultiHTTPSClientMemPool::get_stats(multihttpsclient_mem_stats* stats)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    *stats = _stats;
+}
+
+#if defined(MULTIHTTPSCLIENT_MEM_POOL)
+
+// Memory pool for the mbedtls allocations of current thread (the one of the client that is
+// calling mbedtls, or NULL to use the system heap)
+static thread_local MultiHTTPSClientMemPool* mem_pool_current = NULL;
+
+// Memory pools set to the clients, so a block is released to its pool even if it is freed while
+// other client, or one without pool, is calling mbedtls (i.e. the pool of a client was changed)
+static MultiHTTPSClientMemPool* mem_pools[MULTIHTTPSCLIENT_MAX_MEM_POOLS];
+static std::mutex mem_pools_mutex;
+
+// Add a pool to the clients pools (if it is not there yet)
+// Return false if there is no space for it
+static bool mem_pool_register(MultiHTTPSClientMemPool* mem_pool)
+{
+    int free_slot = -1;
+
+    std::lock_guard<std::mutex> lock(mem_pools_mutex);
+    for(int i = 0; i < MULTIHTTPSCLIENT_MAX_MEM_POOLS; i++)
+    {
+        if(mem_pools[i] == mem_pool)
+            return true;
+        if((mem_pools[i] == NULL) && (free_slot == -1))
+            free_slot = i;
+    }
+    if(free_slot == -1)
+        return false;
+    mem_pools[free_slot] = mem_pool;
+
+    return true;
+}
+
+// Remove a pool from the clients pools
+static void mem_pool_unregister(MultiHTTPSClientMemPool* mem_pool)
+{
+    std::lock_guard<std::mutex> lock(mem_pools_mutex);
+    for(int i = 0; i < MULTIHTTPSCLIENT_MAX_MEM_POOLS; i++)
+    {
+        if(mem_pools[i] == mem_pool)
+            mem_pools[i] = NULL;
+    }
+}
+
+static void* mem_pool_calloc(size_t num, size_t size)
+{
+    if(mem_pool_current != NULL)
+        return mem_pool_current->alloc(num, size);
+
+    return calloc(num, size);
+}
+
+// Memory that is not from any pool (allocated before setting the pool, or without it) is from
+// the system heap
+static void mem_pool_free(void* ptr)
+{
+    if(ptr == NULL)
+        return;
+    if((mem_pool_current != NULL) && mem_pool_current->release(ptr))
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mem_pools_mutex);
+        for(int i = 0; i < MULTIHTTPSCLIENT_MAX_MEM_POOLS; i++)
+        {
+            if((mem_pools[i] != NULL) && (mem_pools[i] != mem_pool_current) &&
+                mem_pools[i]->release(ptr))
+            {
+                return;
+            }
+        }
+    }
+
+    free(ptr);
+}
+
+// Client memory pool scope: mbedtls allocations of the client use its memory pool while it exists
+class MemPoolScope
+{
+    public:
+        MemPoolScope(MultiHTTPSClientMemPool* mem_pool)
+        {
+            _prev = mem_pool_current;
+            mem_pool_current = mem_pool;
+        }
+        ~MemPoolScope()
+        {
+            mem_pool_current = _prev;
+        }
+
+    private:
+        MultiHTTPSClientMemPool* _prev;
+};
+
+#define MEM_POOL_SCOPE() MemPoolScope mem_pool_scope(_mem_pool)
+
+#else
+
+#define MEM_POOL_SCOPE()
+
+#endif
+
+/**************************************************************************************************/
+
+/* Requests Timing */
+
+#if defined(MULTIHTTPSCLIENT_TIMING)
+
+// Get monotonic clock time (us), not affected by system time changes
+static uint64_t timing_now_us(void)
+{
+#if defined(WIN32) || defined(_WIN32) // Windows
+    LARGE_INTEGER freq;
+    LARGE_INTEGER counter;
+
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return ((uint64_t)(counter.QuadPart / freq.QuadPart) * 1000000ULL) +
+        (((uint64_t)(counter.QuadPart % freq.QuadPart) * 1000000ULL) / freq.QuadPart);
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000ULL) + ((uint64_t)ts.tv_nsec / 1000);
+#endif
+}
+
+#if defined(__linux__)
+// Connect to a host as mbedtls_net_connect() does (trying each resolved address in order until a
+// connection succeeds), but taking a timestamp once the host is resolved, so the DNS resolution
+// and the TCP connection are timed apart
+static int timing_net_connect(mbedtls_net_context* ctx, const char* host, const char* port,
+        uint64_t* t_resolved)
+{
+    struct addrinfo hints;
+    struct addrinfo* addr_list;
+    struct addrinfo* addr;
+    int ret = MBEDTLS_ERR_NET_UNKNOWN_HOST;
+
+    signal(SIGPIPE, SIG_IGN);
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+    if(getaddrinfo(host, port, &hints, &addr_list) != 0)
+    {
+        *t_resolved = timing_now_us();
+        return MBEDTLS_ERR_NET_UNKNOWN_HOST;
+    }
+    *t_resolved = timing_now_us();
+
+    for(addr = addr_list; addr != NULL; addr = addr->ai_next)
+    {
+        ctx->fd = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+        if(ctx->fd < 0)
+        {
+            ret = MBEDTLS_ERR_NET_SOCKET_FAILED;
+            continue;
+        }
+        if(::connect(ctx->fd, addr->ai_addr, addr->ai_addrlen) == 0)
+        {
+            ret = 0;
+            break;
+        }
+        close(ctx->fd);
+        ctx->fd = -1;
+        ret = MBEDTLS_ERR_NET_CONNECT_FAILED;
+    }
+    freeaddrinfo(addr_list);
+
+    return ret;
+}
+#endif
+
+// Take a timestamp, add a phase time to the last request and total times, start the timing of a
+// connection or request, and take the request written timestamp adding the write phase time
+#define TIMING_MARK(t) uint64_t t = timing_now_us()
+#define TIMING_ADD(phase, t_start, t_end) do { \
+    _timing_last.phase = _timing_last.phase + ((t_end) - (t_start)); \
+    _timing_total.phase = _timing_total.phase + ((t_end) - (t_start)); } while(0)
+#define TIMING_START(connection) timing_start(connection)
+#define TIMING_SENT(t_write) do { _timing_t_sent = timing_now_us(); \
+    TIMING_ADD(write_us, t_write, _timing_t_sent); } while(0)
+
+#else
+
+#define TIMING_MARK(t)
+#define TIMING_ADD(phase, t_start, t_end)
+#define TIMING_START(connection)
+#define TIMING_SENT(t_write)
+
+#endif
+
+/**************************************************************************************************/
+
+/* HTTP Responses */
+
+// Check if a string starts with a prefix, ignoring case
+static bool str_starts_nocase(const char* str, const char* prefix)
+{
+    while(*prefix != '\0')
+    {
+        if(tolower((unsigned char)*str) != tolower((unsigned char)*prefix))
+            return false;
+        str = str + 1;
+        prefix = prefix + 1;
+    }
+
+    return true;
+}
+
+// Check if a received HTTP response (null terminated) is complete: its header and Content-Length
+// bytes of body (just the header if it has no Content-Length)
+static bool http_response_complete(const char* response, const size_t response_len)
+{
+    const char* header_end;
+    const char* line;
+
+    header_end = strstr(response, "\r\n\r\n");
+    if(header_end == NULL)
+        return false;
+    header_end = header_end + strlen("\r\n\r\n");
+
+    line = strstr(response, "\r\n");
+    while((line != NULL) && (line + 2 < header_end))
+    {
+        line = line + 2;
+        if(str_starts_nocase(line, "Content-Length:"))
+        {
+            return ((uint64_t)(response + response_len - header_end) >=
+                strtoull(line + strlen("Content-Length:"), NULL, 10));
+        }
+        line = strstr(line, "\r\n");
+    }
+
+    return true;
+}
+
+/**************************************************************************************************/
+
+/* Asynchronous Host Resolution */
+
+#if defined(MULTIHTTPSCLIENT_ASYNC)
+
+// Maximum host name length
+#define RESOLVE_MAX_HOST_LENGTH 256
+
+// Host resolution job: A resolver thread resolves the host and signals it through its event file
+// descriptor (a duplicate of the client one), the job is released by the last of the thread and
+// the client, so the client can drop it while the thread is still resolving (i.e. on disconnect)
+struct multihttpsclient_resolve
+{
+    char host[RESOLVE_MAX_HOST_LENGTH];
+    char port[6];
+    struct addrinfo* addr_list;
+    int result;
+    int event_fd;
+    std::atomic<bool> done;
+    std::atomic<uint8_t> refs;
+};
+
+// Release a resolution job reference (the last one frees it)
+static void resolve_release(multihttpsclient_resolve* job)
+{
+    if(job->refs.fetch_sub(1) != 1)
+        return;
+
+    if(job->addr_list != NULL)
+        freeaddrinfo(job->addr_list);
+    close(job->event_fd);
+    delete job;
+}
+
+// Resolver thread: Resolve the job host and signal the end
+static void* resolve_thread(void* arg)
+{
+    multihttpsclient_resolve* job = (multihttpsclient_resolve*)arg;
+    struct addrinfo hints;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+    job->result = getaddrinfo(job->host, job->port, &hints, &job->addr_list);
+    job->done.store(true);
+    eventfd_write(job->event_fd, 1);
+    resolve_release(job);
+
+    return NULL;
+}
+
+// Start a host resolution in a resolver thread that signals its end through the provided event
+// file descriptor
+// Return NULL if it can't be started
+static multihttpsclient_resolve* resolve_start(const char* host, const uint16_t port,
+        const int event_fd)
+{
+    multihttpsclient_resolve* job;
+    pthread_attr_t attr;
+    pthread_t thread;
+    int ret;
+
+    if(strlen(host) >= RESOLVE_MAX_HOST_LENGTH)
+        return NULL;
+    job = new (std::nothrow) multihttpsclient_resolve;
+    if(job == NULL)
+        return NULL;
+    job->event_fd = fcntl(event_fd, F_DUPFD_CLOEXEC, 0);
+    if(job->event_fd == -1)
+    {
+        delete job;
+        return NULL;
+    }
+    snprintf(job->host, sizeof(job->host), "%s", host);
+    snprintf(job->port, sizeof(job->port), "%d", port);
+    job->addr_list = NULL;
+    job->result = 0;
+    job->done.store(false);
+    job->refs.store(2);
+
+    // Detached thread (it ends by itself, as the job is released by the last user)
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    ret = pthread_create(&thread, &attr, resolve_thread, job);
+    pthread_attr_destroy(&attr);
+    if(ret != 0)
+    {
+        close(job->event_fd);
+        delete job;
+        return NULL;
+    }
+
+    return job;
+}
+
+#endif
+
+/**************************************************************************************************/
+
 /* Constructor & Destructor */
 
 // MultiHTTPSClient constructor, initialize and setup secure client with the certificate
@@ -55,8 +523,17 @@ MultiHTTPSClient::MultiHTTPSClient(void)
 {
     _debug = false;
     _connected = false;
+    _mem_pool = NULL;
     _http_header[0] = '\0';
     _cert_https_server = NULL;
+    reset_timing();
+    #if defined(MULTIHTTPSCLIENT_ASYNC)
+        _async_resolve = NULL;
+        _async_event_fd = -1;
+        _async_addr = NULL;
+        _async_state = MULTIHTTPSCLIENT_ASYNC_IDLE;
+        _async_wait_write = false;
+    #endif
 
     init();
 }
@@ -64,6 +541,13 @@ MultiHTTPSClient::MultiHTTPSClient(void)
 // MultiHTTPSClient destructor, free mbedtls resources
 MultiHTTPSClient::~MultiHTTPSClient(void)
 {
+    // Release the request in flight
+    #if defined(MULTIHTTPSCLIENT_ASYNC)
+        async_release();
+        if(_async_event_fd != -1)
+            close(_async_event_fd);
+    #endif
+
     // Release all mbedtls context
     release_tls_elements();
 }
@@ -96,15 +580,60 @@ void MultiHTTPSClient::set_cert(const char* cert_https_server)
     init();
 }
 
+// Set the memory pool for the client mbedtls allocations (it can be shared with other clients),
+// the allocations already made are kept where they are (system heap or previous pool) until they
+// are released
+// Return false if mbedtls doesn't support setting its allocation functions or there are too many
+// pools
+bool MultiHTTPSClient::set_mem_pool(MultiHTTPSClientMemPool* mem_pool)
+{
+#if defined(MULTIHTTPSCLIENT_MEM_POOL)
+    static bool mem_functions_set = false;
+
+    if((mem_pool != NULL) && !mem_pool_register(mem_pool))
+    {
+        _println("[HTTPS] Error: Too many memory pools.");
+        return false;
+    }
+    if(!mem_functions_set)
+    {
+        mbedtls_platform_set_calloc_free(mem_pool_calloc, mem_pool_free);
+        mem_functions_set = true;
+    }
+    _mem_pool = mem_pool;
+
+    return true;
+#else
+    _println("[HTTPS] Error: mbedtls was built without MBEDTLS_PLATFORM_MEMORY.");
+    (void)mem_pool;
+
+    return false;
+#endif
+}
+
 // Make HTTPS client connection to server
 int8_t MultiHTTPSClient::connect(const char* host, uint16_t port)
 {
     int ret;
 
-    // Start connection
+    MEM_POOL_SCOPE();
+    TIMING_START(true);
+
+    // Start connection (with requests timing, the host resolution is timed apart)
     char str_port[6];
     snprintf(str_port, 6, "%d", port);
-    if((ret = mbedtls_net_connect(&_server_fd, host, str_port, MBEDTLS_NET_PROTO_TCP)) != 0)
+    TIMING_MARK(t_resolve);
+    #if defined(MULTIHTTPSCLIENT_TIMING) && defined(__linux__)
+        uint64_t t_connect;
+        ret = timing_net_connect(&_server_fd, host, str_port, &t_connect);
+    #else
+        TIMING_MARK(t_connect);
+        ret = mbedtls_net_connect(&_server_fd, host, str_port, MBEDTLS_NET_PROTO_TCP);
+    #endif
+    TIMING_ADD(dns_us, t_resolve, t_connect);
+    TIMING_MARK(t_setup);
+    TIMING_ADD(connect_us, t_connect, t_setup);
+    if(ret != 0)
     {
         _printf("[HTTPS] Error: Can't connect to server. ");
         _printf("Start connection fail (mbedtls_net_connect returned %d).\n", ret);
@@ -112,59 +641,28 @@ int8_t MultiHTTPSClient::connect(const char* host, uint16_t port)
     }
 
     // Set SSL/TLS configuration
-    if((ret = mbedtls_ssl_config_defaults(&_tls_cfg, MBEDTLS_SSL_IS_CLIENT,
-        MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT)) != 0)
-    {
-        _printf("[HTTPS] Error: Can't connect to server ");
-        _printf("Default SSL/TLS configuration fail ");
-        _printf("(mbedtls_ssl_config_defaults returned %d).\n", ret);
+    if(tls_setup(host) != 0)
         return 0;
-    }
-    mbedtls_ssl_conf_authmode(&_tls_cfg, MBEDTLS_SSL_VERIFY_OPTIONAL);
-    mbedtls_ssl_conf_ca_chain(&_tls_cfg, &_cacert, NULL);
-    mbedtls_ssl_conf_rng(&_tls_cfg, mbedtls_ctr_drbg_random, &_ctr_drbg);
-    mbedtls_ssl_conf_read_timeout(&_tls_cfg, HTTP_WAIT_RESPONSE_TIMEOUT);
-    //mbedtls_ssl_conf_dbg(&_tls_cfg, my_debug, stdout);
-
-    // SSL/TLS Server, Hostname and Bio setup
-    if((ret = mbedtls_ssl_setup( &_tls, &_tls_cfg)) != 0)
-    {
-        _printf("[HTTPS] Error: Can't connect to server ");
-        _printf("SSL/TLS setup fail (mbedtls_ssl_setup returned %d).\n", ret);
-        return 0;
-    }
-    if((ret = mbedtls_ssl_set_hostname(&_tls, host)) != 0)
-    {
-        _printf("[HTTPS] Error: Can't connect to server. ");
-        _printf("Hostname setup fail (mbedtls_ssl_set_hostname returned %d).\n", ret);
-        return 0;
-    }
-    mbedtls_ssl_set_bio(&_tls, &_server_fd, mbedtls_net_send, mbedtls_net_recv, NULL);
 
     // Perform SSL/TLS Handshake
     while((ret = mbedtls_ssl_handshake(&_tls)) != 0)
     {
         if((ret != MBEDTLS_ERR_SSL_WANT_READ) && (ret != MBEDTLS_ERR_SSL_WANT_WRITE))
-        {
-            _printf("[HTTPS] Error: Can't connect to server ");
-            _printf("SSL/TLS handshake fail (mbedtls_ssl_handshake returned -0x%x).\n", -ret);
-            return 0;
-        }
+            break;
     }
-
-    // Verify server certificate
-    uint32_t flags;
-    if(_cert_https_server != NULL)
+    TIMING_MARK(t_handshake);
+    TIMING_ADD(handshake_us, t_setup, t_handshake);
+    if(ret != 0)
     {
-        if((flags = mbedtls_ssl_get_verify_result(&_tls)) != 0)
-        {
-            char vrfy_buf[512];
-            mbedtls_x509_crt_verify_info(vrfy_buf, sizeof(vrfy_buf), "  ! ", flags);
-            _printf("[HTTPS] Warning: Invalid Server Certificate.\n%s\n", vrfy_buf);
-            return -1;
-        }
+        _printf("[HTTPS] Error: Can't connect to server ");
+        _printf("SSL/TLS handshake fail (mbedtls_ssl_handshake returned -0x%x).\n", -ret);
+        return 0;
     }
 
+    // Verify server certificate
+    if(!verify_cert())
+        return -1;
+
     // Connection stablished and certificate verified
     _connected = true;
     return 1;
@@ -173,10 +671,24 @@ int8_t MultiHTTPSClient::connect(const char* host, uint16_t port)
 // HTTPS client disconnect from server
 void MultiHTTPSClient::disconnect(void)
 {
+    MEM_POOL_SCOPE();
+
+    // Drop the request in flight (its connection can be in progress)
+    #if defined(MULTIHTTPSCLIENT_ASYNC)
+        async_release();
+        _async_state = MULTIHTTPSCLIENT_ASYNC_IDLE;
+    #endif
+
     // Close connection
-    int ret = mbedtls_ssl_close_notify(&_tls);
-    if((ret != 0) && (ret != MBEDTLS_ERR_SSL_WANT_READ) && (ret != MBEDTLS_ERR_SSL_WANT_WRITE))
-        mbedtls_ssl_session_reset(&_tls);
+    if(_connected)
+    {
+        int ret = mbedtls_ssl_close_notify(&_tls);
+        if((ret != 0) && (ret != MBEDTLS_ERR_SSL_WANT_READ) &&
+            (ret != MBEDTLS_ERR_SSL_WANT_WRITE))
+        {
+            mbedtls_ssl_session_reset(&_tls);
+        }
+    }
 
     // Release all mbedtls context
     release_tls_elements();
@@ -208,11 +720,14 @@ uint8_t MultiHTTPSClient::get(const char* uri, const char* host, char* response,
 
     // Send request
     _printf("HTTP GET request to send:\n%s", request);
+    TIMING_START(false);
+    TIMING_MARK(t_write);
     if(write(request) != strlen(request))
     {
         _println(F("[HTTPS] Error: Incomplete HTTP request sent (sent less bytes than expected)."));
         return 1;
     }
+    TIMING_SENT(t_write);
     _println(F("[HTTPS] GET request successfully sent."));
     memset(response, '\0', response_len);
 
@@ -233,35 +748,255 @@ uint8_t MultiHTTPSClient::post(const char* uri, const char* host, char* request_
 {
     uint8_t rc = 0;
 
-    // Create header request
-    snprintf_P(_http_header, HTTP_HEADER_MAX_LENGTH, PSTR("POST %s HTTP/1.1\r\nHost: %s\r\n" \
-        "User-Agent: MultiHTTPSClient\r\nAccept: text/html,application/xml,application/json" \
-        "\r\nContent-Type: application/json\r\nContent-Length: %" PRIu64 "\r\n\r\n"), uri,
-        host, (uint64_t)request_len);
+    // Send request
+    rc = post_send(uri, host, request_response, request_len);
+    if(rc != 0)
+        return rc;
+
+    // Wait and read response
+    return receive(request_response, request_response_max_size, response_timeout);
+}
 
+// Make and send a HTTP POST request without waiting for the response (it must be read later
+// with receive(), i.e. when the socket has data to read)
+uint8_t MultiHTTPSClient::post_send(const char* uri, const char* host, const char* body,
+        const size_t body_len)
+{
     // Send request
-    _printf("HTTP POST request to send:\n%s%s\n", _http_header, request_response);
-    if(write(_http_header) != strlen(_http_header))
+    TIMING_START(false);
+    TIMING_MARK(t_write);
+    if(!post_header(uri, host, body_len))
     {
         _println(F("[HTTPS] Error: Incomplete HTTP request sent (sent less bytes than expected)."));
         return 1;
     }
-    if(write(request_response) != strlen(request_response))
+    _printf("%.*s\n", (int)body_len, body);
+    if(write(body, body_len) != body_len)
     {
         _println(F("[HTTPS] Error: Incomplete HTTP request sent (sent less bytes than expected)."));
         return 1;
     }
+    TIMING_SENT(t_write);
     _println(F("[HTTPS] POST request successfully sent."));
-    memset(request_response, '\0', request_response_max_size);
 
-    // Wait and read response
+    return 0;
+}
+
+// Wait and read the response of a sent request
+uint8_t MultiHTTPSClient::receive(char* response, const size_t response_max_size,
+        const unsigned long response_timeout)
+{
+    uint8_t rc = 0;
+
+    memset(response, '\0', response_max_size);
     _println(F("[HTTPS] Waiting for response..."));
-    rc = read_response(request_response, request_response_max_size, response_timeout);
-    _printf("[HTTPS] Response: %s\n\n", request_response);
+    rc = read_response(response, response_max_size, response_timeout);
+    _printf("[HTTPS] Response: %s\n\n", response);
 
     return rc;
 }
 
+// Get the connection socket file descriptor (i.e. to wait for response data with poll/epoll), or
+// the file descriptor that the asynchronous request in flight waits for (the resolver thread
+// event while the host is resolved)
+// Return -1 if not connected
+int MultiHTTPSClient::get_socket(void)
+{
+    #if defined(MULTIHTTPSCLIENT_ASYNC)
+        if(_async_state == MULTIHTTPSCLIENT_ASYNC_RESOLVE)
+            return _async_event_fd;
+        if(_async_state != MULTIHTTPSCLIENT_ASYNC_IDLE)
+            return _server_fd.fd;
+    #endif
+
+    if(!_connected)
+        return -1;
+    return _server_fd.fd;
+}
+
+#if defined(MULTIHTTPSCLIENT_ASYNC)
+
+// Start an asynchronous HTTP POST request (connecting to the host first if not connected) and run
+// it until it has to wait for its file descriptor (see async_run())
+// Return the request state (fail if it can't be started)
+uint8_t MultiHTTPSClient::async_post(const char* host, const uint16_t port, const char* uri,
+        const char* body, const size_t body_len, char* response, const size_t response_max_size)
+{
+    if(_async_state != MULTIHTTPSCLIENT_ASYNC_IDLE)
+    {
+        _println(F("[HTTPS] Error: Other request is in flight."));
+        return MULTIHTTPSCLIENT_ASYNC_FAIL;
+    }
+
+    // Create the request header (the request is written once connected)
+    _async_header_len = create_post_header(uri, host, body_len);
+    if((_async_header_len == 0) || (response_max_size < 2))
+    {
+        _println(F("[HTTPS] Error: Can't create the HTTP request."));
+        return MULTIHTTPSCLIENT_ASYNC_FAIL;
+    }
+    _async_body = body;
+    _async_body_len = body_len;
+    _async_response = response;
+    _async_response_size = response_max_size;
+    _async_len = 0;
+    _async_wait_write = false;
+
+    // Write the request if connected, or else resolve the host in a resolver thread
+    if(_connected)
+    {
+        mbedtls_net_set_nonblock(&_server_fd);
+        TIMING_START(false);
+        _async_state = MULTIHTTPSCLIENT_ASYNC_WRITE;
+        return async_run();
+    }
+    if(_server_fd.fd != -1)
+        disconnect();
+    TIMING_START(true);
+    if(_async_event_fd == -1)
+        _async_event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if(_async_event_fd != -1)
+        _async_resolve = resolve_start(host, port, _async_event_fd);
+    if(_async_resolve == NULL)
+    {
+        _println(F("[HTTPS] Error: Can't start the host resolution."));
+        return async_end(MULTIHTTPSCLIENT_ASYNC_FAIL);
+    }
+    _async_state = MULTIHTTPSCLIENT_ASYNC_RESOLVE;
+
+    return MULTIHTTPSCLIENT_ASYNC_RESOLVE;
+}
+
+// Run the asynchronous request in flight (when its file descriptor is ready) until it has to wait
+// for it again: resolve the host, connect to it, make the TLS handshake, write the request and
+// read the response
+// Return the request state, or its result once it ends: done (the response is complete) or fail
+// (the connection is closed)
+uint8_t MultiHTTPSClient::async_run(void)
+{
+    uint8_t state;
+    uint8_t next;
+
+    MEM_POOL_SCOPE();
+
+    while(1)
+    {
+        state = _async_state;
+        switch(state)
+        {
+            case MULTIHTTPSCLIENT_ASYNC_RESOLVE:
+                next = async_resolve();
+                break;
+            case MULTIHTTPSCLIENT_ASYNC_CONNECT:
+                next = async_connect();
+                break;
+            case MULTIHTTPSCLIENT_ASYNC_HANDSHAKE:
+                next = async_handshake();
+                break;
+            case MULTIHTTPSCLIENT_ASYNC_WRITE:
+                next = async_write();
+                break;
+            case MULTIHTTPSCLIENT_ASYNC_READ:
+                next = async_read();
+                break;
+            default:
+                return state;
+        }
+        if((next == state) || (next == MULTIHTTPSCLIENT_ASYNC_DONE) ||
+            (next == MULTIHTTPSCLIENT_ASYNC_FAIL))
+        {
+            return next;
+        }
+        _async_state = next;
+    }
+}
+
+// Get the state of the asynchronous request in flight (idle if there is none)
+uint8_t MultiHTTPSClient::async_get_state(void)
+{
+    return _async_state;
+}
+
+// Check if the asynchronous request in flight waits for its file descriptor to be writable (or
+// else to be readable)
+bool MultiHTTPSClient::async_wait_write(void)
+{
+    return _async_wait_write;
+}
+
+// Get the number of response bytes received by the asynchronous request in flight
+size_t MultiHTTPSClient::async_get_received(void)
+{
+    if(_async_state != MULTIHTTPSCLIENT_ASYNC_READ)
+        return 0;
+    return _async_len;
+}
+
+#endif
+
+// Make and send a HTTP POST request with the body provided in parts (i.e. to send the same body
+// to different recipients by just changing some part of it without rebuilding the whole body)
+// Body parts are not modified, the request response is returned in response argument
+uint8_t MultiHTTPSClient::post_parts(const char* uri, const char* host,
+        const char* const* body_parts, const size_t* body_parts_len, const uint8_t num_body_parts,
+        char* response, const size_t response_max_size, const unsigned long response_timeout)
+{
+    uint64_t request_len = 0;
+
+    // Get full body length
+    for(uint8_t i = 0; i < num_body_parts; i++)
+        request_len = request_len + body_parts_len[i];
+
+    // Send request
+    TIMING_START(false);
+    TIMING_MARK(t_write);
+    if(!post_header(uri, host, request_len))
+    {
+        _println(F("[HTTPS] Error: Incomplete HTTP request sent (sent less bytes than expected)."));
+        return 1;
+    }
+    for(uint8_t i = 0; i < num_body_parts; i++)
+    {
+        if(write(body_parts[i], body_parts_len[i]) != body_parts_len[i])
+        {
+            _println(F("[HTTPS] Error: Incomplete HTTP request sent (sent less bytes than " \
+                "expected)."));
+            return 1;
+        }
+    }
+    TIMING_SENT(t_write);
+    _println(F("[HTTPS] POST request successfully sent."));
+
+    // Wait and read response
+    return receive(response, response_max_size, response_timeout);
+}
+
+// Get the phases times of the last request (including the connection made for it, if any) and
+// the total times of the connections and requests made since the client creation or last reset
+// Return false if the client was built without timing (times are not taken)
+bool MultiHTTPSClient::get_timing(multihttpsclient_timing* last, multihttpsclient_timing* total)
+{
+    if(last != NULL)
+        *last = _timing_last;
+    if(total != NULL)
+        *total = _timing_total;
+
+#if defined(MULTIHTTPSCLIENT_TIMING)
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Reset the last request and total times
+void MultiHTTPSClient::reset_timing(void)
+{
+    memset(&_timing_last, 0, sizeof(_timing_last));
+    memset(&_timing_total, 0, sizeof(_timing_total));
+    _timing_t_sent = 0;
+    _timing_connecting = false;
+}
+
 /**************************************************************************************************/
 
 /* Private Methods */
@@ -271,6 +1006,8 @@ bool MultiHTTPSClient::init(void)
     static const char* entropy_generation_key = "tls_client\0";
     int ret = 1;
 
+    MEM_POOL_SCOPE();
+
     // Initialization
     mbedtls_net_init(&_server_fd);
     mbedtls_ssl_init(&_tls);
@@ -302,9 +1039,30 @@ bool MultiHTTPSClient::init(void)
     return true;
 }
 
+// Start the timing of a connection or a request (last request times are cleared, but the ones of
+// the connection made for the request)
+void MultiHTTPSClient::timing_start(const bool connection)
+{
+    if(connection || !_timing_connecting)
+        memset(&_timing_last, 0, sizeof(_timing_last));
+    if(connection)
+    {
+        _timing_last.connections = 1;
+        _timing_total.connections = _timing_total.connections + 1;
+    }
+    else
+    {
+        _timing_last.requests = 1;
+        _timing_total.requests = _timing_total.requests + 1;
+    }
+    _timing_connecting = connection;
+}
+
 // Release all mbedtls context
 void MultiHTTPSClient::release_tls_elements(void)
 {
+    MEM_POOL_SCOPE();
+
     mbedtls_net_free(&_server_fd);
     mbedtls_x509_crt_free(&_cacert);
     mbedtls_ssl_free(&_tls);
@@ -313,12 +1071,74 @@ void MultiHTTPSClient::release_tls_elements(void)
     mbedtls_entropy_free(&_entropy);
 }
 
+// Set up the SSL/TLS configuration and context of the connection to the host
+// Return 0 or the mbedtls error code
+int MultiHTTPSClient::tls_setup(const char* host)
+{
+    int ret;
+
+    MEM_POOL_SCOPE();
+
+    // Set SSL/TLS configuration
+    if((ret = mbedtls_ssl_config_defaults(&_tls_cfg, MBEDTLS_SSL_IS_CLIENT,
+        MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT)) != 0)
+    {
+        _printf("[HTTPS] Error: Can't connect to server ");
+        _printf("Default SSL/TLS configuration fail ");
+        _printf("(mbedtls_ssl_config_defaults returned %d).\n", ret);
+        return ret;
+    }
+    mbedtls_ssl_conf_authmode(&_tls_cfg, MBEDTLS_SSL_VERIFY_OPTIONAL);
+    mbedtls_ssl_conf_ca_chain(&_tls_cfg, &_cacert, NULL);
+    mbedtls_ssl_conf_rng(&_tls_cfg, mbedtls_ctr_drbg_random, &_ctr_drbg);
+    mbedtls_ssl_conf_read_timeout(&_tls_cfg, HTTP_WAIT_RESPONSE_TIMEOUT);
+    //mbedtls_ssl_conf_dbg(&_tls_cfg, my_debug, stdout);
+
+    // SSL/TLS Server, Hostname and Bio setup
+    if((ret = mbedtls_ssl_setup( &_tls, &_tls_cfg)) != 0)
+    {
+        _printf("[HTTPS] Error: Can't connect to server ");
+        _printf("SSL/TLS setup fail (mbedtls_ssl_setup returned %d).\n", ret);
+        return ret;
+    }
+    if((ret = mbedtls_ssl_set_hostname(&_tls, host)) != 0)
+    {
+        _printf("[HTTPS] Error: Can't connect to server. ");
+        _printf("Hostname setup fail (mbedtls_ssl_set_hostname returned %d).\n", ret);
+        return ret;
+    }
+    mbedtls_ssl_set_bio(&_tls, &_server_fd, mbedtls_net_send, mbedtls_net_recv, NULL);
+
+    return 0;
+}
+
+// Verify the server certificate of the connection (if a certificate was set)
+bool MultiHTTPSClient::verify_cert(void)
+{
+    uint32_t flags;
+
+    if(_cert_https_server != NULL)
+    {
+        if((flags = mbedtls_ssl_get_verify_result(&_tls)) != 0)
+        {
+            char vrfy_buf[512];
+            mbedtls_x509_crt_verify_info(vrfy_buf, sizeof(vrfy_buf), "  ! ", flags);
+            _printf("[HTTPS] Warning: Invalid Server Certificate.\n%s\n", vrfy_buf);
+            return false;
+        }
+    }
+
+    return true;
+}
+
 // HTTPS Write
 size_t MultiHTTPSClient::write(const char* request)
 {
     size_t written_bytes = 0;
     int ret;
 
+    MEM_POOL_SCOPE();
+
     written_bytes = strlen(request);
     while((ret = mbedtls_ssl_write(&_tls, (const unsigned char*)request, written_bytes)) <= 0)
     {
@@ -333,10 +1153,37 @@ size_t MultiHTTPSClient::write(const char* request)
     return written_bytes;
 }
 
+// HTTPS Write (provided length)
+size_t MultiHTTPSClient::write(const char* data, const size_t data_len)
+{
+    size_t written_bytes = 0;
+    int ret;
+
+    MEM_POOL_SCOPE();
+
+    while(written_bytes < data_len)
+    {
+        ret = mbedtls_ssl_write(&_tls, (const unsigned char*)(data + written_bytes),
+            data_len - written_bytes);
+        if(ret > 0)
+            written_bytes = written_bytes + ret;
+        else if((ret != MBEDTLS_ERR_SSL_WANT_READ) && (ret != MBEDTLS_ERR_SSL_WANT_WRITE))
+        {
+            _printf(F("[HTTPS] Client write error -0x%x\n"), -ret);
+            break;
+        }
+    }
+
+    return written_bytes;
+}
+
 // HTTPS Read
 size_t MultiHTTPSClient::read(char* response, const size_t response_len)
 {
     int ret;
+
+    MEM_POOL_SCOPE();
+
 _printf("Reading\n");
     ret = mbedtls_ssl_read(&_tls, (unsigned char*)response, response_len);
 _printf("OK\n");
@@ -359,19 +1206,287 @@ _printf("OK\n");
 }
 
 
+// Create the header of a HTTP POST request for a body of the given length
+// Return the header length (0 if it doesn't fit)
+size_t MultiHTTPSClient::create_post_header(const char* uri, const char* host,
+        const uint64_t body_len)
+{
+    int len;
+
+    len = snprintf(_http_header, HTTP_HEADER_MAX_LENGTH, PSTR("POST %s HTTP/1.1\r\n" \
+        "Host: %s\r\nUser-Agent: MultiHTTPSClient\r\n" \
+        "Accept: text/html,application/xml,application/json\r\n" \
+        "Content-Type: application/json\r\nContent-Length: %" PRIu64 "\r\n\r\n"), uri,
+        host, body_len);
+    _printf("HTTP POST request to send:\n%s", _http_header);
+    if((len < 0) || (len >= HTTP_HEADER_MAX_LENGTH))
+        return 0;
+
+    return (size_t)len;
+}
+
+// Create and send the header of a HTTP POST request for a body of the given length
+bool MultiHTTPSClient::post_header(const char* uri, const char* host, const uint64_t body_len)
+{
+    create_post_header(uri, host, body_len);
+    return (write(_http_header) == strlen(_http_header));
+}
+
 // HTTP Read Response
 uint8_t MultiHTTPSClient::read_response(char* response, const size_t response_max_len,
         const unsigned long response_timeout)
 {
+    size_t len = 0;
     size_t rc = 0;
 
-    rc = read(response, response_max_len);
-    if(rc > 0)
+    // Wait for the first response byte apart from the read, unless it is already buffered
+    // Note: Time to first byte is measured until now, so for a response read after poll the
+    // socket, it includes the time since the socket was ready until receive() was called
+    #if defined(MULTIHTTPSCLIENT_TIMING) && defined(__linux__)
+        struct pollfd fds;
+        fds.fd = _server_fd.fd;
+        fds.events = POLLIN;
+        fds.revents = 0;
+        if((mbedtls_ssl_check_pending(&_tls) == 0) && (poll(&fds, 1, response_timeout) == 0))
+        {
+            _printf("[HTTPS] Error: Response timeout.\n");
+            return 1;
+        }
+    #endif
+    TIMING_MARK(t_first_byte);
+    TIMING_ADD(ttfb_us, _timing_t_sent, t_first_byte);
+
+    // Read until the response is complete (a null terminator is kept at the end)
+    len = read(response, response_max_len-1);
+    while((len > 0) && (len < response_max_len-1) && !http_response_complete(response, len))
+    {
+        rc = read(response + len, response_max_len-1 - len);
+        if(rc == 0)
+            break;
+        len = len + rc;
+    }
+    TIMING_MARK(t_read);
+    TIMING_ADD(read_us, t_first_byte, t_read);
+    if((len > 0) && http_response_complete(response, len))
         return 0;
     else
         return 1;
 }
 
+#if defined(MULTIHTTPSCLIENT_ASYNC)
+
+// Asynchronous resolution phase: Once the resolver thread ends, connect to the resolved addresses
+uint8_t MultiHTTPSClient::async_resolve(void)
+{
+    eventfd_t event;
+
+    // The event can be from a dropped previous resolution
+    eventfd_read(_async_event_fd, &event);
+    if(!_async_resolve->done.load())
+        return MULTIHTTPSCLIENT_ASYNC_RESOLVE;
+    if((_async_resolve->result != 0) || (_async_resolve->addr_list == NULL))
+    {
+        _printf("[HTTPS] Error: Can't resolve %s (%s).\n", _async_resolve->host,
+            gai_strerror(_async_resolve->result));
+        return async_end(MULTIHTTPSCLIENT_ASYNC_FAIL);
+    }
+    _async_addr = _async_resolve->addr_list;
+
+    return MULTIHTTPSCLIENT_ASYNC_CONNECT;
+}
+
+// Asynchronous connection phase: Connect (non-blocking) to the resolved addresses in order until
+// one accepts the connection, and set up its TLS
+uint8_t MultiHTTPSClient::async_connect(void)
+{
+    socklen_t len = sizeof(int);
+    int error = 0;
+    bool connected = false;
+
+    // Check the connection in progress (next address is tried if it fails)
+    if(_server_fd.fd != -1)
+    {
+        if((getsockopt(_server_fd.fd, SOL_SOCKET, SO_ERROR, &error, &len) == 0) && (error == 0))
+            connected = true;
+        else
+        {
+            mbedtls_net_free(&_server_fd);
+            _async_addr = _async_addr->ai_next;
+        }
+    }
+
+    // Start the connection to the next address
+    signal(SIGPIPE, SIG_IGN);
+    while(!connected && (_async_addr != NULL))
+    {
+        _server_fd.fd = socket(_async_addr->ai_family, _async_addr->ai_socktype,
+            _async_addr->ai_protocol);
+        if(_server_fd.fd != -1)
+        {
+            mbedtls_net_set_nonblock(&_server_fd);
+            if(::connect(_server_fd.fd, _async_addr->ai_addr, _async_addr->ai_addrlen) == 0)
+            {
+                connected = true;
+                break;
+            }
+            if(errno == EINPROGRESS)
+            {
+                _async_wait_write = true;
+                return MULTIHTTPSCLIENT_ASYNC_CONNECT;
+            }
+            mbedtls_net_free(&_server_fd);
+        }
+        _async_addr = _async_addr->ai_next;
+    }
+    if(!connected)
+    {
+        _printf("[HTTPS] Error: Can't connect to server %s.\n", _async_resolve->host);
+        return async_end(MULTIHTTPSCLIENT_ASYNC_FAIL);
+    }
+
+    // Set SSL/TLS configuration
+    if(tls_setup(_async_resolve->host) != 0)
+        return async_end(MULTIHTTPSCLIENT_ASYNC_FAIL);
+
+    return MULTIHTTPSCLIENT_ASYNC_HANDSHAKE;
+}
+
+// Asynchronous handshake phase: Perform the SSL/TLS handshake as the connection is ready for it
+uint8_t MultiHTTPSClient::async_handshake(void)
+{
+    int ret;
+
+    ret = mbedtls_ssl_handshake(&_tls);
+    if((ret == MBEDTLS_ERR_SSL_WANT_READ) || (ret == MBEDTLS_ERR_SSL_WANT_WRITE))
+    {
+        _async_wait_write = (ret == MBEDTLS_ERR_SSL_WANT_WRITE);
+        return MULTIHTTPSCLIENT_ASYNC_HANDSHAKE;
+    }
+    if(ret != 0)
+    {
+        _printf("[HTTPS] Error: Can't connect to server ");
+        _printf("SSL/TLS handshake fail (mbedtls_ssl_handshake returned -0x%x).\n", -ret);
+        return async_end(MULTIHTTPSCLIENT_ASYNC_FAIL);
+    }
+    if(!verify_cert())
+        return async_end(MULTIHTTPSCLIENT_ASYNC_FAIL);
+
+    // Connection stablished and certificate verified
+    _connected = true;
+    TIMING_START(false);
+
+    return MULTIHTTPSCLIENT_ASYNC_WRITE;
+}
+
+// Asynchronous write phase: Write the request header and body as the connection accepts them
+uint8_t MultiHTTPSClient::async_write(void)
+{
+    const char* data;
+    size_t data_len;
+    int ret;
+
+    while(_async_len < _async_header_len + _async_body_len)
+    {
+        if(_async_len < _async_header_len)
+        {
+            data = _http_header + _async_len;
+            data_len = _async_header_len - _async_len;
+        }
+        else
+        {
+            data = _async_body + (_async_len - _async_header_len);
+            data_len = _async_body_len - (_async_len - _async_header_len);
+        }
+
+        // A write that has to wait is repeated with the same data
+        ret = mbedtls_ssl_write(&_tls, (const unsigned char*)data, data_len);
+        if((ret == MBEDTLS_ERR_SSL_WANT_READ) || (ret == MBEDTLS_ERR_SSL_WANT_WRITE))
+        {
+            _async_wait_write = (ret == MBEDTLS_ERR_SSL_WANT_WRITE);
+            return MULTIHTTPSCLIENT_ASYNC_WRITE;
+        }
+        if(ret <= 0)
+        {
+            _printf(F("[HTTPS] Client write error -0x%x\n"), -ret);
+            return async_end(MULTIHTTPSCLIENT_ASYNC_FAIL);
+        }
+        _async_len = _async_len + ret;
+    }
+    _println(F("[HTTPS] POST request successfully sent."));
+
+    // Wait for the response (the body is not used anymore, it can be in the response buffer)
+    _async_len = 0;
+    _async_response[0] = '\0';
+    _async_wait_write = false;
+
+    return MULTIHTTPSCLIENT_ASYNC_READ;
+}
+
+// Asynchronous read phase: Read the received response data until the response is complete
+uint8_t MultiHTTPSClient::async_read(void)
+{
+    int ret;
+
+    while(1)
+    {
+        if(_async_len >= _async_response_size-1)
+        {
+            _println(F("[HTTPS] Error: Response doesn't fit in the buffer."));
+            return async_end(MULTIHTTPSCLIENT_ASYNC_FAIL);
+        }
+        ret = mbedtls_ssl_read(&_tls, (unsigned char*)(_async_response + _async_len),
+            _async_response_size-1 - _async_len);
+        if((ret == MBEDTLS_ERR_SSL_WANT_READ) || (ret == MBEDTLS_ERR_SSL_WANT_WRITE))
+        {
+            _async_wait_write = (ret == MBEDTLS_ERR_SSL_WANT_WRITE);
+            return MULTIHTTPSCLIENT_ASYNC_READ;
+        }
+        if(ret < 0)
+        {
+            _printf(F("[HTTPS] Client read error -0x%x\n"), -ret);
+            return async_end(MULTIHTTPSCLIENT_ASYNC_FAIL);
+        }
+        if(ret == 0)
+        {
+            _printf(F("[HTTPS] Lost connection while client was reading.\n"));
+            return async_end(MULTIHTTPSCLIENT_ASYNC_FAIL);
+        }
+        _async_len = _async_len + ret;
+        _async_response[_async_len] = '\0';
+        if(http_response_complete(_async_response, _async_len))
+        {
+            _printf("[HTTPS] Response: %s\n\n", _async_response);
+            return async_end(MULTIHTTPSCLIENT_ASYNC_DONE);
+        }
+    }
+}
+
+// End the asynchronous request in flight with its result (the connection is closed if it fails,
+// or else it is blocking again)
+uint8_t MultiHTTPSClient::async_end(const uint8_t result)
+{
+    async_release();
+    _async_state = MULTIHTTPSCLIENT_ASYNC_IDLE;
+    _async_wait_write = false;
+    if(result == MULTIHTTPSCLIENT_ASYNC_FAIL)
+        disconnect();
+    else
+        mbedtls_net_set_block(&_server_fd);
+
+    return result;
+}
+
+// Release the host resolution of the asynchronous request in flight
+void MultiHTTPSClient::async_release(void)
+{
+    if(_async_resolve != NULL)
+        resolve_release(_async_resolve);
+    _async_resolve = NULL;
+    _async_addr = NULL;
+}
+
+#endif
+
 /**************************************************************************************************/
 
 #endif
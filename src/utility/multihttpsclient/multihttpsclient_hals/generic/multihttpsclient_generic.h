@@ -3,7 +3,7 @@
 // Description: Multiplatform HTTPS Client implementation for Generic systems (Windows and Linux).
 // Created on: 11 may. 2019
 // Last modified date: 14 apr. 2020
-// Version: 1.0.4
+// Version: 1.0.5
 /**************************************************************************************************/
 
 #if defined(WIN32) || defined(_WIN32) || defined(__linux__)
@@ -23,12 +23,45 @@
     #include <windows.h>
 #endif
 
+// Requests timing global define of uTLGBotLib enables the client requests timing too
+#if defined(UTLGBOT_TIMING) && !defined(MULTIHTTPSCLIENT_TIMING)
+    #define MULTIHTTPSCLIENT_TIMING
+#endif
+
+// Requests timing resolves the host and waits for the response apart from connect and read them
+// (just on Linux, on Windows the resolution is timed as part of the TCP connection and the wait
+// for the first response byte as part of the response read)
+#if defined(MULTIHTTPSCLIENT_TIMING) && defined(__linux__)
+    #include <netdb.h>
+    #include <poll.h>
+    #include <signal.h>
+    #include <sys/socket.h>
+#endif
+
+// Asynchronous requests (non-blocking host resolution, connection and request phases, driven by
+// the events of a file descriptor, i.e. with epoll), just on Linux
+#if defined(__linux__)
+    #define MULTIHTTPSCLIENT_ASYNC
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <netdb.h>
+    #include <pthread.h>
+    #include <signal.h>
+    #include <sys/eventfd.h>
+    #include <sys/socket.h>
+    #include <atomic>
+    #include <new>
+#endif
+
+#include <ctype.h>
 #include <stdio.h>
 #include <time.h>
 #include <unistd.h>
 #include <inttypes.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
+#include <mutex>
 
 // MBEDTLS library
 #include "mbedtls/net.h"
@@ -38,6 +71,14 @@
 #include "mbedtls/certs.h"
 #include "mbedtls/debug.h"
 #include "mbedtls/error.h"
+#include "mbedtls/platform.h"
+
+// mbedtls allocations can be routed to memory pools if mbedtls was built with platform memory
+// functions that can be set at runtime (MBEDTLS_PLATFORM_MEMORY without calloc/free macros)
+#if defined(MBEDTLS_PLATFORM_MEMORY) && !defined(MBEDTLS_PLATFORM_CALLOC_MACRO) && \
+    !defined(MBEDTLS_PLATFORM_FREE_MACRO)
+    #define MULTIHTTPSCLIENT_MEM_POOL
+#endif
 
 /**************************************************************************************************/
 
@@ -52,8 +93,105 @@
 // HTTP Request header max length
 #define HTTP_HEADER_MAX_LENGTH 256
 
+// Maximum number of memory pools used by the clients at the same time
+#define MULTIHTTPSCLIENT_MAX_MEM_POOLS 32
+
+// Asynchronous request states (async_run() returns the state of the request in flight, or its
+// result: done or fail)
+#define MULTIHTTPSCLIENT_ASYNC_IDLE 0
+#define MULTIHTTPSCLIENT_ASYNC_RESOLVE 1
+#define MULTIHTTPSCLIENT_ASYNC_CONNECT 2
+#define MULTIHTTPSCLIENT_ASYNC_HANDSHAKE 3
+#define MULTIHTTPSCLIENT_ASYNC_WRITE 4
+#define MULTIHTTPSCLIENT_ASYNC_READ 5
+#define MULTIHTTPSCLIENT_ASYNC_DONE 6
+#define MULTIHTTPSCLIENT_ASYNC_FAIL 7
+
+/**************************************************************************************************/
+
+/* mbedtls Memory Pool */
+
+// Memory pool usage statistics (bytes and number of requests)
+typedef struct multihttpsclient_mem_stats
+{
+    size_t size;
+    size_t current;
+    size_t peak;
+    uint32_t allocs;
+    uint32_t frees;
+    uint32_t fails;
+} multihttpsclient_mem_stats;
+
+// Fixed size memory pool in the provided memory for mbedtls allocations (handshakes, records
+// buffers, certificates...), so they don't use the system heap. It can be used by one client or
+// shared by many clients, of any thread (a block is released to its pool whatever client frees
+// it). It must exist while any client uses it
+// Note: First fit allocator with adjacent free blocks merging (mbedtls just keeps a few dozens of
+// allocated blocks at the same time)
+class MultiHTTPSClientMemPool
+{
+    public:
+        // Public Methods
+        MultiHTTPSClientMemPool(void* memory, const size_t size);
+        ~MultiHTTPSClientMemPool();
+        void* alloc(const size_t num, const size_t size);
+        bool release(void* ptr);
+        void get_stats(multihttpsclient_mem_stats* stats);
+
+    private:
+        // Private Attributtes
+        uint8_t* _memory;
+        size_t _size;
+        multihttpsclient_mem_stats _stats;
+        std::mutex _mutex;
+};
+
+/**************************************************************************************************/
+
+/* Requests Timing */
+
+// Requests phases times (us, monotonic clock): DNS resolution, TCP connection and TLS handshake
+// of the connection made for the request (if any), request write, wait for the first response
+// byte since the request was written and response read, and number of connections and requests
+// Note: Timestamps are just taken if the client was built with global define
+// "MULTIHTTPSCLIENT_TIMING", otherwise all of them are zero
+typedef struct multihttpsclient_timing
+{
+    uint64_t dns_us;
+    uint64_t connect_us;
+    uint64_t handshake_us;
+    uint64_t write_us;
+    uint64_t ttfb_us;
+    uint64_t read_us;
+    uint32_t connections;
+    uint32_t requests;
+} multihttpsclient_timing;
+
 /**************************************************************************************************/
 
+/* Asynchronous Host Resolution */
+
+#if defined(MULTIHTTPSCLIENT_ASYNC)
+// Host resolution job of a resolver thread (defined in the implementation)
+struct multihttpsclient_resolve;
+#endif
+
+/**************************************************************************************************/
+
+// Asynchronous requests: A request is started with async_post() and then async_run() is called
+// each time the file descriptor of get_socket() is ready for the events it waits for (readable,
+// or writable if async_wait_write()), until it returns done or fail, i.e.:
+//   state = client.async_post(host, port, uri, body, body_len, response, response_size);
+//   while(state < MULTIHTTPSCLIENT_ASYNC_DONE)
+//   {
+//       wait(client.get_socket(), client.async_wait_write() ? POLLOUT : POLLIN);
+//       state = client.async_run();
+//   }
+// Note: The host is resolved by a thread that signals its result through the file descriptor, so
+// nothing blocks the calling thread. The body must be valid until the request is written (it
+// leaves the write state) and the response is complete once its Content-Length is received
+// Note: The connection is non-blocking just while the request is in flight, so blocking requests
+// can be made on it between asynchronous ones
 class MultiHTTPSClient
 {
     public:
@@ -63,6 +201,7 @@ class MultiHTTPSClient
         void set_debug(const bool debug);
         void set_cert(const char* cert_https_server);
         void set_cert(const uint8_t* ca_pem_start, const uint8_t* ca_pem_end);
+        bool set_mem_pool(MultiHTTPSClientMemPool* mem_pool);
         int8_t connect(const char* host, uint16_t port);
         void disconnect();
         bool is_connected();
@@ -71,6 +210,26 @@ class MultiHTTPSClient
         uint8_t post(const char* uri, const char* host, char* request_response,
                 const size_t request_len, const size_t request_response_max_size,
                 const unsigned long response_timeout=HTTP_WAIT_RESPONSE_TIMEOUT);
+        uint8_t post_send(const char* uri, const char* host, const char* body,
+                const size_t body_len);
+        uint8_t receive(char* response, const size_t response_max_size,
+                const unsigned long response_timeout=HTTP_WAIT_RESPONSE_TIMEOUT);
+        int get_socket();
+#if defined(MULTIHTTPSCLIENT_ASYNC)
+        uint8_t async_post(const char* host, const uint16_t port, const char* uri,
+                const char* body, const size_t body_len, char* response,
+                const size_t response_max_size);
+        uint8_t async_run();
+        uint8_t async_get_state();
+        bool async_wait_write();
+        size_t async_get_received();
+#endif
+        uint8_t post_parts(const char* uri, const char* host, const char* const* body_parts,
+                const size_t* body_parts_len, const uint8_t num_body_parts, char* response,
+                const size_t response_max_size,
+                const unsigned long response_timeout=HTTP_WAIT_RESPONSE_TIMEOUT);
+        bool get_timing(multihttpsclient_timing* last, multihttpsclient_timing* total=NULL);
+        void reset_timing();
 
     private:
         // Private Attributtes
@@ -82,16 +241,49 @@ class MultiHTTPSClient
         mbedtls_ssl_context _tls;
         mbedtls_ssl_config _tls_cfg;
         mbedtls_x509_crt _cacert;
+        MultiHTTPSClientMemPool* _mem_pool;
+        multihttpsclient_timing _timing_last;
+        multihttpsclient_timing _timing_total;
+        uint64_t _timing_t_sent;
+        bool _timing_connecting;
         bool _connected;
         bool _debug;
+#if defined(MULTIHTTPSCLIENT_ASYNC)
+        multihttpsclient_resolve* _async_resolve;
+        int _async_event_fd;
+        struct addrinfo* _async_addr;
+        const char* _async_body;
+        char* _async_response;
+        size_t _async_body_len;
+        size_t _async_response_size;
+        size_t _async_header_len;
+        size_t _async_len;
+        uint8_t _async_state;
+        bool _async_wait_write;
+#endif
 
         // Private Methods
         bool init();
+        void timing_start(const bool connection);
         void release_tls_elements();
         size_t write(const char* request);
+        size_t write(const char* data, const size_t data_len);
         size_t read(char* response, const size_t response_len);
+        size_t create_post_header(const char* uri, const char* host, const uint64_t body_len);
+        bool post_header(const char* uri, const char* host, const uint64_t body_len);
         uint8_t read_response(char* response, const size_t response_max_len,
         const unsigned long response_timeout);
+        int tls_setup(const char* host);
+        bool verify_cert();
+#if defined(MULTIHTTPSCLIENT_ASYNC)
+        uint8_t async_resolve();
+        uint8_t async_connect();
+        uint8_t async_handshake();
+        uint8_t async_write();
+        uint8_t async_read();
+        uint8_t async_end(const uint8_t result);
+        void async_release();
+#endif
 };
 
 /**************************************************************************************************/
@@ -11,6 +11,21 @@
 
 #include "utlgbotlib.h"
 
+#if defined(UTLGBOT_REACTOR)
+    #include <errno.h>
+    #include <sys/epoll.h>
+    #include <unistd.h>
+#endif
+#if defined(UTLGBOT_FANOUT)
+    #include <fcntl.h>
+    #include <linux/futex.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <sys/syscall.h>
+    #include <time.h>
+    #include <unistd.h>
+#endif
+
 /**************************************************************************************************/
 
 /* Macros */
@@ -26,6 +41,8 @@
         #define _printf(...)
     #endif
     #define _yield() do { yield(); } while(0)
+    #define _millis() millis()
+    #define _delay(x) do { delay(x); } while(0)
 #elif defined(ESP_IDF) // ESP32 ESPIDF Framework
 
     #include "freertos/FreeRTOS.h"
@@ -43,6 +60,8 @@
         #define _printf(...)
     #endif
     #define _yield() do { taskYIELD(); } while(0)
+    #define _millis() (unsigned long)(esp_timer_get_time()/1000)
+    #define _delay(x) do { vTaskDelay(x/portTICK_PERIOD_MS); } while(0)
 #else // Generic devices (intel, amd, arm) and OS (windows, Linux)
     #ifndef UTLGBOT_NO_DEBUG
         #define _print(x) do { if(_debug_level) printf("%s", x); } while(0)
@@ -54,6 +73,75 @@
         #define _printf(...)
     #endif
     #define _yield()
+    #if defined(WIN32) || defined(_WIN32) // Windows
+        #define _millis() (unsigned long)(GetTickCount64())
+        static inline uint64_t _micros(void)
+        {
+            LARGE_INTEGER freq, counter;
+            QueryPerformanceFrequency(&freq);
+            QueryPerformanceCounter(&counter);
+            return ((uint64_t)(counter.QuadPart / freq.QuadPart) * 1000000ULL) +
+                (((uint64_t)(counter.QuadPart % freq.QuadPart) * 1000000ULL) / freq.QuadPart);
+        }
+        #define _delay(x) do { Sleep(x); } while(0)
+    #else // Linux (monotonic clock, not affected by system time changes)
+        static inline unsigned long _millis(void)
+        {
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            return (unsigned long)((ts.tv_sec*1000) + (ts.tv_nsec/1000000));
+        }
+        static inline uint64_t _micros(void)
+        {
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            return ((uint64_t)ts.tv_sec*1000000ULL) + ((uint64_t)ts.tv_nsec/1000);
+        }
+        #define _delay(x) do { usleep((x)*1000); } while(0)
+    #endif
+#endif
+
+// SIMD instructions to speed up JSON strings processing (just Generic devices, it can be disabled
+// by global define "UTLGBOT_NO_SIMD")
+#if !defined(ARDUINO) && !defined(ESP_IDF) && !defined(UTLGBOT_NO_SIMD)
+    #if defined(__AVX2__)
+        #include <immintrin.h>
+        #define UTLGBOT_SIMD_AVX2
+        #define UTLGBOT_SIMD_WIDTH 32
+    #elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+        #include <emmintrin.h>
+        #define UTLGBOT_SIMD_SSE2
+        #define UTLGBOT_SIMD_WIDTH 16
+    #elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+        #include <arm_neon.h>
+        #define UTLGBOT_SIMD_NEON
+        #define UTLGBOT_SIMD_WIDTH 16
+    #endif
+#endif
+
+// Count trailing zeros of a non-zero mask
+#if defined(_MSC_VER)
+    #include <intrin.h>
+    static inline uint32_t _ctz(uint64_t x) { unsigned long i; _BitScanForward64(&i, x); return i; }
+#else
+    #define _ctz(x) (uint32_t)__builtin_ctzll(x)
+#endif
+
+// Send requests and callback answers paths locks (send requests can be made from many threads
+// once the paths are split)
+#if defined(UTLGBOT_SPLIT_PATHS)
+    #define SEND_PATH_LOCK() std::lock_guard<std::recursive_mutex> send_path_lock(_tx_mutex)
+    #define CB_PATH_LOCK() std::lock_guard<std::mutex> cb_path_lock(_cb_mutex)
+#else
+    #define SEND_PATH_LOCK()
+    #define CB_PATH_LOCK()
+#endif
+
+// Requests timing of a path request result (response check time and if it fails)
+#if defined(UTLGBOT_TIMING)
+    #define REQ_TIMING_ADD(path, check_us, ok) timing_add(path, check_us, ok)
+#else
+    #define REQ_TIMING_ADD(path, check_us, ok)
 #endif
 
 // Functions Return Codes
@@ -63,33 +151,729 @@
 
 /**************************************************************************************************/
 
+/* JSON Known Keys */
+
+// Known Telegram JSON keys IDs (index of the key in tlg_keys list)
+#define TLG_KEY_UPDATE_ID 0
+#define TLG_KEY_MESSAGE_ID 1
+#define TLG_KEY_DATE 2
+#define TLG_KEY_TEXT 3
+#define TLG_KEY_FROM 4
+#define TLG_KEY_CHAT 5
+#define TLG_KEY_ID 6
+#define TLG_KEY_IS_BOT 7
+#define TLG_KEY_FIRST_NAME 8
+#define TLG_KEY_LAST_NAME 9
+#define TLG_KEY_USERNAME 10
+#define TLG_KEY_LANGUAGE_CODE 11
+#define TLG_KEY_TYPE 12
+#define TLG_KEY_TITLE 13
+#define TLG_KEY_ALL_MEMBERS_ARE_ADMINS 14
+#define TLG_KEY_CALLBACK_QUERY 15
+#define TLG_KEY_MESSAGE 16
+#define TLG_KEY_DATA 17
+#define TLG_KEY_DOCUMENT 18
+#define TLG_KEY_FILE_ID 19
+#define TLG_KEY_FILE_UNIQUE_ID 20
+#define TLG_KEY_FILE_NAME 21
+#define TLG_KEY_MIME_TYPE 22
+#define TLG_KEY_FILE_SIZE 23
+#define TLG_KEY_THUMB 24
+#define TLG_KEY_WIDTH 25
+#define TLG_KEY_HEIGHT 26
+#define TLG_KEY_PHOTO 27
+#define TLG_KEY_STICKER 28
+#define TLG_KEY_REPLY_TO_MESSAGE 29
+#define TLG_KEY_FORWARD_FROM 30
+#define TLG_KEY_ENTITIES 31
+#define TLG_KEY_CAPTION 32
+#define TLG_KEY_IS_ANIMATED 33
+#define TLG_KEY_EMOJI 34
+#define TLG_KEY_SET_NAME 35
+#define TLG_KEY_OFFSET 36
+#define TLG_KEY_LENGTH 37
+#define TLG_NUM_KEYS 38
+#define TLG_KEY_UNKNOWN 0xFF
+
+static constexpr const char* tlg_keys[TLG_NUM_KEYS] =
+{
+    "update_id", "message_id", "date", "text", "from", "chat", "id", "is_bot", "first_name",
+    "last_name", "username", "language_code", "type", "title", "all_members_are_administrators",
+    "callback_query", "message", "data", "document", "file_id", "file_unique_id", "file_name",
+    "mime_type", "file_size", "thumb", "width", "height", "photo", "sticker", "reply_to_message",
+    "forward_from", "entities", "caption", "is_animated", "emoji", "set_name", "offset", "length"
+};
+
+// Perfect hash of the known keys from its length, first and two last characters, so a key can
+// be identified in O(1) without checking it against each known key (the two last characters are
+// needed to tell apart keys like "file_name" and "file_size")
+// Note: Multipliers and table size were chosen for the keys list to be collision free, the
+// static_assert below must be checked if any key is added (just search new multipliers)
+#define TLG_KEYS_HASH_SIZE 128
+#define TLG_KEYS_HASH_MUL_LEN 1
+#define TLG_KEYS_HASH_MUL_FIRST 9
+#define TLG_KEYS_HASH_MUL_PENULT 35
+
+static constexpr uint8_t tlg_key_hash(const size_t len, const char first, const char penult,
+    const char last)
+{
+    return (uint8_t)(((len*TLG_KEYS_HASH_MUL_LEN) + ((uint8_t)first*TLG_KEYS_HASH_MUL_FIRST) +
+        ((uint8_t)penult*TLG_KEYS_HASH_MUL_PENULT) + (uint8_t)last) & (TLG_KEYS_HASH_SIZE-1));
+}
+
+static constexpr size_t tlg_key_length(const char* key)
+{
+    return (*key == '\0') ? 0 : 1 + tlg_key_length(key+1);
+}
+
+static constexpr uint8_t tlg_key_slot(const uint8_t key_id)
+{
+    return tlg_key_hash(tlg_key_length(tlg_keys[key_id]), tlg_keys[key_id][0],
+        tlg_keys[key_id][tlg_key_length(tlg_keys[key_id])-2],
+        tlg_keys[key_id][tlg_key_length(tlg_keys[key_id])-1]);
+}
+
+// Get the first known key ID (starting from key_id) which hash slot is the given one
+static constexpr uint8_t tlg_key_in_slot(const uint8_t slot, const uint8_t key_id)
+{
+    return (key_id == TLG_NUM_KEYS) ? TLG_KEY_UNKNOWN :
+        (tlg_key_slot(key_id) == slot) ? key_id : tlg_key_in_slot(slot, key_id+1);
+}
+
+static constexpr bool tlg_keys_collision_free(const uint8_t key_id)
+{
+    return (key_id == TLG_NUM_KEYS) ? true :
+        (tlg_key_in_slot(tlg_key_slot(key_id), 0) == key_id) &&
+        tlg_keys_collision_free(key_id+1);
+}
+
+static_assert(tlg_keys_collision_free(0), "Known JSON keys hash collision");
+
+// Hash table of known keys IDs (TLG_KEY_UNKNOWN for empty slots)
+struct tlg_keys_table
+{
+    uint8_t key_id[TLG_KEYS_HASH_SIZE];
+};
+
+template<size_t... I>
+static constexpr tlg_keys_table tlg_make_keys_table(tlg_index_seq<I...>)
+{
+    return tlg_keys_table{ { tlg_key_in_slot(I, 0)... } };
+}
+
+static constexpr tlg_keys_table tlg_keys_hash_table =
+    tlg_make_keys_table(typename tlg_make_index_seq<TLG_KEYS_HASH_SIZE>::type());
+
+/**************************************************************************************************/
+
+/* JSON Decode Tables */
+
+// Each Telegram type is decoded from its JSON object by a table of (key, type, offset, size)
+// fields, so adding a field or a new type is just adding a table entry or a new table
+// Note: Nested objects are decoded with their own table, at the offset of the member where they
+// are stored (offset 0 and the outer type offsets flatten the nested object into the outer one)
+
+// Fields types
+#define TLG_FIELD_INT64 0  // int64_t
+#define TLG_FIELD_UINT32 1 // uint32_t
+#define TLG_FIELD_BOOL 2   // bool
+#define TLG_FIELD_STR 3    // char[size] (unescaped and null terminated)
+#define TLG_FIELD_STR_AT 4 // char[size] with '@' prefix (i.e. "@username")
+#define TLG_FIELD_SPAN 5   // tlg_str_span (position of the string in the received data buffer)
+#define TLG_FIELD_OBJECT 6 // Nested object
+#define TLG_FIELD_ARRAY 7  // Array of objects (items of given size and uint8_t count member)
+
+// Decode table entry
+struct tlg_json_field
+{
+    uint8_t key_id;
+    uint8_t type;
+    uint8_t num_fields;
+    uint8_t max_items;
+    uint16_t offset;
+    uint16_t size;
+    uint16_t count_offset;
+    const tlg_json_field* fields;
+};
+
+#define TLG_FIELDS_NUM(fields) (uint8_t)(sizeof(fields)/sizeof(fields[0]))
+#define TLG_ARRAY_NUM(array) (uint8_t)(sizeof(array)/sizeof(array[0]))
+#define TLG_FIELD(key_id, type, tlg_type, member) \
+    { key_id, type, 0, 0, offsetof(tlg_type, member), sizeof(((tlg_type*)0)->member), 0, NULL }
+#define TLG_FIELD_OBJ(key_id, tlg_type, member, fields) \
+    { key_id, TLG_FIELD_OBJECT, TLG_FIELDS_NUM(fields), 0, offsetof(tlg_type, member), \
+      sizeof(((tlg_type*)0)->member), 0, fields }
+#define TLG_FIELD_OBJ_FLAT(key_id, fields) \
+    { key_id, TLG_FIELD_OBJECT, TLG_FIELDS_NUM(fields), 0, 0, 0, 0, fields }
+#define TLG_FIELD_ARR(key_id, tlg_type, member, count_member, fields) \
+    { key_id, TLG_FIELD_ARRAY, TLG_FIELDS_NUM(fields), TLG_ARRAY_NUM(((tlg_type*)0)->member), \
+      offsetof(tlg_type, member), sizeof(((tlg_type*)0)->member[0]), \
+      offsetof(tlg_type, count_member), fields }
+
+// Spans positions and lengths must fit in its 16 bits members
+static_assert(HTTP_MAX_RES_LENGTH <= UINT16_MAX, "Received data buffer too big for string spans");
+
+// PhotoSize
+static const tlg_json_field tlg_photo_size_fields[] =
+{
+    TLG_FIELD(TLG_KEY_FILE_ID, TLG_FIELD_SPAN, tlg_type_photo_size, file_id),
+    TLG_FIELD(TLG_KEY_FILE_UNIQUE_ID, TLG_FIELD_SPAN, tlg_type_photo_size, file_unique_id),
+    TLG_FIELD(TLG_KEY_WIDTH, TLG_FIELD_UINT32, tlg_type_photo_size, width),
+    TLG_FIELD(TLG_KEY_HEIGHT, TLG_FIELD_UINT32, tlg_type_photo_size, height),
+    TLG_FIELD(TLG_KEY_FILE_SIZE, TLG_FIELD_INT64, tlg_type_photo_size, file_size)
+};
+
+// Document
+static const tlg_json_field tlg_document_fields[] =
+{
+    TLG_FIELD(TLG_KEY_FILE_ID, TLG_FIELD_SPAN, tlg_type_document, file_id),
+    TLG_FIELD(TLG_KEY_FILE_UNIQUE_ID, TLG_FIELD_SPAN, tlg_type_document, file_unique_id),
+    TLG_FIELD_OBJ(TLG_KEY_THUMB, tlg_type_document, thumb, tlg_photo_size_fields),
+    TLG_FIELD(TLG_KEY_FILE_NAME, TLG_FIELD_SPAN, tlg_type_document, file_name),
+    TLG_FIELD(TLG_KEY_MIME_TYPE, TLG_FIELD_SPAN, tlg_type_document, mime_type),
+    TLG_FIELD(TLG_KEY_FILE_SIZE, TLG_FIELD_INT64, tlg_type_document, file_size)
+};
+
+// Sticker
+static const tlg_json_field tlg_sticker_fields[] =
+{
+    TLG_FIELD(TLG_KEY_FILE_ID, TLG_FIELD_SPAN, tlg_type_sticker, file_id),
+    TLG_FIELD(TLG_KEY_FILE_UNIQUE_ID, TLG_FIELD_SPAN, tlg_type_sticker, file_unique_id),
+    TLG_FIELD(TLG_KEY_WIDTH, TLG_FIELD_UINT32, tlg_type_sticker, width),
+    TLG_FIELD(TLG_KEY_HEIGHT, TLG_FIELD_UINT32, tlg_type_sticker, height),
+    TLG_FIELD(TLG_KEY_IS_ANIMATED, TLG_FIELD_BOOL, tlg_type_sticker, is_animated),
+    TLG_FIELD(TLG_KEY_EMOJI, TLG_FIELD_SPAN, tlg_type_sticker, emoji),
+    TLG_FIELD(TLG_KEY_SET_NAME, TLG_FIELD_SPAN, tlg_type_sticker, set_name),
+    TLG_FIELD(TLG_KEY_FILE_SIZE, TLG_FIELD_INT64, tlg_type_sticker, file_size)
+};
+
+// MessageEntity
+static const tlg_json_field tlg_message_entity_fields[] =
+{
+    TLG_FIELD(TLG_KEY_TYPE, TLG_FIELD_SPAN, tlg_type_message_entity, type),
+    TLG_FIELD(TLG_KEY_OFFSET, TLG_FIELD_UINT32, tlg_type_message_entity, offset),
+    TLG_FIELD(TLG_KEY_LENGTH, TLG_FIELD_UINT32, tlg_type_message_entity, length)
+};
+
+// User
+static const tlg_json_field tlg_user_fields[] =
+{
+    TLG_FIELD(TLG_KEY_ID, TLG_FIELD_INT64, tlg_type_user, id),
+    TLG_FIELD(TLG_KEY_IS_BOT, TLG_FIELD_BOOL, tlg_type_user, is_bot),
+    TLG_FIELD(TLG_KEY_FIRST_NAME, TLG_FIELD_STR, tlg_type_user, first_name),
+    TLG_FIELD(TLG_KEY_LAST_NAME, TLG_FIELD_STR, tlg_type_user, last_name),
+    TLG_FIELD(TLG_KEY_USERNAME, TLG_FIELD_STR_AT, tlg_type_user, username),
+    TLG_FIELD(TLG_KEY_LANGUAGE_CODE, TLG_FIELD_STR, tlg_type_user, language_code)
+};
+
+// Chat
+static const tlg_json_field tlg_chat_fields[] =
+{
+    TLG_FIELD(TLG_KEY_ID, TLG_FIELD_INT64, tlg_type_chat, id),
+    TLG_FIELD(TLG_KEY_TYPE, TLG_FIELD_STR, tlg_type_chat, type),
+    TLG_FIELD(TLG_KEY_TITLE, TLG_FIELD_STR, tlg_type_chat, title),
+    TLG_FIELD(TLG_KEY_USERNAME, TLG_FIELD_STR, tlg_type_chat, username),
+    TLG_FIELD(TLG_KEY_FIRST_NAME, TLG_FIELD_STR, tlg_type_chat, first_name),
+    TLG_FIELD(TLG_KEY_LAST_NAME, TLG_FIELD_STR, tlg_type_chat, last_name),
+    TLG_FIELD(TLG_KEY_ALL_MEMBERS_ARE_ADMINS, TLG_FIELD_BOOL, tlg_type_chat,
+        all_members_are_administrators)
+};
+
+// Replied message (just the sender user id)
+static const tlg_json_field tlg_message_ref_from_fields[] =
+{
+    TLG_FIELD(TLG_KEY_ID, TLG_FIELD_INT64, tlg_type_message_ref, from_id)
+};
+
+static const tlg_json_field tlg_message_ref_fields[] =
+{
+    TLG_FIELD(TLG_KEY_MESSAGE_ID, TLG_FIELD_INT64, tlg_type_message_ref, message_id),
+    TLG_FIELD_OBJ_FLAT(TLG_KEY_FROM, tlg_message_ref_from_fields),
+    TLG_FIELD(TLG_KEY_DATE, TLG_FIELD_UINT32, tlg_type_message_ref, date),
+    TLG_FIELD(TLG_KEY_TEXT, TLG_FIELD_SPAN, tlg_type_message_ref, text)
+};
+
+// Message (the index of each field in the table is its TLG_MSG_HAS_* presence bit)
+static const tlg_json_field tlg_message_fields[] =
+{
+    TLG_FIELD(TLG_KEY_MESSAGE_ID, TLG_FIELD_INT64, tlg_type_message, message_id),
+    TLG_FIELD_OBJ(TLG_KEY_FROM, tlg_type_message, from, tlg_user_fields),
+    TLG_FIELD(TLG_KEY_DATE, TLG_FIELD_UINT32, tlg_type_message, date),
+    TLG_FIELD_OBJ(TLG_KEY_CHAT, tlg_type_message, chat, tlg_chat_fields),
+    TLG_FIELD(TLG_KEY_TEXT, TLG_FIELD_STR, tlg_type_message, text),
+    TLG_FIELD_OBJ(TLG_KEY_DOCUMENT, tlg_type_message, document, tlg_document_fields),
+    TLG_FIELD_ARR(TLG_KEY_PHOTO, tlg_type_message, photo, photo_count, tlg_photo_size_fields),
+    TLG_FIELD_OBJ(TLG_KEY_STICKER, tlg_type_message, sticker, tlg_sticker_fields),
+    TLG_FIELD_OBJ(TLG_KEY_REPLY_TO_MESSAGE, tlg_type_message, reply_to_message,
+        tlg_message_ref_fields),
+    TLG_FIELD_OBJ(TLG_KEY_FORWARD_FROM, tlg_type_message, forward_from, tlg_user_fields),
+    TLG_FIELD_ARR(TLG_KEY_ENTITIES, tlg_type_message, entities, entities_count,
+        tlg_message_entity_fields),
+    TLG_FIELD(TLG_KEY_CAPTION, TLG_FIELD_SPAN, tlg_type_message, caption)
+};
+
+static_assert(TLG_MSG_HAS_ALL == ((1UL << TLG_FIELDS_NUM(tlg_message_fields)) - 1),
+    "Message presence bits doesn't match its fields table");
+
+// Just the chat id of the message (lazy decode pending bit out of the presence bits)
+#define TLG_MSG_CHAT_ID_ONLY (1UL << 31)
+
+static const tlg_json_field tlg_chat_id_fields[] =
+{
+    TLG_FIELD(TLG_KEY_ID, TLG_FIELD_INT64, tlg_type_chat, id)
+};
+
+// Message fields table entry of the chat (TLG_MSG_HAS_CHAT bit)
+#define TLG_MSG_FIELD_CHAT 3
+
+// CallbackQuery (just the user id, and the message id and chat id of the message with the button)
+static const tlg_json_field tlg_callback_query_from_fields[] =
+{
+    TLG_FIELD(TLG_KEY_ID, TLG_FIELD_INT64, tlg_type_callback_query, from_id)
+};
+
+static const tlg_json_field tlg_callback_query_chat_fields[] =
+{
+    TLG_FIELD(TLG_KEY_ID, TLG_FIELD_INT64, tlg_type_callback_query, chat_id)
+};
+
+static const tlg_json_field tlg_callback_query_message_fields[] =
+{
+    TLG_FIELD(TLG_KEY_MESSAGE_ID, TLG_FIELD_INT64, tlg_type_callback_query, message_id),
+    TLG_FIELD_OBJ_FLAT(TLG_KEY_CHAT, tlg_callback_query_chat_fields)
+};
+
+static const tlg_json_field tlg_callback_query_fields[] =
+{
+    TLG_FIELD(TLG_KEY_ID, TLG_FIELD_STR, tlg_type_callback_query, id),
+    TLG_FIELD_OBJ_FLAT(TLG_KEY_FROM, tlg_callback_query_from_fields),
+    TLG_FIELD_OBJ_FLAT(TLG_KEY_MESSAGE, tlg_callback_query_message_fields),
+    TLG_FIELD(TLG_KEY_DATA, TLG_FIELD_STR, tlg_type_callback_query, data)
+};
+
+/**************************************************************************************************/
+
+/* SIMD JSON Tokenizer */
+
+// JSON tokenizer that gets the same tokens as jsmn (non strict mode) for valid JSON, but finding
+// the quotes, operators and primitives boundaries of 64 bytes blocks at once with SIMD
+// instructions (like simdjson stage 1), so just those positions are processed one by one
+// Note: Strings escape sequences are not validated (just skipped) and invalid JSON can be
+// tokenized in a different way than jsmn (it is always rejected or accepted as jsmn would do for
+// Telegram API responses, that are valid JSON)
+#if defined(UTLGBOT_SIMD_WIDTH)
+
+// Maximum nesting level of objects and arrays (deeper JSON are tokenized by jsmn)
+#define JSON_SIMD_MAX_DEPTH 32
+
+#if defined(UTLGBOT_SIMD_NEON)
+// Get a 16 bits mask from the most significant bit of each byte of a comparison result
+static inline uint16_t json_simd_neon_movemask(uint8x16_t v)
+{
+    static const uint8_t bits[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    uint8x8_t r;
+
+    v = vandq_u8(v, vld1q_u8(bits));
+    r = vpadd_u8(vget_low_u8(v), vget_high_u8(v));
+    r = vpadd_u8(r, r);
+    r = vpadd_u8(r, r);
+
+    return vget_lane_u16(vreinterpret_u16_u8(r), 0);
+}
+#endif
+
+// Get the masks of quotes, backslashes, operators ({}[]:,) and whitespaces of a 64 bytes block
+static inline void json_simd_classify(const char* block, uint64_t* quotes, uint64_t* bslashes,
+    uint64_t* ops, uint64_t* spaces)
+{
+    *quotes = 0;
+    *bslashes = 0;
+    *ops = 0;
+    *spaces = 0;
+    for(uint32_t i = 0; i < 64; i = i + UTLGBOT_SIMD_WIDTH)
+    {
+        uint64_t q, b, o, s;
+#if defined(UTLGBOT_SIMD_AVX2)
+        __m256i v = _mm256_loadu_si256((const __m256i*)(block + i));
+        __m256i v_lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20)); // '[' -> '{', ']' -> '}'
+        q = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')));
+        b = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\')));
+        o = (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v_lower, _mm256_set1_epi8('{')),
+                _mm256_cmpeq_epi8(v_lower, _mm256_set1_epi8('}'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(':')),
+                _mm256_cmpeq_epi8(v, _mm256_set1_epi8(',')))));
+        s = (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')),
+                _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')))));
+#elif defined(UTLGBOT_SIMD_SSE2)
+        __m128i v = _mm_loadu_si128((const __m128i*)(block + i));
+        __m128i v_lower = _mm_or_si128(v, _mm_set1_epi8(0x20)); // '[' -> '{', ']' -> '}'
+        q = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')));
+        b = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\')));
+        o = (uint32_t)_mm_movemask_epi8(_mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v_lower, _mm_set1_epi8('{')),
+                _mm_cmpeq_epi8(v_lower, _mm_set1_epi8('}'))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(':')),
+                _mm_cmpeq_epi8(v, _mm_set1_epi8(',')))));
+        s = (uint32_t)_mm_movemask_epi8(_mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')),
+                _mm_cmpeq_epi8(v, _mm_set1_epi8('\r')))));
+#elif defined(UTLGBOT_SIMD_NEON)
+        uint8x16_t v = vld1q_u8((const uint8_t*)(block + i));
+        uint8x16_t v_lower = vorrq_u8(v, vdupq_n_u8(0x20)); // '[' -> '{', ']' -> '}'
+        q = json_simd_neon_movemask(vceqq_u8(v, vdupq_n_u8('"')));
+        b = json_simd_neon_movemask(vceqq_u8(v, vdupq_n_u8('\\')));
+        o = json_simd_neon_movemask(vorrq_u8(
+            vorrq_u8(vceqq_u8(v_lower, vdupq_n_u8('{')), vceqq_u8(v_lower, vdupq_n_u8('}'))),
+            vorrq_u8(vceqq_u8(v, vdupq_n_u8(':')), vceqq_u8(v, vdupq_n_u8(',')))));
+        s = json_simd_neon_movemask(vorrq_u8(
+            vorrq_u8(vceqq_u8(v, vdupq_n_u8(' ')), vceqq_u8(v, vdupq_n_u8('\t'))),
+            vorrq_u8(vceqq_u8(v, vdupq_n_u8('\n')), vceqq_u8(v, vdupq_n_u8('\r')))));
+#endif
+        *quotes = *quotes | (q << i);
+        *bslashes = *bslashes | (b << i);
+        *ops = *ops | (o << i);
+        *spaces = *spaces | (s << i);
+    }
+}
+
+// Get a mask with all the bits between each pair of set bits (from first bit of the pair, and
+// without the second one), i.e. the bytes inside strings from the quotes mask
+static inline uint64_t json_simd_prefix_xor(uint64_t x)
+{
+    x = x ^ (x << 1);
+    x = x ^ (x << 2);
+    x = x ^ (x << 4);
+    x = x ^ (x << 8);
+    x = x ^ (x << 16);
+    x = x ^ (x << 32);
+
+    return x;
+}
+
+// Get a new token (NULL if there is no more tokens available)
+static inline jsmntok_t* json_simd_new_token(jsmntok_t* tokens, const uint32_t num_tokens,
+    uint32_t* num_used_tokens, const jsmntype_t type, const int start)
+{
+    jsmntok_t* token;
+
+    if(*num_used_tokens >= num_tokens)
+        return NULL;
+    token = &tokens[*num_used_tokens];
+    *num_used_tokens = *num_used_tokens + 1;
+    token->type = type;
+    token->start = start;
+    token->end = -1;
+    token->size = 0;
+
+    return token;
+}
+
+// Tokenize a JSON string, return the number of tokens or a jsmn error code
+static int json_simd_parse(const char* json_str, const size_t json_str_len, jsmntok_t* tokens,
+    const uint32_t num_tokens)
+{
+    char tail[64];
+    const char* block;
+    uint32_t containers[JSON_SIMD_MAX_DEPTH];
+    uint32_t depth = 0;
+    uint32_t num_used_tokens = 0;
+    int32_t toksuper = -1;
+    int32_t str_start = -1;
+    jsmntok_t* primitive = NULL;
+    jsmntok_t* token;
+    uint64_t prev_in_string = 0;
+    uint64_t prev_escaped = 0;
+    uint64_t prev_scalar = 0;
+
+    for(size_t base = 0; base < json_str_len; base = base + 64)
+    {
+        uint64_t quotes, bslashes, ops, spaces, escaped, in_string, scalar, events, bit;
+
+        // Get the block (last one is completed with whitespaces)
+        block = json_str + base;
+        if(json_str_len - base < 64)
+        {
+            memset(tail, ' ', sizeof(tail));
+            memcpy(tail, block, json_str_len - base);
+            block = tail;
+        }
+        json_simd_classify(block, &quotes, &bslashes, &ops, &spaces);
+
+        // Get escaped characters (an escaped backslash doesn't escape next character)
+        escaped = prev_escaped;
+        prev_escaped = 0;
+        bslashes = bslashes & ~escaped;
+        while(bslashes != 0)
+        {
+            bit = bslashes & (~bslashes + 1);
+            if(bit == ((uint64_t)1 << 63))
+                prev_escaped = 1;
+            escaped = escaped | (bit << 1);
+            bslashes = bslashes & ~(bit | (bit << 1));
+        }
+        quotes = quotes & ~escaped;
+
+        // Get the strings content, primitives boundaries and the positions to process
+        in_string = json_simd_prefix_xor(quotes) ^ prev_in_string;
+        prev_in_string = (uint64_t)((int64_t)in_string >> 63);
+        scalar = ~(spaces | ops | quotes | in_string);
+        events = (ops & ~in_string) | quotes | (scalar ^ ((scalar << 1) | prev_scalar));
+        prev_scalar = scalar >> 63;
+
+        while(events != 0)
+        {
+            uint32_t pos = (uint32_t)(base + _ctz(events));
+            char c = block[_ctz(events)];
+            events = events & (events - 1);
+
+            // Close current primitive at first whitespace or operator
+            if(primitive != NULL)
+            {
+                primitive->end = pos;
+                primitive = NULL;
+                if((c == ' ') || (c == '\t') || (c == '\n') || (c == '\r'))
+                    continue;
+            }
+
+            // Handle strings quotes (there is no other event inside a string)
+            if(c == '"')
+            {
+                if(str_start == -1)
+                {
+                    str_start = pos;
+                    continue;
+                }
+                token = json_simd_new_token(tokens, num_tokens, &num_used_tokens, JSMN_STRING,
+                    str_start + 1);
+                if(token == NULL)
+                    return JSMN_ERROR_NOMEM;
+                token->end = pos;
+                if(toksuper != -1)
+                    tokens[toksuper].size = tokens[toksuper].size + 1;
+                str_start = -1;
+                continue;
+            }
+
+            switch(c)
+            {
+                case '{': case '[':
+                    if(depth == JSON_SIMD_MAX_DEPTH)
+                    {
+                        jsmn_parser json_parser;
+                        jsmn_init(&json_parser);
+                        return jsmn_parse(&json_parser, json_str, json_str_len, tokens,
+                            num_tokens);
+                    }
+                    token = json_simd_new_token(tokens, num_tokens, &num_used_tokens,
+                        (c == '{') ? JSMN_OBJECT : JSMN_ARRAY, pos);
+                    if(token == NULL)
+                        return JSMN_ERROR_NOMEM;
+                    if(toksuper != -1)
+                        tokens[toksuper].size = tokens[toksuper].size + 1;
+                    toksuper = num_used_tokens - 1;
+                    containers[depth] = toksuper;
+                    depth = depth + 1;
+                    break;
+
+                case '}': case ']':
+                    if(depth == 0)
+                        return JSMN_ERROR_INVAL;
+                    depth = depth - 1;
+                    token = &tokens[containers[depth]];
+                    if(token->type != ((c == '}') ? JSMN_OBJECT : JSMN_ARRAY))
+                        return JSMN_ERROR_INVAL;
+                    token->end = pos + 1;
+                    toksuper = (depth > 0) ? (int32_t)containers[depth-1] : -1;
+                    break;
+
+                case ':':
+                    toksuper = num_used_tokens - 1;
+                    break;
+
+                case ',':
+                    if((toksuper != -1) && (tokens[toksuper].type != JSMN_ARRAY) &&
+                        (tokens[toksuper].type != JSMN_OBJECT))
+                    {
+                        toksuper = (depth > 0) ? (int32_t)containers[depth-1] : -1;
+                    }
+                    break;
+
+                default:
+                    // Start of a primitive (number, true, false or null)
+                    primitive = json_simd_new_token(tokens, num_tokens, &num_used_tokens,
+                        JSMN_PRIMITIVE, pos);
+                    if(primitive == NULL)
+                        return JSMN_ERROR_NOMEM;
+                    if(toksuper != -1)
+                        tokens[toksuper].size = tokens[toksuper].size + 1;
+                    break;
+            }
+        }
+    }
+    if(primitive != NULL)
+        primitive->end = json_str_len;
+
+    // Check for unclosed strings, objects or arrays
+    if((str_start != -1) || (depth != 0))
+        return JSMN_ERROR_PART;
+
+    return num_used_tokens;
+}
+
+#endif
+
+/**************************************************************************************************/
+
 /* Constructor & Destructor */
 
+// Working memory arena constructor (the memory must be at least TLG_BOT_ARENA_SIZE(1) bytes)
+uTLGBotArena::uTLGBotArena(void* memory, const size_t size)
+{
+    _memory = (char*)memory;
+    _size = size;
+    _owner = NULL;
+}
+
 // TLGBot constructor, initialize and setup secure client with telegram cert and get the token
+// The bot gets its own working memory, allocated once here (on all devices, so bots of different
+// threads or tasks never share it unless they are given the same arena)
 uTLGBot::uTLGBot(const char* token, const bool dont_keep_connection)
 {
+    _own_arena._memory = (char*)malloc(TLG_BOT_ARENA_DEFAULT_SIZE);
+    if(_own_arena._memory != NULL)
+        _own_arena._size = TLG_BOT_ARENA_DEFAULT_SIZE;
+    init(token, &_own_arena, dont_keep_connection);
+}
+
+// TLGBot constructor that uses the provided working memory (that could be shared with other bots
+// of the same thread)
+uTLGBot::uTLGBot(const char* token, uTLGBotArena& arena, const bool dont_keep_connection)
+{
+    init(token, &arena, dont_keep_connection);
+}
+
+// TLGBot destructor
+uTLGBot::~uTLGBot(void)
+{
+    if((_arena != NULL) && (_arena->_owner == this))
+        _arena->_owner = NULL;
+#if defined(UTLGBOT_JSON_TOKENS_POOL_GROW)
+    if(_json_tokens_heap)
+    {
+        free(_json_elements);
+        free(_json_subtree_len);
+    }
+#endif
+    free(_own_arena._memory);
+#if defined(UTLGBOT_SPLIT_PATHS)
+    path_destroy(&_tx_path);
+    path_destroy(&_cb_path);
+#endif
+}
+
+// Initialize Bot data and split the working memory in the data buffers and the JSON tokens pool
+// Note: Working memory is not cleared, as it is always written before being read
+void uTLGBot::init(const char* token, uTLGBotArena* arena, const bool dont_keep_connection)
+{
+    size_t tokens_pos;
+
     snprintf(_token, TOKEN_LENGTH, "%s", token);
     snprintf(_tlg_api, TELEGRAM_API_LENGTH, "/bot%s", _token);
-    memset(_buffer, '\0', HTTP_MAX_RES_LENGTH);
-    memset(_json_value_str, '\0', MAX_JSON_STR_LEN);
-    memset(_json_subvalue_str, '\0', MAX_JSON_SUBVAL_STR_LEN);
-    memset(_json_elements, 0, (sizeof(jsmntok_t)*MAX_JSON_ELEMENTS));
-    memset(_json_subelements, 0, (sizeof(jsmntok_t)*MAX_JSON_SUBELEMENTS));
+    _arena = arena;
+    _buffer = NULL;
+    _tx_buffer = NULL;
+    _json_elements = NULL;
+    _json_subtree_len = NULL;
+    _json_elements_size = 0;
+#if defined(UTLGBOT_JSON_TOKENS_POOL_GROW)
+    _json_tokens_heap = false;
+#endif
+    if((_arena->_memory != NULL) && (_arena->_size >= TLG_BOT_ARENA_SIZE(1)))
+    {
+        tokens_pos = 2*HTTP_MAX_RES_LENGTH;
+        tokens_pos = tokens_pos + ((sizeof(uint64_t) -
+            (((uintptr_t)_arena->_memory + tokens_pos) % sizeof(uint64_t))) % sizeof(uint64_t));
+        _buffer = _arena->_memory;
+        _tx_buffer = _arena->_memory + HTTP_MAX_RES_LENGTH;
+        _json_elements_size = (_arena->_size - tokens_pos) / (sizeof(jsmntok_t)+sizeof(uint32_t));
+        _json_elements = (jsmntok_t*)(_arena->_memory + tokens_pos);
+        _json_subtree_len = (uint32_t*)(_json_elements + _json_elements_size);
+    }
+    else
+        _println("[Bot] Error: Not enough working memory.");
     _long_poll_timeout = DEFAULT_TELEGRAM_LONG_POLL_S;
     _last_received_msg = UINT64_MAX;
+    _updates_commit = UINT64_MAX;
+    _updates_limit = 1;
+    _update_len = 0;
+    _updates_truncated = false;
+    _sent_message_id = 0;
+    _rx_path.client = &_client;
+    _rx_path.buffer = _buffer;
+    _rx_path.aux_buffer = _tx_buffer;
+    _rx_path.result_pos = 0;
+    _rx_path.result_len = 0;
+    _rx_path.response_received = false;
+    #if defined(UTLGBOT_SPLIT_PATHS)
+        _tx_path.client = NULL;
+        _tx_path.buffer = NULL;
+        _tx_path.aux_buffer = NULL;
+        _tx_path.result_pos = 0;
+        _tx_path.result_len = 0;
+        _tx_path.response_received = false;
+        _cb_path.client = NULL;
+        _cb_path.buffer = NULL;
+        _cb_path.aux_buffer = NULL;
+        _cb_path.result_pos = 0;
+        _cb_path.result_len = 0;
+        _cb_path.response_received = false;
+        _tls_mem_pool = NULL;
+    #endif
+    #if defined(UTLGBOT_TIMING)
+        memset(&_rx_path.timing_last, 0, sizeof(_rx_path.timing_last));
+        memset(&_rx_path.timing_total, 0, sizeof(_rx_path.timing_total));
+        #if defined(UTLGBOT_SPLIT_PATHS)
+            memset(&_tx_path.timing_last, 0, sizeof(_tx_path.timing_last));
+            memset(&_tx_path.timing_total, 0, sizeof(_tx_path.timing_total));
+            memset(&_cb_path.timing_last, 0, sizeof(_cb_path.timing_last));
+            memset(&_cb_path.timing_total, 0, sizeof(_cb_path.timing_total));
+        #endif
+    #endif
+    #if defined(UTLGBOT_COROUTINES)
+        _reactor = NULL;
+        _reactor_entry = 0;
+        _co_updates_head = NULL;
+        _co_updates_tail = NULL;
+        for(uint32_t i = 0; i < COROUTINES_CHAT_BUCKETS; i++)
+            _co_chats[i] = NULL;
+        _co_sends_head = NULL;
+        _co_sends_tail = NULL;
+        _co_sending = false;
+        _co_sends_running = false;
+    #endif
     _dont_keep_connection = dont_keep_connection;
     _debug_level = 0;
     _tlg_api_ca_pem_start = NULL;
     _tlg_api_ca_pem_end = NULL;
-
-    // Clear message data
-    clear_msg_data();
+    _num_callback_query_handlers = 0;
+    _callback_query_answered = false;
+    _lazy_decode = false;
+    _msg_json_str = NULL;
+    memset(_msg_field_tokens, 0, sizeof(_msg_field_tokens));
+    _msg_pending_fields = 0;
+    _msg_spans_valid = false;
+
+    // Clear message data (all fields, as there is no previous message)
+    memset(&received_msg, 0, sizeof(received_msg));
+    clear_callback_query_data();
 }
 
-// TLGBot destructor
-uTLGBot::~uTLGBot(void)
-{}
-
 /**************************************************************************************************/
 
 /* Public Methods */
@@ -99,7 +883,15 @@ void uTLGBot::set_debug(const uint8_t debug_level)
 {
     _debug_level = debug_level;
     if(_debug_level > 1)
+    {
         _client.set_debug(true);
+        #if defined(UTLGBOT_SPLIT_PATHS)
+            if(_tx_path.client != NULL)
+                _tx_path.client->set_debug(true);
+            if(_cb_path.client != NULL)
+                _cb_path.client->set_debug(true);
+        #endif
+    }
 }
 
 // Set/Modify actual Bot Token
@@ -117,6 +909,12 @@ void uTLGBot::set_cert(const uint8_t* ca_pem_start, const uint8_t* ca_pem_end)
     _tlg_api_ca_pem_end = ca_pem_end;
 
     _client.set_cert(_tlg_api_ca_pem_start, _tlg_api_ca_pem_end);
+    #if defined(UTLGBOT_SPLIT_PATHS)
+        if(_tx_path.client != NULL)
+            _tx_path.client->set_cert(_tlg_api_ca_pem_start, _tlg_api_ca_pem_end);
+        if(_cb_path.client != NULL)
+            _cb_path.client->set_cert(_tlg_api_ca_pem_start, _tlg_api_ca_pem_end);
+    #endif
 }
 
 // Set/Modify Telegram Server Certificate
@@ -127,6 +925,29 @@ void uTLGBot::set_cert(const char* cert_https_server)
     #endif
 }
 
+#if !defined(ARDUINO) && !defined(ESP_IDF)
+// Set a memory pool for the TLS client allocations instead of the system heap (Generic devices,
+// and mbedtls built with MBEDTLS_PLATFORM_MEMORY), i.e. one pool shared by many bots. Both the
+// receive, send and callback answers paths connections use it (if paths are split, now or later)
+bool uTLGBot::set_tls_mem_pool(MultiHTTPSClientMemPool* mem_pool)
+{
+    #if defined(UTLGBOT_SPLIT_PATHS)
+        SEND_PATH_LOCK();
+        if((_tx_path.client != NULL) && !_tx_path.client->set_mem_pool(mem_pool))
+            return false;
+        if(_cb_path.client != NULL)
+        {
+            CB_PATH_LOCK();
+            if(!_cb_path.client->set_mem_pool(mem_pool))
+                return false;
+        }
+        _tls_mem_pool = mem_pool;
+    #endif
+
+    return _client.set_mem_pool(mem_pool);
+}
+#endif
+
 // Set/Modify Telegram getUpdates polling request timeout
 void uTLGBot::set_polling_timeout(const uint8_t seconds)
 {
@@ -135,6 +956,135 @@ void uTLGBot::set_polling_timeout(const uint8_t seconds)
         _long_poll_timeout);
 }
 
+// Enable/Disable lazy decode of received messages (fields are decoded on first access through
+// the get_msg_*() methods instead of all of them in getUpdates(), so received_msg must not be
+// read directly)
+// Note: Any field not accessed yet is decoded before the next Bot request, as it reuses the
+// received data buffer, except for getUpdates() that replaces the message (so the last message
+// is not available anymore after a getUpdates() that doesn't receive a new one)
+void uTLGBot::set_lazy_decode(const bool lazy_decode)
+{
+    msg_decode_pending();
+    _lazy_decode = lazy_decode;
+}
+
+#if defined(UTLGBOT_SPLIT_PATHS)
+// Split the send requests (sendMessage, editMessage*, broadcast, answerCallbackQuery and getMe)
+// from the receive path, with their own server connection and data buffers, so they can be made
+// from any thread (serialized between them) while the getUpdates thread handles the received
+// data, which is not released by them anymore. Callback answers get a third path, so they are not
+// delayed by the other send requests (i.e. a broadcast holds the send path until it ends, while
+// the user waits for the button "loading" state to stop)
+// Note: Without split paths (default) a Bot must be used from a single thread, and after split
+// them getUpdates and the received data must still be used just from one thread
+bool uTLGBot::split_paths(void)
+{
+    SEND_PATH_LOCK();
+    if(_tx_path.client != NULL)
+        return true;
+
+    // Send path is the last one, as it tells that paths are split
+    if(!path_create(&_cb_path, false) || !path_create(&_tx_path, true))
+    {
+        _println("[Bot] Error: Not enough memory for the send paths.");
+        return false;
+    }
+
+    _println("[Bot] Send requests path split.");
+    return true;
+}
+
+// Create the server connection and data buffer (and the auxiliary one if requested) of a split
+// path (nothing is done if it was already created)
+bool uTLGBot::path_create(tlg_req_path* path, const bool aux_buffer)
+{
+    if(path->client != NULL)
+        return true;
+
+    path->buffer = (char*)malloc((aux_buffer ? 2 : 1)*HTTP_MAX_RES_LENGTH);
+    if(path->buffer == NULL)
+        return false;
+    path->aux_buffer = aux_buffer ? (path->buffer + HTTP_MAX_RES_LENGTH) : NULL;
+    path->result_pos = 0;
+    path->response_received = false;
+    path->result_len = 0;
+    path->client = new MultiHTTPSClient();
+    if(_tls_mem_pool != NULL)
+        path->client->set_mem_pool(_tls_mem_pool);
+    if(_tlg_api_ca_pem_start != NULL)
+        path->client->set_cert(_tlg_api_ca_pem_start, _tlg_api_ca_pem_end);
+    if(_debug_level > 1)
+        path->client->set_debug(true);
+
+    return true;
+}
+
+// Release the server connection and data buffers of a split path
+void uTLGBot::path_destroy(tlg_req_path* path)
+{
+    if(path->client == NULL)
+        return;
+
+    path->client->disconnect();
+    delete path->client;
+    free(path->buffer);
+    path->client = NULL;
+    path->buffer = NULL;
+    path->aux_buffer = NULL;
+}
+#endif
+
+#if defined(UTLGBOT_TIMING)
+// Get the phases times of the last request and the total times of all the requests made by the
+// receive path (getUpdates, and any other request if paths are not split) or by the send path
+// Note: Receive path times must be got from the thread that makes its requests
+// Return false if the HTTPS client was built without timing (just check times are taken)
+bool uTLGBot::get_timing(tlg_req_timing* last, tlg_req_timing* total, const bool tx_path)
+{
+    tlg_req_path* path = &_rx_path;
+
+    SEND_PATH_LOCK();
+    #if defined(UTLGBOT_SPLIT_PATHS)
+        if(tx_path && (_tx_path.client != NULL))
+            path = &_tx_path;
+    #else
+        (void)tx_path;
+    #endif
+
+    if(last != NULL)
+        *last = path->timing_last;
+    if(total != NULL)
+        *total = path->timing_total;
+
+    return path->client->get_timing((last != NULL) ? &last->http : NULL,
+        (total != NULL) ? &total->http : NULL);
+}
+
+// Reset the last request and total times of both paths
+void uTLGBot::reset_timing(void)
+{
+    SEND_PATH_LOCK();
+    memset(&_rx_path.timing_last, 0, sizeof(_rx_path.timing_last));
+    memset(&_rx_path.timing_total, 0, sizeof(_rx_path.timing_total));
+    _rx_path.client->reset_timing();
+    #if defined(UTLGBOT_SPLIT_PATHS)
+        if(_tx_path.client != NULL)
+        {
+            memset(&_tx_path.timing_last, 0, sizeof(_tx_path.timing_last));
+            memset(&_tx_path.timing_total, 0, sizeof(_tx_path.timing_total));
+            _tx_path.client->reset_timing();
+        }
+        if(_cb_path.client != NULL)
+        {
+            CB_PATH_LOCK();
+            memset(&_cb_path.timing_last, 0, sizeof(_cb_path.timing_last));
+            memset(&_cb_path.timing_total, 0, sizeof(_cb_path.timing_total));
+            _cb_path.client->reset_timing();
+        }
+    #endif
+}
+#endif
+
 // Get actual configured Bot Token
 char* uTLGBot::get_token(void)
 {
@@ -147,26 +1097,118 @@ uint8_t uTLGBot::get_polling_timeout(void)
     return _long_poll_timeout;
 }
 
+// Get the message ID of last successfully sent message (0 if none)
+int64_t uTLGBot::get_sent_message_id(void)
+{
+    return _sent_message_id;
+}
+
+// Get the message ID of last received message
+int64_t uTLGBot::get_msg_id(void)
+{
+    msg_decode_fields(TLG_MSG_HAS_MESSAGE_ID);
+    return received_msg.message_id;
+}
+
+// Get the date of last received message
+uint32_t uTLGBot::get_msg_date(void)
+{
+    msg_decode_fields(TLG_MSG_HAS_DATE);
+    return received_msg.date;
+}
+
+// Get the text of last received message
+const char* uTLGBot::get_msg_text(void)
+{
+    msg_decode_fields(TLG_MSG_HAS_TEXT);
+    return received_msg.text;
+}
+
+// Get the chat ID of last received message (without decoding the other chat fields)
+int64_t uTLGBot::get_msg_chat_id(void)
+{
+    msg_decode_fields(TLG_MSG_CHAT_ID_ONLY);
+    return received_msg.chat.id;
+}
+
+// Get the sender user of last received message
+const tlg_type_user& uTLGBot::get_msg_from(void)
+{
+    msg_decode_fields(TLG_MSG_HAS_FROM);
+    return received_msg.from;
+}
+
+// Get the chat of last received message
+const tlg_type_chat& uTLGBot::get_msg_chat(void)
+{
+    msg_decode_fields(TLG_MSG_HAS_CHAT);
+    return received_msg.chat;
+}
+
+// Get the document of last received message (cleared if the message has no document)
+const tlg_type_document& uTLGBot::get_msg_document(void)
+{
+    msg_decode_fields(TLG_MSG_HAS_DOCUMENT);
+    return received_msg.document;
+}
+
+// Get the last received message, decoding the given fields (TLG_MSG_HAS_* bits) if they were not
+// decoded yet (the other fields could be still undecoded in lazy decode mode)
+const tlg_type_message& uTLGBot::get_msg(const uint32_t fields)
+{
+    msg_decode_fields(fields);
+    return received_msg;
+}
+
+// Get the string of a received message span (i.e. received_msg.document.file_id) unescaped into
+// the provided buffer (truncated if it doesn't fit)
+// Return false if the span is empty, or it is not valid anymore (after any other Bot request)
+bool uTLGBot::get_msg_str(const tlg_str_span& span, char* dest, const size_t dest_size)
+{
+    if(dest_size == 0)
+        return false;
+    dest[0] = '\0';
+
+    if(!_msg_spans_valid || (span.len == 0) || ((size_t)span.pos+span.len > HTTP_MAX_RES_LENGTH))
+        return false;
+    json_unescape_str(_buffer + span.pos, span.len, dest, dest_size);
+
+    return true;
+}
+
 // Connect to Telegram server
 uint8_t uTLGBot::connect(void)
+{
+    return path_connect(&_rx_path);
+}
+
+// Disconnect from Telegram server
+void uTLGBot::disconnect(void)
+{
+    path_disconnect(&_rx_path);
+}
+
+// Connect a requests path to Telegram server
+uint8_t uTLGBot::path_connect(tlg_req_path* path)
 {
     _println("[Bot] Connecting to telegram server...");
 
-    if(is_connected())
+    if(path->client->is_connected())
     {
         _println("[Bot] Already connected to server.");
         return true;
     }
 
-    int8_t conn_res = _client.connect(TELEGRAM_HOST, HTTPS_PORT);
+    int8_t conn_res = path->client->connect(TELEGRAM_HOST, HTTPS_PORT);
     if(conn_res == -1)
     {
         // Force disconnect if connection result is -1 (Unexpected Server certificate)
-        disconnect();
+        path_disconnect(path);
     }
     if(conn_res != 1)
     {
         _println("[Bot] Conection fail.");
+        REQ_TIMING_ADD(path, 0, false);
         return false;
     }
 
@@ -175,17 +1217,17 @@ uint8_t uTLGBot::connect(void)
     return true;
 }
 
-// Disconnect from Telegram server
-void uTLGBot::disconnect(void)
+// Disconnect a requests path from Telegram server
+void uTLGBot::path_disconnect(tlg_req_path* path)
 {
     _println("[Bot] Disconnecting from telegram server...");
 
-    if(!is_connected())
+    if(!path->client->is_connected())
     {
         _println("[Bot] Already disconnected from server.");
         return;
     }
-    _client.disconnect();
+    path->client->disconnect();
 
     _println("[Bot] Successfully disconnected.");
 }
@@ -199,21 +1241,25 @@ bool uTLGBot::is_connected(void)
 // Request Bot info by sending getMe command
 uint8_t uTLGBot::getMe(void)
 {
+    tlg_req_path* path;
     uint8_t request_result;
-    bool connected;
+
+    // Get the send requests path and its working memory
+    SEND_PATH_LOCK();
+    path = send_path();
+    if(path == NULL)
+        return 0;
 
     // Connect to telegram server
-    connected = is_connected();
-    if(!connected)
+    if(!path->client->is_connected())
     {
-        connected = connect();
-        if(!connected)
+        if(!path_connect(path))
             return false;
     }
 
     // Send the request
     _println("[Bot] Trying to send getMe request...");
-    request_result = tlg_get(API_CMD_GET_ME, _buffer, HTTP_MAX_RES_LENGTH);
+    request_result = tlg_get(path, API_CMD_GET_ME, path->buffer, HTTP_MAX_RES_LENGTH);
 
     // Check if request has fail
     if(request_result == 0)
@@ -221,20 +1267,19 @@ uint8_t uTLGBot::getMe(void)
         _println("[Bot] Command fail, no response received.");
 
         // Disconnect from telegram server
-        if(is_connected())
-            disconnect();
+        if(path->client->is_connected())
+            path_disconnect(path);
 
         return false;
     }
 
     // Parse and check response
     _println("\n[Bot] Response received:");
-    _println(_buffer);
-    _println(" ");
+    _printf("%.*s\n\n", (int)path->result_len, path->buffer+path->result_pos);
 
     // Disconnect from telegram server
-    if(_dont_keep_connection && is_connected())
-        disconnect();
+    if(_dont_keep_connection && path->client->is_connected())
+        path_disconnect(path);
 
     return true;
 }
@@ -243,8 +1288,16 @@ uint8_t uTLGBot::getMe(void)
 uint8_t uTLGBot::sendReplyKeyboardMarkup(const char* chat_id, const char* text,
     const char* keyboard)
 {
-    snprintf(json_keyboard, MAX_KEYBOARD_MARKUP_LENGTH, "{\"keyboard\":%s}", keyboard);
-    return sendMessage(chat_id, text, "", false, false, 0, json_keyboard);
+    tlg_req_path* path;
+
+    // Note: Request body auxiliar buffer is free while sending a message, so use it for the
+    // reply_markup
+    SEND_PATH_LOCK();
+    path = send_path();
+    if(path == NULL)
+        return 0;
+    snprintf(path->aux_buffer, HTTP_MAX_RES_LENGTH, "{\"keyboard\":%s}", keyboard);
+    return sendMessage(chat_id, text, "", false, false, 0, path->aux_buffer);
 }
 
 // Request Bot send text message to specified chat ID (The Bot should be in that Chat)
@@ -252,94 +1305,206 @@ uint8_t uTLGBot::sendMessage(const char* chat_id, const char* text, const char*
     bool disable_web_page_preview, bool disable_notification, uint64_t reply_to_message_id,
     const char* reply_markup)
 {
-    // Note: Due to undefined behavior if use same source and target in snprintf(), we need to
-    // use a temporary copy array (dont trust strncat)
-    char tmp[MAX_TMP_BUFFER_LENGTH];
+    char chat_id_value[MAX_TMP_BUFFER_LENGTH];
+    tlg_req_path* path;
     uint8_t request_result;
-    bool connected;
+
+    // Get the send requests path and its working memory
+    SEND_PATH_LOCK();
+    path = send_path();
+    if(path == NULL)
+        return 0;
 
     // Connect to telegram server
-    connected = is_connected();
-    if(!connected)
+    if(!path->client->is_connected())
     {
-        connected = connect();
-        if(!connected)
+        if(!path_connect(path))
             return false;
     }
 
+    _sent_message_id = 0;
+
     // Create HTTP Body request data
-    snprintf(_buffer, HTTP_MAX_RES_LENGTH, "{\"chat_id\":%s, \"text\":\"%s\"}",
-        chat_id, text);
-    // If parse_mode is not empty
-    if(parse_mode[0] != '\0')
+    if(!json_chat_id(chat_id, chat_id_value, sizeof(chat_id_value)))
     {
-        // If parse mode has an expected value
-        if((strcmp(parse_mode, "Markdown") == 0) || (strcmp(parse_mode, "HTML") == 0))
-        {
-            // Remove last brace and append the new field
-            _buffer[strlen(_buffer)-1] = '\0';
-            snprintf(tmp, MAX_TMP_BUFFER_LENGTH, ",\"parse_mode\":%s\"}", parse_mode);
-            if(!cstr_strncat(_buffer, HTTP_MAX_RES_LENGTH, tmp, strlen(tmp)))
-            {
-                cant_create_send_msg(_buffer);
-                return false;
-            }
-        }
-        else
-            _println("[Bot] Warning: Invalid parse_mode provided.");
+        cant_create_send_msg(path, chat_id);
+        return false;
     }
-    // Remove last brace and append disable_web_page_preview value if true
-    if(disable_web_page_preview)
+    snprintf(path->buffer, HTTP_MAX_RES_LENGTH, "{\"chat_id\":%s", chat_id_value);
+    if(!create_msg_body_fields(path->buffer, HTTP_MAX_RES_LENGTH, text, parse_mode,
+        disable_web_page_preview, disable_notification, reply_to_message_id, reply_markup))
     {
-        _buffer[strlen(_buffer)-1] = '\0';
-        if(!cstr_strncat(_buffer, HTTP_MAX_RES_LENGTH, ",\"disable_web_page_preview\":true}",
-            strlen(",\"disable_web_page_preview\":true}")))
-        {
-            cant_create_send_msg(_buffer);
-            return false;
-        }
+        cant_create_send_msg(path, path->buffer);
+        return false;
     }
-    // Remove last brace and append disable_notification value if true
-    if(disable_notification)
+
+    // Send the request
+    _println("[Bot] Trying to send message request...");
+    _println("Mesage to send:");
+    _println(path->buffer);
+    _println("");
+    request_result = tlg_post(path, API_CMD_SEND_MSG, path->buffer, strlen(path->buffer),
+        HTTP_MAX_RES_LENGTH);
+
+    // Check if request has fail
+    if(request_result == false)
     {
-        _buffer[strlen(_buffer)-1] = '\0';
-        if(!cstr_strncat(_buffer, HTTP_MAX_RES_LENGTH, ",\"disable_notification\":true}",
-            strlen(",\"disable_notification\":true}")))
-        {
-            cant_create_send_msg(_buffer);
+        _println("[Bot] Command fail, no response received.");
+
+        // Disconnect from telegram server
+        if(path->client->is_connected())
+            path_disconnect(path);
+
+        return false;
+    }
+
+    // Parse and check response
+    _println("\n[Bot] Response received:");
+    _printf("%.*s\n\n", (int)path->result_len, path->buffer+path->result_pos);
+    parse_sent_message_id(path);
+
+    // Disconnect from telegram server
+    if(_dont_keep_connection && path->client->is_connected())
+        path_disconnect(path);
+
+    return true;
+}
+
+// Request Bot send text message to specified chat ID (numeric ID, i.e. received_msg.chat.id)
+uint8_t uTLGBot::sendMessage(const int64_t chat_id, const char* text, const char* parse_mode,
+    bool disable_web_page_preview, bool disable_notification, uint64_t reply_to_message_id,
+    const char* reply_markup)
+{
+    char id[MAX_ID_LENGTH];
+
+    cstr_from_int64(chat_id, id);
+    return sendMessage(id, text, parse_mode, disable_web_page_preview, disable_notification,
+        reply_to_message_id, reply_markup);
+}
+
+// Request Bot edit the text (and optionally the inline keyboard) of a sent message
+uint8_t uTLGBot::editMessageText(const char* chat_id, const int64_t message_id, const char* text,
+    const char* parse_mode, bool disable_web_page_preview, const char* reply_markup)
+{
+    char chat_id_value[MAX_TMP_BUFFER_LENGTH];
+    tlg_req_path* path;
+    uint8_t request_result;
+
+    // Get the send requests path and its working memory
+    SEND_PATH_LOCK();
+    path = send_path();
+    if(path == NULL)
+        return 0;
+
+    // Connect to telegram server
+    if(!path->client->is_connected())
+    {
+        if(!path_connect(path))
             return false;
-        }
     }
-    // Remove last brace and append reply_to_message_id value if set
-    if(reply_to_message_id != 0)
+
+    // Create HTTP Body request data
+    if(!json_chat_id(chat_id, chat_id_value, sizeof(chat_id_value)))
     {
-        _buffer[strlen(_buffer)-1] = '\0';
-        snprintf(tmp, MAX_TMP_BUFFER_LENGTH, ",\"reply_to_message_id\":%" PRIu64 "}",
-            reply_to_message_id);
-        if(!cstr_strncat(_buffer, HTTP_MAX_RES_LENGTH, tmp, strlen(tmp)))
-        {
-            cant_create_send_msg(_buffer);
+        cant_create_send_msg(path, chat_id);
+        return false;
+    }
+    snprintf(path->buffer, HTTP_MAX_RES_LENGTH, "{\"chat_id\":%s,\"message_id\":%" PRId64,
+        chat_id_value, message_id);
+    if(!create_msg_body_fields(path->buffer, HTTP_MAX_RES_LENGTH, text, parse_mode,
+        disable_web_page_preview, false, 0, reply_markup))
+    {
+        cant_create_send_msg(path, path->buffer);
+        return false;
+    }
+
+    // Send the request
+    _println("[Bot] Trying to send editMessageText request...");
+    _println(path->buffer);
+    request_result = tlg_post(path, API_CMD_EDIT_MSG_TEXT, path->buffer, strlen(path->buffer),
+        HTTP_MAX_RES_LENGTH);
+
+    // Check if request has fail
+    if(request_result == false)
+    {
+        _println("[Bot] Command fail, no response received.");
+
+        // Disconnect from telegram server
+        if(path->client->is_connected())
+            path_disconnect(path);
+
+        return false;
+    }
+
+    // Disconnect from telegram server
+    if(_dont_keep_connection && path->client->is_connected())
+        path_disconnect(path);
+
+    return true;
+}
+
+// Request Bot edit the text of a sent message (numeric chat ID)
+uint8_t uTLGBot::editMessageText(const int64_t chat_id, const int64_t message_id,
+    const char* text, const char* parse_mode, bool disable_web_page_preview,
+    const char* reply_markup)
+{
+    char id[MAX_ID_LENGTH];
+
+    cstr_from_int64(chat_id, id);
+    return editMessageText(id, message_id, text, parse_mode, disable_web_page_preview,
+        reply_markup);
+}
+
+// Request Bot edit the inline keyboard of a sent message (an empty reply_markup remove it)
+uint8_t uTLGBot::editMessageReplyMarkup(const char* chat_id, const int64_t message_id,
+    const char* reply_markup)
+{
+    char chat_id_value[MAX_TMP_BUFFER_LENGTH];
+    tlg_req_path* path;
+    uint8_t request_result;
+
+    // Get the send requests path and its working memory
+    SEND_PATH_LOCK();
+    path = send_path();
+    if(path == NULL)
+        return 0;
+
+    // Connect to telegram server
+    if(!path->client->is_connected())
+    {
+        if(!path_connect(path))
             return false;
-        }
     }
-    // Remove last brace and append reply_markup if it is not empty
+
+    // Create HTTP Body request data
+    if(!json_chat_id(chat_id, chat_id_value, sizeof(chat_id_value)))
+    {
+        cant_create_send_msg(path, chat_id);
+        return false;
+    }
+    snprintf(path->buffer, HTTP_MAX_RES_LENGTH, "{\"chat_id\":%s,\"message_id\":%" PRId64,
+        chat_id_value, message_id);
     if(reply_markup[0] != '\0')
     {
-        _buffer[strlen(_buffer)-1] = '\0';
-        snprintf(tmp, MAX_TMP_BUFFER_LENGTH, ",\"reply_markup\":%s}", reply_markup);
-        if(!cstr_strncat(_buffer, HTTP_MAX_RES_LENGTH, tmp, strlen(tmp)))
+        if(!cstr_strncat(path->buffer, HTTP_MAX_RES_LENGTH, ",\"reply_markup\":",
+            strlen(",\"reply_markup\":")) ||
+            !cstr_strncat(path->buffer, HTTP_MAX_RES_LENGTH, reply_markup, strlen(reply_markup)))
         {
-            cant_create_send_msg(_buffer);
+            cant_create_send_msg(path, path->buffer);
             return false;
         }
     }
+    if(!cstr_strncat(path->buffer, HTTP_MAX_RES_LENGTH, "}", strlen("}")))
+    {
+        cant_create_send_msg(path, path->buffer);
+        return false;
+    }
 
     // Send the request
-    _println("[Bot] Trying to send message request...");
-    _println("Mesage to send:");
-    _println(_buffer);
-    _println("");
-    request_result = tlg_post(API_CMD_SEND_MSG, _buffer, strlen(_buffer), HTTP_MAX_RES_LENGTH);
+    _println("[Bot] Trying to send editMessageReplyMarkup request...");
+    _println(path->buffer);
+    request_result = tlg_post(path, API_CMD_EDIT_MSG_REPLY_MARKUP, path->buffer,
+        strlen(path->buffer), HTTP_MAX_RES_LENGTH);
 
     // Check if request has fail
     if(request_result == false)
@@ -347,30 +1512,213 @@ uint8_t uTLGBot::sendMessage(const char* chat_id, const char* text, const char*
         _println("[Bot] Command fail, no response received.");
 
         // Disconnect from telegram server
-        if(is_connected())
-            disconnect();
+        if(path->client->is_connected())
+            path_disconnect(path);
 
         return false;
     }
 
-    // Parse and check response
-    _println("\n[Bot] Response received:");
-    _println(_buffer);
-    _println(" ");
-
     // Disconnect from telegram server
-    if(_dont_keep_connection && is_connected())
-        disconnect();
+    if(_dont_keep_connection && path->client->is_connected())
+        path_disconnect(path);
 
     return true;
 }
 
+// Request Bot edit the inline keyboard of a sent message (numeric chat ID)
+uint8_t uTLGBot::editMessageReplyMarkup(const int64_t chat_id, const int64_t message_id,
+    const char* reply_markup)
+{
+    char id[MAX_ID_LENGTH];
+
+    cstr_from_int64(chat_id, id);
+    return editMessageReplyMarkup(id, message_id, reply_markup);
+}
+
+// Request Bot send the same text message to a list of chats
+// The request body is created just once, and for each recipient just the chat_id and the
+// Content-Length are changed. Messages are sent through the same (keep-alive) connection and
+// paced by the global and per-chat rate limits. Return the number of successfully sent messages
+uint32_t uTLGBot::broadcast(const char* const* chat_ids, const uint32_t num_chat_ids,
+    const char* text, const tlg_broadcast_options* options, tlg_broadcast_report* report)
+{
+    return broadcast_chats(chat_ids, NULL, num_chat_ids, text, options, report);
+}
+
+// Request Bot send the same text message to a list of chats (numeric chat IDs)
+uint32_t uTLGBot::broadcast(const int64_t* chat_ids, const uint32_t num_chat_ids,
+    const char* text, const tlg_broadcast_options* options, tlg_broadcast_report* report)
+{
+    return broadcast_chats(NULL, chat_ids, num_chat_ids, text, options, report);
+}
+
+// Send the same text message to a list of chats, given as strings (str_chat_ids) or as numeric
+// IDs (int_chat_ids)
+uint32_t uTLGBot::broadcast_chats(const char* const* str_chat_ids, const int64_t* int_chat_ids,
+    const uint32_t num_chat_ids, const char* text, const tlg_broadcast_options* options,
+    tlg_broadcast_report* report)
+{
+    tlg_req_path* path;
+    static const char* body_head = "{\"chat_id\":";
+    char chat_id[MAX_TMP_BUFFER_LENGTH];
+    uint32_t recent_chats[BROADCAST_RECENT_CHATS];
+    unsigned long recent_chats_t[BROADCAST_RECENT_CHATS];
+    const char* body_parts[3];
+    size_t body_parts_len[3];
+    tlg_broadcast_options opt;
+    unsigned long t0, t_last_send, send_interval_ms, t;
+    uint32_t num_recent_chats = 0;
+    uint32_t sent = 0;
+    uint32_t failed = 0;
+    uint8_t result;
+
+    // Get the send requests path and its working memory
+    SEND_PATH_LOCK();
+    path = send_path();
+    if(path == NULL)
+        return 0;
+
+    // Use default options if not provided
+    if(options != NULL)
+        opt = *options;
+    else
+    {
+        opt.parse_mode = "";
+        opt.disable_web_page_preview = false;
+        opt.disable_notification = false;
+        opt.reply_markup = "";
+        opt.max_msgs_per_second = DEFAULT_BROADCAST_MAX_MSGS_PER_SECOND;
+        opt.chat_min_interval_ms = DEFAULT_BROADCAST_CHAT_MIN_INTERVAL_MS;
+    }
+    if(opt.parse_mode == NULL)
+        opt.parse_mode = "";
+    if(opt.reply_markup == NULL)
+        opt.reply_markup = "";
+    if(opt.max_msgs_per_second == 0)
+        opt.max_msgs_per_second = DEFAULT_BROADCAST_MAX_MSGS_PER_SECOND;
+    send_interval_ms = 1000 / opt.max_msgs_per_second;
+
+    // Initialize results
+    if(report != NULL)
+    {
+        report->sent = 0;
+        report->failed = 0;
+        report->elapsed_ms = 0;
+        report->msgs_per_second = 0;
+        if(report->results != NULL)
+            memset(report->results, BROADCAST_RESULT_PENDING, num_chat_ids);
+    }
+
+    // Create the invariant part of HTTP Body request data (all fields but chat_id)
+    path->aux_buffer[0] = '\0';
+    if(!create_msg_body_fields(path->aux_buffer, HTTP_MAX_RES_LENGTH, text, opt.parse_mode,
+        opt.disable_web_page_preview, opt.disable_notification, 0, opt.reply_markup))
+    {
+        cant_create_send_msg(path, path->aux_buffer);
+        return 0;
+    }
+    body_parts[0] = body_head;
+    body_parts_len[0] = strlen(body_head);
+    body_parts[2] = path->aux_buffer;
+    body_parts_len[2] = strlen(path->aux_buffer);
+
+    _printf("[Bot] Broadcasting message to %" PRIu32 " chats...\n", num_chat_ids);
+    t0 = _millis();
+    t_last_send = t0 - send_interval_ms;
+    for(uint32_t i = 0; i < num_chat_ids; i++)
+    {
+        // Global rate limit
+        t = _millis();
+        if(t - t_last_send < send_interval_ms)
+            _delay(send_interval_ms - (t - t_last_send));
+
+        // Per chat rate limit (the same chat was in the list a short time ago)
+        for(uint32_t n = 0; n < num_recent_chats; n++)
+        {
+            if((str_chat_ids != NULL) ?
+                (strcmp(str_chat_ids[recent_chats[n]], str_chat_ids[i]) != 0) :
+                (int_chat_ids[recent_chats[n]] != int_chat_ids[i]))
+            {
+                continue;
+            }
+            t = _millis();
+            if(t - recent_chats_t[n] < opt.chat_min_interval_ms)
+                _delay(opt.chat_min_interval_ms - (t - recent_chats_t[n]));
+        }
+
+        // Connect to telegram server (first time or it was lost by a previous fail)
+        result = BROADCAST_RESULT_FAIL;
+        if(str_chat_ids == NULL)
+            cstr_from_int64(int_chat_ids[i], chat_id);
+        if((str_chat_ids != NULL) && !json_chat_id(str_chat_ids[i], chat_id, sizeof(chat_id)))
+            _printf("[Bot] Broadcast to chat %s fail (invalid chat ID).\n", str_chat_ids[i]);
+        else if(path->client->is_connected() || path_connect(path))
+        {
+            // Send the request just changing the chat_id
+            body_parts[1] = chat_id;
+            body_parts_len[1] = strlen(chat_id);
+            t_last_send = _millis();
+            if(tlg_post_parts(path, API_CMD_SEND_MSG, body_parts, body_parts_len, 3, path->buffer,
+                HTTP_MAX_RES_LENGTH))
+            {
+                result = BROADCAST_RESULT_SENT;
+            }
+            else
+            {
+                _printf("[Bot] Broadcast to chat %s fail.\n", chat_id);
+
+                // Force a new connection for next recipient if the request fail (not if it was
+                // rejected by the API, i.e. chat not found or bot blocked by the user)
+                if(!path->response_received && path->client->is_connected())
+                    path_disconnect(path);
+            }
+        }
+        if(result == BROADCAST_RESULT_SENT)
+            sent = sent + 1;
+        else
+            failed = failed + 1;
+        if((report != NULL) && (report->results != NULL))
+            report->results[i] = result;
+
+        // Keep sent chat in recent chats list (circular)
+        recent_chats[i % BROADCAST_RECENT_CHATS] = i;
+        recent_chats_t[i % BROADCAST_RECENT_CHATS] = t_last_send;
+        if(num_recent_chats < BROADCAST_RECENT_CHATS)
+            num_recent_chats = num_recent_chats + 1;
+
+        _yield();
+    }
+
+    // Get stats
+    t = _millis() - t0;
+    _printf("[Bot] Broadcast done, %" PRIu32 " sent and %" PRIu32 " fail in %lu ms.\n",
+        sent, failed, t);
+    if(report != NULL)
+    {
+        report->sent = sent;
+        report->failed = failed;
+        report->elapsed_ms = t;
+        if(t > 0)
+            report->msgs_per_second = (float)(sent * 1000.0 / t);
+    }
+
+    // Disconnect from telegram server
+    if(_dont_keep_connection && path->client->is_connected())
+        path_disconnect(path);
+
+    return sent;
+}
+
 // Request for check how many availables messages are waiting to be received
 uint8_t uTLGBot::getUpdates(void)
 {
     uint8_t request_result;
     bool connected;
 
+    // Get the working memory (received message data in it is released, as it is reused)
+    if(!updates_arena_acquire())
+        return 0;
+
     // Connect to telegram server
     connected = is_connected();
     if(!connected)
@@ -380,24 +1728,27 @@ uint8_t uTLGBot::getUpdates(void)
             return 0;
     }
 
-    // Create HTTP Body request data (Note that we limit messages to 1 and just allow text messages)
-    snprintf(_buffer, HTTP_MAX_RES_LENGTH, "{\"offset\":%" PRIu64 ", \"limit\":1, " \
-        "\"timeout\":%" PRIu8 ", \"allowed_updates\":[\"message\"]}", _last_received_msg,
-        _long_poll_timeout);
+    // Create HTTP Body request data
+    create_updates_body();
 
     // Send the request
     _println("[Bot] Trying to send getUpdates request...");
     _println("Mesage to send:");
     _println(_buffer);
     _println("");
-    request_result = tlg_post(API_CMD_GET_UPDATES, _buffer, strlen(_buffer), HTTP_MAX_RES_LENGTH,
-        (_long_poll_timeout*1000)+HTTP_WAIT_RESPONSE_TIMEOUT);
+    request_result = tlg_post(&_rx_path, API_CMD_GET_UPDATES, _buffer, strlen(_buffer),
+        HTTP_MAX_RES_LENGTH, (_long_poll_timeout*1000)+HTTP_WAIT_RESPONSE_TIMEOUT);
 
     // Check if request has fail
     if(request_result == false)
     {
         _println("[Bot] Command fail, no response received.");
 
+        // A response that fills the buffer didn't fit in it (the updates requested again with the
+        // new one are too long), so the window must be reduced
+        if(updates_window() && (strnlen(_buffer, HTTP_MAX_RES_LENGTH) >= HTTP_MAX_RES_LENGTH-1))
+            _updates_truncated = true;
+
         // Disconnect from telegram server
         if(is_connected())
             disconnect();
@@ -405,25 +1756,82 @@ uint8_t uTLGBot::getUpdates(void)
         return 0;
     }
 
-    // Use a pointer to received buffer data
-    char* ptr_response = &(_buffer[0]);
+    return parse_updates();
+}
+
+// Create getUpdates request body in the data buffer (Note that we limit messages to 1 and just
+// allow text messages, and callback queries if there is any handler for them)
+// Received updates that must not be confirmed yet (_updates_commit) are requested again, and
+// skipped when the response is parsed
+void uTLGBot::create_updates_body(void)
+{
+    uint64_t offset = _last_received_msg;
+    uint8_t limit = 1;
+
+    _update_len = 0;
+    _updates_truncated = false;
+    if(updates_window())
+    {
+        offset = _updates_commit;
+        limit = _updates_limit;
+    }
+    snprintf(_buffer, HTTP_MAX_RES_LENGTH, "{\"offset\":%" PRIu64 ", \"limit\":%" PRIu8 ", " \
+        "\"timeout\":%" PRIu8 ", \"allowed_updates\":[\"message\"%s]}", offset, limit,
+        _long_poll_timeout, (_num_callback_query_handlers > 0) ? ",\"callback_query\"" : "");
+}
 
-    // Remove any EOL character
-    cstr_rm_char(ptr_response, strlen(ptr_response), '\r');
-    cstr_rm_char(ptr_response, strlen(ptr_response), '\n');
+// Check if getUpdates requests include already received updates that are not confirmed yet
+bool uTLGBot::updates_window(void)
+{
+    return ((_updates_limit > 1) && (_updates_commit < _last_received_msg) &&
+        (_last_received_msg != UINT64_MAX));
+}
 
-    // Remove start and end list characters ('[' and ']') from response and just keep json structure
-    if(strlen(ptr_response) >= 2)
+// Get the update of a received getUpdates response (the response is in the data buffer)
+uint8_t uTLGBot::parse_updates(void)
+{
+    // Get the update object from the result list (getUpdates result is a list with 1 update
+    // at most, i.e. [{"update_id":1234,...}])
+    const char* ptr_response = _buffer + _rx_path.result_pos;
+    size_t response_len = _rx_path.result_len;
+    size_t pos = json_skip_spaces(ptr_response, response_len, 0);
+    if((pos < response_len) && (ptr_response[pos] == '['))
+        pos = json_skip_spaces(ptr_response, response_len, pos+1);
+    if(updates_window())
     {
-        if(ptr_response[strlen(ptr_response)-1] == ']')
-            ptr_response[strlen(ptr_response)-1] = '\0';
-        if(ptr_response[0] == '[')
-            ptr_response[0] = '\0';
-        ptr_response = ptr_response + 1;
+        // Skip the already received updates (requested again as they are not confirmed yet)
+        int32_t update_end;
+        int64_t update_id;
+        while((pos < response_len) && (ptr_response[pos] == '{'))
+        {
+            update_end = json_skip_value(ptr_response, response_len, pos);
+            if(update_end == -1)
+            {
+                // Response truncated (the requested again updates didn't fit in the buffer), so
+                // handle it as empty and keep the next update to be requested again
+                _updates_truncated = true;
+                pos = response_len;
+                break;
+            }
+            if(!json_get_root_int(ptr_response + pos, update_end - pos, "update_id", &update_id)
+                || ((uint64_t)update_id >= _last_received_msg))
+            {
+                response_len = update_end;
+                break;
+            }
+            pos = json_skip_spaces(ptr_response, response_len, update_end);
+            if((pos < response_len) && (ptr_response[pos] == ','))
+                pos = json_skip_spaces(ptr_response, response_len, pos+1);
+        }
     }
+    ptr_response = ptr_response + pos;
+    response_len = response_len - pos;
+    while((response_len > 0) && (ptr_response[response_len-1] != '}'))
+        response_len = response_len - 1;
+    _update_len = (uint32_t)response_len;
 
     // Check if response is empty (there is no message)
-    if(ptr_response[0] == '\0')
+    if(response_len == 0)
     {
         _println("[Bot] There is not new message.");
 
@@ -436,8 +1844,7 @@ uint8_t uTLGBot::getUpdates(void)
     else
     {
         _println("\n[Bot] Response received:");
-        _println(ptr_response);
-        _println(" ");
+        _printf("%.*s\n\n", (int)response_len, ptr_response);
     }
 
     // A new message received, so lets clear all message data
@@ -447,16 +1854,13 @@ uint8_t uTLGBot::getUpdates(void)
 
     /* Response JSON Parse */
 
-    uint32_t num_elements, num_subelements;
+    uint32_t num_elements;
     uint32_t key_position;
-
-    // Clear json elements objects
-    memset(_json_elements, 0, (sizeof(jsmntok_t)*MAX_JSON_ELEMENTS));
-    memset(_json_subelements, 0, (sizeof(jsmntok_t)*MAX_JSON_SUBELEMENTS));
+    uint32_t keys_position[TLG_NUM_KEYS];
+    int64_t value;
 
     // Parse message string as JSON and get each element
-    num_elements = json_parse_str(ptr_response, strlen(ptr_response), _json_elements,
-        MAX_JSON_ELEMENTS);
+    num_elements = json_parse_str(ptr_response, response_len);
     if(num_elements == 0)
     {
         _println("[Bot] Error: Bad JSON sintax from received response.");
@@ -471,622 +1875,3897 @@ uint8_t uTLGBot::getUpdates(void)
         return 0;
     }
 
+    // Get the number of tokens of each element (to skip nested elements while looking for keys)
+    json_index_subtrees(_json_elements, num_elements, _json_subtree_len);
+
+    // Get the position of all known keys of the update object
+    json_map_keys(ptr_response, _json_elements, _json_subtree_len, 0, keys_position);
+
     // Check and get value of key: update_id
-    key_position = json_has_key(ptr_response, _json_elements, num_elements, "update_id");
+    key_position = keys_position[TLG_KEY_UPDATE_ID];
     if(key_position != 0)
     {
-        // Get json element string
-        json_get_element_string(ptr_response, &_json_elements[key_position+1],
-            _json_value_str, MAX_JSON_STR_LEN);
-
-        // Save value in variable
-        sscanf(_json_value_str, "%" SCNu64, &_last_received_msg);
+        // Get json element value
+        if(json_get_element_int(ptr_response, &_json_elements[key_position+1], &value))
+            _last_received_msg = (uint64_t)value;
 
         // Prepare variable to next update message request (offset)
         _last_received_msg = _last_received_msg + 1;
     }
 
-    // Check and get value of key: message_id
-    key_position = json_has_key(ptr_response, _json_elements, num_elements,
-        "message_id");
+    // Check for a callback query update, and dispatch it to its handler
+    key_position = keys_position[TLG_KEY_CALLBACK_QUERY];
     if(key_position != 0)
     {
-        // Get json element string
-        json_get_element_string(ptr_response, &_json_elements[key_position+1],
-            _json_value_str, MAX_JSON_STR_LEN);
+        if(!parse_callback_query(ptr_response, key_position+1))
+        {
+            // Disconnect from telegram server
+            if(_dont_keep_connection && is_connected())
+                disconnect();
 
-        // Save value in variable
-        sscanf(_json_value_str, "%" SCNd64, &received_msg.message_id);
-    }
+            return TLG_UPDATE_NONE;
+        }
+        dispatch_callback_query();
 
-    // Check and get value of key: date
-    key_position = json_has_key(ptr_response, _json_elements, num_elements, "date");
-    if(key_position != 0)
-    {
-        // Get json element string
-        json_get_element_string(ptr_response, &_json_elements[key_position+1],
-            _json_value_str, MAX_JSON_STR_LEN);
+        // Disconnect from telegram server
+        if(_dont_keep_connection && is_connected())
+            disconnect();
 
-        // Save value in variable
-        sscanf(_json_value_str, "%" SCNu32, &received_msg.date);
+        return TLG_UPDATE_CALLBACK_QUERY;
     }
 
-    // Check and get value of key: text
-    key_position = json_has_key(ptr_response, _json_elements, num_elements, "text");
-    if(key_position != 0)
+    // Decode the message object (just its own keys, so the keys of nested objects like
+    // "reply_to_message" are not mixed with the message ones)
+    key_position = keys_position[TLG_KEY_MESSAGE];
+    if((key_position == 0) || (_json_elements[key_position+1].type != JSMN_OBJECT))
     {
-        // Get json element string
-        json_get_element_string(ptr_response, &_json_elements[key_position+1],
-        _json_value_str, MAX_JSON_STR_LEN);
+        _println("[Bot] Error: Update without message.");
 
-        // Save value in variable
-        snprintf(received_msg.text, MAX_TEXT_LENGTH, "%s", _json_value_str);
-    }
+        // Disconnect from telegram server
+        if(_dont_keep_connection && is_connected())
+            disconnect();
 
-    // Check and get value of key: from
-    key_position = json_has_key(ptr_response, _json_elements, num_elements, "from");
-    if(key_position != 0)
+        return TLG_UPDATE_NONE;
+    }
+    if(_lazy_decode)
     {
-        // Get json element string
-        json_get_element_string(ptr_response, &_json_elements[key_position+1],
-            _json_value_str, MAX_JSON_STR_LEN);
+        // Just check the present fields and keep the position of their values, fields are
+        // decoded on access
+        received_msg.present = json_decode_object(ptr_response, key_position+1,
+            tlg_message_fields, TLG_FIELDS_NUM(tlg_message_fields), &received_msg, 0,
+            _msg_field_tokens);
+        _msg_json_str = ptr_response;
+        _msg_pending_fields = received_msg.present;
+        if(received_msg.present & TLG_MSG_HAS_CHAT)
+            _msg_pending_fields = _msg_pending_fields | TLG_MSG_CHAT_ID_ONLY;
+    }
+    else
+    {
+        received_msg.present = json_decode_object(ptr_response, key_position+1,
+            tlg_message_fields, TLG_FIELDS_NUM(tlg_message_fields), &received_msg);
+    }
+    _msg_spans_valid = true;
 
-        // Parse string "from" content as JSON and get each element
-        num_subelements = json_parse_str(_json_value_str, strlen(_json_value_str),
-            _json_subelements, MAX_JSON_SUBELEMENTS);
-        if(num_subelements == 0)
-            _println("[Bot] Error: Bad JSON sintax in \"from\" element.");
-        else
-        {
-            // Check and get value of key: id
-            key_position = json_has_key(_json_value_str, _json_subelements,
-                num_subelements, "id");
-            if(key_position != 0)
-            {
-                // Get json element string
-                json_get_element_string(_json_value_str,
-                    &_json_subelements[key_position+1],
-                    _json_subvalue_str, MAX_JSON_SUBVAL_STR_LEN);
+    // Disconnect from telegram server
+    if(_dont_keep_connection && is_connected())
+        disconnect();
 
-                // Save value in variable
-                snprintf(received_msg.from.id, MAX_ID_LENGTH, "%s", _json_subvalue_str);
-            }
+    return TLG_UPDATE_MESSAGE;
+}
 
-            // Check and get value of key: is_bot
-            key_position = json_has_key(_json_value_str, _json_subelements,
-                num_subelements, "is_bot");
-            if(key_position != 0)
-            {
-                // Get json element string
-                json_get_element_string(_json_value_str,
-                    &_json_subelements[key_position+1],
-                    _json_subvalue_str, MAX_JSON_SUBVAL_STR_LEN);
-
-                // Save value in variable
-                if(strcmp(_json_subvalue_str, "true") == 0)
-                    received_msg.from.is_bot = true;
-                else
-                    received_msg.from.is_bot = false;
-            }
+#if defined(UTLGBOT_REACTOR)
 
-            // Check and get value of key: first_name
-            key_position = json_has_key(_json_value_str, _json_subelements,
-                num_subelements, "first_name");
-            if(key_position != 0)
-            {
-                // Get json element string
-                json_get_element_string(_json_value_str,
-                    &_json_subelements[key_position+1],
-                    _json_subvalue_str, MAX_JSON_SUBVAL_STR_LEN);
+// Start a getUpdates request without waiting for it (it is run with getUpdates_run() when its
+// connection is ready), getting the update type in update_type if it is already done
+// Return the request state (see getUpdates_run())
+uint8_t uTLGBot::getUpdates_request(uint8_t* update_type)
+{
+    *update_type = TLG_UPDATE_NONE;
 
-                // Save value in variable
-                snprintf(received_msg.from.first_name, MAX_USER_LENGTH, "%s", _json_subvalue_str);
-            }
+    // Get the working memory (received message data in it is released, as it is reused)
+    if(!updates_arena_acquire())
+        return MULTIHTTPSCLIENT_ASYNC_FAIL;
 
-            // Check and get value of key: last_name
-            key_position = json_has_key(_json_value_str, _json_subelements,
-                num_subelements, "last_name");
-            if(key_position != 0)
-            {
-                // Get json element string
-                json_get_element_string(_json_value_str,
-                    &_json_subelements[key_position+1], _json_subvalue_str,
-                    MAX_JSON_SUBVAL_STR_LEN);
-
-                // Save value in variable
-                snprintf(received_msg.from.last_name, MAX_USER_LENGTH, "%s",
-                    _json_subvalue_str);
-            }
+    // Create HTTP Body request data and start the request (connecting to the server if needed)
+    create_updates_body();
+    _println("[Bot] Trying to send getUpdates request...");
+    _println("Mesage to send:");
+    _println(_buffer);
+    _println("");
 
-            // Check and get value of key: username
-            key_position = json_has_key(_json_value_str, _json_subelements,
-                num_subelements, "username");
-            if(key_position != 0)
-            {
-                // Get json element string
-                json_get_element_string(_json_value_str,
-                    &_json_subelements[key_position+1], _json_subvalue_str,
-                    MAX_JSON_SUBVAL_STR_LEN);
-
-                // Save value in variable
-                snprintf(received_msg.from.username, MAX_USERNAME_LENGTH, "@%s",
-                    _json_subvalue_str);
-            }
+    return getUpdates_result(tlg_async_post(&_rx_path, API_CMD_GET_UPDATES, _buffer,
+        strlen(_buffer)), update_type);
+}
 
-            // Check and get value of key: language_code
-            key_position = json_has_key(_json_value_str, _json_subelements,
-                num_subelements, "language_code");
-            if(key_position != 0)
-            {
-                // Get json element string
-                json_get_element_string(_json_value_str,
-                    &_json_subelements[key_position+1], _json_subvalue_str,
-                    MAX_JSON_SUBVAL_STR_LEN);
-
-                // Save value in variable
-                snprintf(received_msg.from.language_code, MAX_LANGUAGE_CODE_LENGTH, "%s",
-                    _json_subvalue_str);
-            }
-        }
-    }
+// Run the getUpdates request in flight (when its connection is ready), getting the update type in
+// update_type once it is done
+// Return the request state: done, fail or in flight, or idle if the request was dropped because
+// other bot that shares the working memory used it while the response was being received (it
+// must be made again)
+uint8_t uTLGBot::getUpdates_run(uint8_t* update_type)
+{
+    uint8_t state = _client.async_get_state();
 
-    // Check and get value of key: chat
-    key_position = json_has_key(ptr_response, _json_elements, num_elements, "chat");
-    if(key_position != 0)
-    {
-        // Get json element string
-        json_get_element_string(ptr_response, &_json_elements[key_position+1],
-            _json_value_str, MAX_JSON_STR_LEN);
+    *update_type = TLG_UPDATE_NONE;
 
-        // Parse string "from" content as JSON and get each element
-        num_subelements = json_parse_str(_json_value_str, strlen(_json_value_str),
-            _json_subelements, MAX_JSON_ELEMENTS);
-        if(num_subelements == 0)
-            _println("[Bot] Error: Bad JSON sintax in \"from\" element.");
-        else
+    // Get the working memory back if other bot that shares it used it: the request body is created
+    // again if it is not written yet, but a partially received response is lost
+    if(_arena->_owner != this)
+    {
+        if(_client.async_get_received() > 0)
         {
-            // Check and get value of key: id
-            key_position = json_has_key(_json_value_str, _json_subelements,
-                num_subelements, "id");
-            if(key_position != 0)
-            {
-                // Get json element string
-                json_get_element_string(_json_value_str, &_json_subelements[key_position+1],
-                    _json_subvalue_str, MAX_JSON_SUBVAL_STR_LEN);
-
-                // Save value in variable
-                snprintf(received_msg.chat.id, MAX_ID_LENGTH, "%s", _json_subvalue_str);
-            }
-
-            // Check and get value of key: type
-            key_position = json_has_key(_json_value_str, _json_subelements,
-                num_subelements, "type");
-            if(key_position != 0)
-            {
-                // Get json element string
-                json_get_element_string(_json_value_str, &_json_subelements[key_position+1],
-                    _json_subvalue_str, MAX_JSON_SUBVAL_STR_LEN);
-
-                // Save value in variable
-                snprintf(received_msg.chat.type, MAX_CHAT_TYPE_LENGTH, "%s", _json_subvalue_str);
-            }
+            _println("[Bot] Response dropped, working memory used by other bot.");
+            _client.disconnect();
+            return MULTIHTTPSCLIENT_ASYNC_IDLE;
+        }
+        if(!arena_acquire())
+        {
+            _client.disconnect();
+            return MULTIHTTPSCLIENT_ASYNC_FAIL;
+        }
+        if(state != MULTIHTTPSCLIENT_ASYNC_READ)
+            create_updates_body();
+    }
 
-            // Check and get value of key: title
-            key_position = json_has_key(_json_value_str, _json_subelements,
-                num_subelements, "title");
-            if(key_position != 0)
-            {
-                // Get json element string
-                json_get_element_string(_json_value_str, &_json_subelements[key_position+1],
-                    _json_subvalue_str, MAX_JSON_SUBVAL_STR_LEN);
+    return getUpdates_result(_client.async_run(), update_type);
+}
 
-                // Save value in variable
-                snprintf(received_msg.chat.title, MAX_CHAT_TITLE_LENGTH, "%s", _json_subvalue_str);
-            }
+// Handle the state of the getUpdates request in flight after run it: once it is done, check the
+// response and parse the received updates
+// Return the request state
+uint8_t uTLGBot::getUpdates_result(const uint8_t state, uint8_t* update_type)
+{
+    if(state == MULTIHTTPSCLIENT_ASYNC_FAIL)
+    {
+        _println("[Bot] Command fail, no response received.");
+        REQ_TIMING_ADD(&_rx_path, 0, false);
+        return state;
+    }
+    if(state != MULTIHTTPSCLIENT_ASYNC_DONE)
+        return state;
 
-            // Check and get value of key: username
-            key_position = json_has_key(_json_value_str, _json_subelements, num_subelements,
-                "username");
-            if(key_position != 0)
-            {
-                // Get json element string
-                json_get_element_string(_json_value_str, &_json_subelements[key_position+1],
-                    _json_subvalue_str, MAX_JSON_SUBVAL_STR_LEN);
+    if(tlg_check(&_rx_path, 0, _buffer, HTTP_MAX_RES_LENGTH) == false)
+    {
+        _println("[Bot] Command fail, unexpected response.");
 
-                // Save value in variable
-                snprintf(received_msg.chat.username, MAX_USERNAME_LENGTH, "%s", _json_subvalue_str);
-            }
+        // Disconnect from telegram server
+        if(is_connected())
+            disconnect();
 
-            // Check and get value of key: first_name
-            key_position = json_has_key(_json_value_str, _json_subelements,
-                num_subelements, "first_name");
-            if(key_position != 0)
-            {
-                // Get json element string
-                json_get_element_string(_json_value_str, &_json_subelements[key_position+1],
-                    _json_subvalue_str, MAX_JSON_SUBVAL_STR_LEN);
+        return MULTIHTTPSCLIENT_ASYNC_FAIL;
+    }
+    *update_type = parse_updates();
 
-                // Save value in variable
-                snprintf(received_msg.chat.first_name, MAX_USER_LENGTH, "%s", _json_subvalue_str);
-            }
+    return MULTIHTTPSCLIENT_ASYNC_DONE;
+}
 
-            // Check and get value of key: last_name
-            key_position = json_has_key(_json_value_str, _json_subelements,
-                num_subelements, "last_name");
-            if(key_position != 0)
-            {
-                // Get json element string
-                json_get_element_string(_json_value_str, &_json_subelements[key_position+1],
-                    _json_subvalue_str, MAX_JSON_SUBVAL_STR_LEN);
+#endif
 
-                // Save value in variable
-                snprintf(received_msg.chat.last_name, MAX_USER_LENGTH, "%s", _json_subvalue_str);
-            }
+// Register a handler for received callback queries which data starts with the provided prefix
+// (handlers are checked in registration order, so an empty prefix handles any callback query)
+// Note: If the handler doesn't answer the callback query, an empty answer is sent after it
+bool uTLGBot::add_callback_query_handler(const char* data_prefix,
+    tlg_callback_query_handler handler, void* arg)
+{
+    tlg_callback_query_entry* entry;
 
-            // Check and get value of key: is_bot
-            key_position = json_has_key(_json_value_str, _json_subelements, num_subelements,
-                "all_members_are_administrators");
-            if(key_position != 0)
-            {
-                // Get json element string
-                json_get_element_string(_json_value_str, &_json_subelements[key_position+1],
-                    _json_subvalue_str, MAX_JSON_SUBVAL_STR_LEN);
-
-                // Save value in variable
-                if(strcmp(_json_subvalue_str, "true") == 0)
-                    received_msg.chat.all_members_are_administrators = true;
-                else
-                    received_msg.chat.all_members_are_administrators = false;
-            }
-        }
+    if((_num_callback_query_handlers >= MAX_CALLBACK_QUERY_HANDLERS) || (handler == NULL) ||
+        (strlen(data_prefix) >= MAX_CALLBACK_DATA_LENGTH))
+    {
+        _println("[Bot] Can't add callback query handler.");
+        return false;
     }
 
-    // Disconnect from telegram server
-    if(_dont_keep_connection && is_connected())
-        disconnect();
+    entry = &_callback_query_handlers[_num_callback_query_handlers];
+    entry->data_prefix = data_prefix;
+    entry->data_prefix_len = strlen(data_prefix);
+    entry->handler = handler;
+    entry->arg = arg;
+    _num_callback_query_handlers = _num_callback_query_handlers + 1;
 
-    return 1;
+    return true;
 }
 
-/**************************************************************************************************/
+// Request Bot answer a callback query (stop the button "loading" state and optionally show a
+// notification or alert to the user)
+uint8_t uTLGBot::answerCallbackQuery(const char* callback_query_id, const char* text,
+    bool show_alert)
+{
+    tlg_req_path* path;
 
-/* Telegram API GET and POST Methods */
+    // Once paths are split, answers are sent through their own path, apart from the send requests
+    #if defined(UTLGBOT_SPLIT_PATHS)
+        if(_cb_path.client != NULL)
+        {
+            CB_PATH_LOCK();
+            return callback_query_answer(&_cb_path, callback_query_id, text, show_alert);
+        }
+    #endif
 
-// Make and send a HTTP GET request
-uint8_t uTLGBot::tlg_get(const char* command, char* response, const size_t response_len,
-    const unsigned long response_timeout)
-{
-    char* response_init_pos = response;
-    char uri[HTTP_MAX_URI_LENGTH];
-    int32_t pos = 0;
-    uint32_t i = 0;
+    // Get the send requests path and its working memory
+    SEND_PATH_LOCK();
+    path = send_path();
+    if(path == NULL)
+        return 0;
 
-    // Create URI and send GET request
-    snprintf(uri, HTTP_MAX_URI_LENGTH, "%s/%s", _tlg_api, command);
-    if(_client.get(uri, TELEGRAM_HOST, response, response_len, response_timeout) > 0)
-        return false;
+    return callback_query_answer(path, callback_query_id, text, show_alert);
+}
 
-    // Remove last character
-    response[strlen(response)-1] = '\0';
+// Send an answerCallbackQuery request through the given path
+uint8_t uTLGBot::callback_query_answer(tlg_req_path* path, const char* callback_query_id,
+    const char* text, const bool show_alert)
+{
+    uint8_t request_result;
+    size_t body_len;
 
-    // Check and remove response header (just keep response body)
-    pos = cstr_get_substr_pos_end(response, strlen(response), "\r\n\r\n", strlen("\r\n\r\n"));
-    if(pos == -1)
+    // Connect to telegram server
+    if(!path->client->is_connected())
     {
-        // Clear response if unexpected response
-        _println("[Bot] Unexpected response.");
-        _println(response);
-        memset(response, '\0', response_len);
-        return false;
+        if(!path_connect(path))
+            return false;
     }
-    response = response + pos;
 
-    // Check for and get request "ok" response key
-    // Note: We are assumming "ok" attribute comes before "response" attribute
-    pos = cstr_get_substr_pos_end(response, strlen(response), "\"ok\":", strlen("\"ok\":"));
-    if(pos == -1)
+    // Create HTTP Body request data (query ID and text JSON escaped to keep the request valid)
+    snprintf(path->buffer, HTTP_MAX_RES_LENGTH, "{\"callback_query_id\":\"");
+    body_len = strlen(path->buffer);
+    if((json_escape_str(callback_query_id, strlen(callback_query_id), path->buffer+body_len,
+        HTTP_MAX_RES_LENGTH-body_len) == -1) ||
+        !cstr_strncat(path->buffer, HTTP_MAX_RES_LENGTH, "\"", strlen("\"")))
     {
-        // Clear response if unexpected response
-        _println("[Bot] Unexpected response.");
-        _println(response);
-        memset(response, '\0', response_len);
+        cant_create_send_msg(path, path->buffer);
         return false;
     }
-    response = response + pos;
-
-    // Check if request "ok" response value is "true"
-    if(strncmp(response, "true", strlen("true")) != 0)
+    if(text[0] != '\0')
     {
-        // Clear response due bad request response ("ok" != true)
-        _println("[Bot] Bad request.");
-        _println(response);
-        memset(response, '\0', response_len);
-        return false;
+        if(!cstr_strncat(path->buffer, HTTP_MAX_RES_LENGTH, ",\"text\":\"", strlen(",\"text\":\"")))
+        {
+            cant_create_send_msg(path, path->buffer);
+            return false;
+        }
+        body_len = strlen(path->buffer);
+        if((json_escape_str(text, strlen(text), path->buffer+body_len,
+            HTTP_MAX_RES_LENGTH-body_len) == -1) ||
+            !cstr_strncat(path->buffer, HTTP_MAX_RES_LENGTH, "\"", strlen("\"")))
+        {
+            cant_create_send_msg(path, path->buffer);
+            return false;
+        }
     }
-
-    // Remove root json response and just keep "result" attribute json value in response buffer
-    // i.e. for response: {"ok":true,"result":{"id":123456789,"first_name":"esp8266_Bot"}}
-    // just keep: {"id":123456789,"first_name":"esp8266_Bot"}
-    pos = cstr_get_substr_pos_end(response, strlen(response), "\"result\":", strlen("\"result\":"));
-    if(pos == -1)
+    if(show_alert)
     {
-        // Clear response if unexpected response
-        _println("[Bot] Unexpected response.");
-        _println(response);
-        memset(response, '\0', response_len);
+        if(!cstr_strncat(path->buffer, HTTP_MAX_RES_LENGTH, ",\"show_alert\":true",
+            strlen(",\"show_alert\":true")))
+        {
+            cant_create_send_msg(path, path->buffer);
+            return false;
+        }
+    }
+    if(!cstr_strncat(path->buffer, HTTP_MAX_RES_LENGTH, "}", strlen("}")))
+    {
+        cant_create_send_msg(path, path->buffer);
         return false;
     }
-    response = response + pos;
 
-    // Move each byte to initial response address positions
-    i = 0;
-    while(i < strlen(response))
+    // Send the request
+    _println("[Bot] Trying to send answerCallbackQuery request...");
+    _println(path->buffer);
+    if(strcmp(callback_query_id, received_callback_query.id) == 0)
+        _callback_query_answered = true;
+    request_result = tlg_post(path, API_CMD_ANSWER_CALLBACK_QUERY, path->buffer,
+        strlen(path->buffer), HTTP_MAX_RES_LENGTH);
+
+    // Check if request has fail
+    if(request_result == false)
     {
-        response_init_pos[i] = response[i];
-        i = i + 1;
+        _println("[Bot] Command fail, no response received.");
+
+        // Disconnect from telegram server
+        if(path->client->is_connected())
+            path_disconnect(path);
+
+        return false;
     }
-    response_init_pos[i] = '\0';
+
+    // Disconnect from telegram server
+    if(_dont_keep_connection && path->client->is_connected())
+        path_disconnect(path);
 
     return true;
 }
 
-// Make and send a HTTP GET request
-uint8_t uTLGBot::tlg_post(const char* command, char* request_response, const size_t request_len,
-    const size_t request_response_max_size, const unsigned long response_timeout)
+/**************************************************************************************************/
+
+/* Runtime Keyboard Markup Builder */
+
+// Keyboard builder constructor, start an empty keyboard in the provided buffer
+uTLGBotKeyboard::uTLGBotKeyboard(char* buffer, const size_t buffer_size,
+    const bool inline_keyboard)
 {
-    char* response_init_pos = request_response;
-    char uri[HTTP_MAX_URI_LENGTH];
-    int32_t pos = 0;
-    uint32_t i = 0;
+    _buffer = buffer;
+    _buffer_size = buffer_size;
+    _inline_keyboard = inline_keyboard;
 
-    // Create URI and send POST request
-    snprintf(uri, HTTP_MAX_URI_LENGTH, "%s/%s", _tlg_api, command);
-    if(_client.post(uri, TELEGRAM_HOST, request_response, request_len,
-        request_response_max_size, response_timeout) > 0)
-    {
-        return false;
-    }
+    clear();
+}
 
-    // Remove last character
-    request_response[strlen(request_response)-1] = '\0';
+// Remove all rows and buttons
+// Return false if the buffer is too small for an empty keyboard (the buffer is left empty)
+bool uTLGBotKeyboard::clear(void)
+{
+    _length = 0;
+    _row_empty = true;
+    _new_row = false;
+    _valid = true;
+    if(_inline_keyboard)
+        append("{\"inline_keyboard\":[[");
+    else
+        append("{\"keyboard\":[[");
+    return close(0, true, false);
+}
 
-    // Check and remove response header (just keep response body)
-    pos = cstr_get_substr_pos_end(request_response, strlen(request_response), "\r\n\r\n",
-        strlen("\r\n\r\n"));
-    if(pos == -1)
-    {
-        // Clear response if unexpected response
-        _println("[Bot] Unexpected response.");
-        _println(request_response);
-        memset(request_response, '\0', request_response_max_size);
-        return false;
-    }
-    request_response = request_response + pos;
+// Start a new row of buttons (it is added with the first button of the row)
+bool uTLGBotKeyboard::row(void)
+{
+    if(!_row_empty)
+        _new_row = true;
+    return _valid;
+}
 
-    // Check for and get request "ok" response key
-    // Note: We are assumming "ok" attribute comes before "response" attribute
-    pos = cstr_get_substr_pos_end(request_response, strlen(request_response), "\"ok\":",
-        strlen("\"ok\":"));
-    if(pos == -1)
-    {
-        // Clear response if unexpected response
-        _println("[Bot] Unexpected response.");
-        _println(request_response);
-        memset(request_response, '\0', request_response_max_size);
+// Add a text button to actual row
+bool uTLGBotKeyboard::button(const char* text)
+{
+    size_t length = _length;
+    bool row_empty = _row_empty;
+    bool new_row = _new_row;
+
+    add_separator();
+    append("\"");
+    append(text, true);
+    append("\"");
+    return close(length, row_empty, new_row);
+}
+
+// Add an inline button with callback data to actual row
+bool uTLGBotKeyboard::inline_button(const char* text, const char* callback_data)
+{
+    size_t length = _length;
+    bool row_empty = _row_empty;
+    bool new_row = _new_row;
+
+    add_separator();
+    append("{\"text\":\"");
+    append(text, true);
+    append("\",\"callback_data\":\"");
+    append(callback_data, true);
+    append("\"}");
+    return close(length, row_empty, new_row);
+}
+
+// Check if all the keyboard elements fit in the buffer
+bool uTLGBotKeyboard::is_valid(void)
+{
+    return _valid;
+}
+
+// Get the keyboard JSON string (it is always a complete JSON object)
+const char* uTLGBotKeyboard::get(void)
+{
+    return _buffer;
+}
+
+// Append a string to the keyboard (JSON escaped if requested)
+bool uTLGBotKeyboard::append(const char* str, const bool escape)
+{
+    int32_t len;
+
+    if(!_valid)
         return false;
+    if(escape)
+        len = uTLGBot::json_escape_str(str, strlen(str), _buffer+_length, _buffer_size-_length);
+    else
+    {
+        len = strlen(str);
+        if(_length + len >= _buffer_size)
+            len = -1;
+        else
+            memcpy(_buffer+_length, str, len+1);
     }
-    request_response = request_response + pos;
-
-    // Check if request "ok" response value is "true"
-    if(strncmp(request_response, "true", strlen("true")) != 0)
+    if(len == -1)
     {
-        // Clear response due bad request response ("ok" != true)
-        _println("[Bot] Bad request.");
-        _println(request_response);
-        memset(request_response, '\0', request_response_max_size);
+        _valid = false;
         return false;
     }
+    _length = _length + len;
 
-    // Remove root json response and just keep "result" attribute json value in response buffer
-    // i.e. for response: {"ok":true,"result":[{"id":123456789,"first_name":"esp8266_Bot"}]}
-    // just keep: [{"id":123456789,"first_name":"esp8266_Bot"}]
-    pos = cstr_get_substr_pos_end(request_response, strlen(request_response), "\"result\":",
-        strlen("\"result\":"));
-    if(pos == -1)
+    return true;
+}
+
+// Add the separator before a new button (and the new row start if requested)
+void uTLGBotKeyboard::add_separator(void)
+{
+    if(_new_row)
     {
-        // Clear response if unexpected response
-        _println("[Bot] Unexpected response.");
-        _println(request_response);
-        memset(request_response, '\0', request_response_max_size);
-        return false;
+        append("],[");
+        _new_row = false;
     }
-    request_response = request_response + pos;
+    else if(!_row_empty)
+        append(",");
+    _row_empty = false;
+}
 
-    // Move each byte to initial response address positions
-    i = 0;
-    while(i < strlen(request_response))
+// Close the keyboard JSON after last element (next append overwrites it)
+// If last element doesn't fit, it is removed to keep the previous valid keyboard (or the buffer
+// is left empty if there is no previous keyboard, as the keyboard header doesn't fit)
+bool uTLGBotKeyboard::close(const size_t prev_length, const bool prev_row_empty,
+    const bool prev_new_row)
+{
+    if(_valid && (_length + strlen("]]}") < _buffer_size))
     {
-        response_init_pos[i] = request_response[i];
-        i = i + 1;
-        _yield();
+        memcpy(_buffer+_length, "]]}", strlen("]]}")+1);
+        return true;
     }
-    response_init_pos[i] = '\0';
 
-    return true;
+    _valid = false;
+    _length = prev_length;
+    _row_empty = prev_row_empty;
+    _new_row = prev_new_row;
+    if((_length > 0) && (_length + strlen("]]}") < _buffer_size))
+        memcpy(_buffer+_length, "]]}", strlen("]]}")+1);
+    else if(_buffer_size > 0)
+        _buffer[0] = '\0';
+
+    return false;
 }
 
 /**************************************************************************************************/
 
-/* Private Auxiliar Methods */
+/* Live Messages */
 
-// Clear and set all received message data to default values
-void uTLGBot::clear_msg_data(void)
+// Live message constructor (buffer first half keeps the latest desired text of the message and
+// the second half the last sent one)
+uTLGBotLiveMessage::uTLGBotLiveMessage(uTLGBot& bot, const char* chat_id, char* buffer,
+    const size_t buffer_size, const unsigned long min_interval_ms, const int64_t message_id) :
+    _bot(bot)
 {
-    received_msg.message_id = 0;
-    received_msg.date = 0;
-    received_msg.text[0] = '\0';
-    received_msg.from.id[0] = '\0';
-    received_msg.from.is_bot = false;
-    received_msg.from.first_name[0] = '\0';
-    received_msg.from.last_name[0] = '\0';
-    received_msg.from.username[0] = '\0';
-    received_msg.from.language_code[0] = '\0';
-    received_msg.chat.id[0] = '\0';
-    received_msg.chat.type[0] = '\0';
-    received_msg.chat.title[0] = '\0';
-    received_msg.chat.username[0] = '\0';
-    received_msg.chat.first_name[0] ='\0';
-    received_msg.chat.last_name[0] = '\0';
-    received_msg.chat.all_members_are_administrators = false;
+    // A chat ID that doesn't fit is not kept, so the message is never sent instead of being sent
+    // to other chat
+    if(snprintf(_chat_id, MAX_CHAT_ID_LENGTH, "%s", chat_id) >= MAX_CHAT_ID_LENGTH)
+        _chat_id[0] = '\0';
+    _text_size = buffer_size / 2;
+    _text = buffer;
+    _sent_text = buffer + _text_size;
+    _text_len = 0;
+    _sent_text_len = 0;
+    _min_interval_ms = min_interval_ms;
+    _t_last_flush = 0;
+    _message_id = message_id;
+    _sent = false;
+    _flushed = false;
+    _pending = false;
+    if(_text_size > 0)
+    {
+        _text[0] = '\0';
+        _sent_text[0] = '\0';
+    }
 }
 
-// Send message fail to be created
-void uTLGBot::cant_create_send_msg(const char* msg)
+// Live message constructor for a numeric chat ID
+uTLGBotLiveMessage::uTLGBotLiveMessage(uTLGBot& bot, const int64_t chat_id, char* buffer,
+    const size_t buffer_size, const unsigned long min_interval_ms, const int64_t message_id) :
+    uTLGBotLiveMessage(bot, "", buffer, buffer_size, min_interval_ms, message_id)
 {
-    _println("[Bot] Can't create send message:");
-    _println(msg);
+    uTLGBot::cstr_from_int64(chat_id, _chat_id);
+}
 
-    // Disconnect from telegram server
-    if(is_connected())
-        disconnect();
+// Set the latest desired text of the message and send it if minimum interval has elapsed
+// Return false if text doesn't fit in half of the buffer or the send/edit request fail
+bool uTLGBotLiveMessage::update(const char* text)
+{
+    size_t text_len = strlen(text);
+
+    if(text_len >= _text_size)
+        return false;
+    memcpy(_text, text, text_len+1);
+    _text_len = text_len;
+
+    // Nothing to do if message already shows this text
+    _pending = !(_sent && (_text_len == _sent_text_len) &&
+        (memcmp(_text, _sent_text, _text_len) == 0));
+
+    return flush();
 }
 
-// Parse and get each json elements from provided json format string
-uint32_t uTLGBot::json_parse_str(const char* json_str, const size_t json_str_len,
-    jsmntok_t* json_tokens, const uint32_t json_tokens_len)
+// Send the latest desired text if it is pending and minimum interval has elapsed (or force it)
+// Return false if the send/edit request fail (text is kept pending to be sent on next flush)
+bool uTLGBotLiveMessage::flush(const bool force)
 {
-    jsmn_parser json_parser;
-    int num_elements;
+    uint8_t result;
 
-    jsmn_init(&json_parser);
-    num_elements = jsmn_parse(&json_parser, json_str, json_str_len, json_tokens, json_tokens_len);
-    if(num_elements < 0)
-    {
-#if defined(ARDUINO) // ESP32 Arduino Framework
-        _print("Can't parse JSON data. Code ");
-        _println(num_elements);
-        _println();
-#else
-        _printf("Can't parse JSON data. Code %d\n", num_elements);
-#endif
-        return 0;
-    }
-    if((num_elements == 0) || (json_tokens[0].type != JSMN_OBJECT))
+    if(!_pending)
+        return true;
+    if(!force && _flushed && ((_millis() - _t_last_flush) < _min_interval_ms))
+        return true;
+
+    // Send the message the first time and edit it later (not possible without chat ID)
+    if(_chat_id[0] == '\0')
+        return false;
+    if(_message_id == 0)
     {
-        _println("Can't parse JSON data (invalid sintax?).");
-        return 0;
+        result = _bot.sendMessage(_chat_id, _text);
+        if(result)
+            _message_id = _bot.get_sent_message_id();
     }
+    else
+        result = _bot.editMessageText(_chat_id, _message_id, _text);
+    _t_last_flush = _millis();
+    _flushed = true;
+    if(!result)
+        return false;
 
-    return num_elements;
+    memcpy(_sent_text, _text, _text_len+1);
+    _sent_text_len = _text_len;
+    _sent = true;
+    _pending = false;
+
+    return true;
 }
 
-// Check if given json object contains the provided key
-uint32_t uTLGBot::json_has_key(const char* json_str, jsmntok_t* json_tokens,
-    const uint32_t num_tokens, const char* key)
+// Check if latest desired text has not been sent yet
+bool uTLGBotLiveMessage::is_pending(void)
 {
-    for(uint32_t i = 0; i < num_tokens; i++)
-    {
-        // Continue to next iteration if json element is not a string
-        if(json_tokens[i].type != JSMN_STRING)
-            continue;
+    return _pending;
+}
 
-        // Continue to next iteration if key and json elements lengths are different
-        if(strlen(key) != (unsigned int)(json_tokens[i].end-json_tokens[i].start))
-            continue;
+// Get the live message ID (0 if it has not been sent yet)
+int64_t uTLGBotLiveMessage::get_message_id(void)
+{
+    return _message_id;
+}
 
-        // Check if key and json element string are the same
-        if(strncmp(json_str + json_tokens[i].start, key,
-            json_tokens[i].end - json_tokens[i].start) == 0)
-        {
-            return i;
-        }
+/**************************************************************************************************/
 
-        _yield();
-    }
-    return 0;
+/* Message Records Queue */
+
+// Records are aligned to its 64 bits members
+#define MSG_RECORD_ALIGN sizeof(uint64_t)
+#define MSG_RECORD_ALIGN_SIZE(size) (((size) + MSG_RECORD_ALIGN-1) & ~(MSG_RECORD_ALIGN-1))
+
+// Message records queue constructor (records are stored in the provided memory)
+uTLGBotMsgQueue::uTLGBotMsgQueue(void* memory, const size_t size)
+{
+    size_t align = (MSG_RECORD_ALIGN - ((uintptr_t)memory % MSG_RECORD_ALIGN)) % MSG_RECORD_ALIGN;
+
+    _memory = (char*)memory + align;
+    _size = (size > align) ? ((size - align) & ~(MSG_RECORD_ALIGN-1)) : 0;
+    clear();
 }
 
-// Get the corresponding string of given json element (token)
-void uTLGBot::json_get_element_string(const char* json_str, jsmntok_t* token, char* converted_str,
-    const uint32_t converted_str_len)
+// Pack the last received message of the Bot and add it at the end of the queue (it must be done
+// before any other Bot request, while the message strings spans are valid)
+// Return false if there is no space for the record (if overwrite_oldest is set, oldest records
+// are removed until it fits)
+bool uTLGBotMsgQueue::push(uTLGBot& bot, const bool overwrite_oldest)
 {
-    const char* value = json_str + token->start;
-    uint32_t value_len = token->end - token->start;
+    size_t max_size;
+    char* ptr;
+
+    // Get the maximum record size
+    max_size = record_max_size(bot);
+    if(max_size > UINT16_MAX)
+        return false;
+
+    // Get space for the record
+    ptr = reserve(max_size);
+    while((ptr == NULL) && overwrite_oldest && pop())
+        ptr = reserve(max_size);
+    if(ptr == NULL)
+        return false;
 
-    if(value_len > converted_str_len)
-        value_len = converted_str_len;
+    // Fill the record (just the real size of the record is used)
+    _back = (size_t)(ptr - _memory);
+    _tail = _back + pack(bot, ptr);
+    _used = _used + ((tlg_msg_record*)ptr)->size;
+    _count = _count + 1;
 
-    memset(converted_str, '\0', converted_str_len);
-    memcpy(converted_str, value, value_len);
-    //for(uint32_t i = 0; i < value_len; i++) // Dont trust memcpy, however it is faster...
-    //{
-    //    converted_str[i] = value[i];
-    //    _yield();
-    //}
+    return true;
 }
 
-// Get the corresponding string value of given json key
-uint8_t uTLGBot::json_get_key_value(const char* key, const char* json_str, jsmntok_t* tokens,
-    const uint32_t num_tokens, char* converted_str, const uint32_t converted_str_len)
+// Get the oldest record of the queue (NULL if it is empty)
+const tlg_msg_record* uTLGBotMsgQueue::front(void)
 {
-    // Check for key
-    size_t key_position = json_has_key(json_str, tokens, num_tokens, key);
-    if(key_position == 0)
-    {
-        _println("No key found inside json.");
+    if(_count == 0)
+        return NULL;
+
+    return (const tlg_msg_record*)(_memory + _head);
+}
+
+// Get the newest record of the queue (NULL if it is empty)
+const tlg_msg_record* uTLGBotMsgQueue::back(void)
+{
+    if(_count == 0)
+        return NULL;
+
+    return (const tlg_msg_record*)(_memory + _back);
+}
+
+// Remove the oldest record of the queue
+bool uTLGBotMsgQueue::pop(void)
+{
+    if(_count == 0)
         return false;
-    }
-    else
+
+    _used = _used - ((tlg_msg_record*)(_memory + _head))->size;
+    _head = _head + ((tlg_msg_record*)(_memory + _head))->size;
+    _count = _count - 1;
+    if((_wrap_end != 0) && (_head == _wrap_end))
     {
-        json_get_element_string(json_str, &tokens[key_position+1], converted_str,
-            converted_str_len);
+        _head = 0;
+        _wrap_end = 0;
     }
+    if(_count == 0)
+        clear();
 
     return true;
 }
 
-// Return the substring end position from given input string
-// Example: str=="Hello\r\nWorld." substr=="\r\n" -> result: 7
-// Return -1 if substring is not found
-int32_t uTLGBot::cstr_get_substr_pos_end(char* str, const size_t str_len, const char* substr,
-    const size_t substr_len)
+// Remove all the records of the queue
+void uTLGBotMsgQueue::clear(void)
 {
-    int32_t position = -1;
-    size_t i = 0;
-
-    while(i+substr_len <= str_len)
-    {
-        if(strncmp(str, substr, substr_len) == 0)
-        {
-            position = i + substr_len;
-            break;
-        }
-        str = str + 1;
-        i = i + 1;
+    _head = 0;
+    _tail = 0;
+    _back = 0;
+    _wrap_end = 0;
+    _used = 0;
+    _count = 0;
+}
 
-        _yield();
-    }
+// Get the number of records in the queue
+uint32_t uTLGBotMsgQueue::get_count(void)
+{
+    return _count;
+}
 
-    return position;
+// Get the memory used by the records of the queue (bytes)
+size_t uTLGBotMsgQueue::get_used(void)
+{
+    return _used;
 }
 
-// Remove all specific char from a string (str: "1 2 3 4 5" -> remove ' ' -> str: "12345")
-void uTLGBot::cstr_rm_char(char* str, const size_t str_len, const char c_remove)
+// Get a string of a record (TLG_MSG_RECORD_* index), empty string if it was not received
+const char* uTLGBotMsgQueue::get_str(const tlg_msg_record* record, const uint8_t str)
 {
-    size_t a, b;
+    if((str >= TLG_MSG_RECORD_NUM_STRS) || (record->str_pos[str] == 0))
+        return "";
 
-    a = 0;
-    for(b = 0; b < str_len; b++)
-    {
-        if(str[b] != c_remove)
+    return (const char*)record + record->str_pos[str];
+}
+
+// Get contiguous space of given size after the last record, wrapping to the memory start if there
+// is not enough space at the end (records are never split)
+// Return NULL if there is no space
+char* uTLGBotMsgQueue::reserve(const size_t size)
+{
+    if(_count == 0)
+        clear();
+
+    // Records are in [head, tail) (not wrapped) or in [head, wrap_end) and [0, tail) (wrapped)
+    if(_wrap_end == 0)
+    {
+        if(_tail + size <= _size)
+            return _memory + _tail;
+        if(size <= _head)
+        {
+            _wrap_end = _tail;
+            _tail = 0;
+            return _memory;
+        }
+    }
+    else if(_tail + size <= _head)
+        return _memory + _tail;
+
+    return NULL;
+}
+
+// Get the file of a message (document, biggest photo size or sticker file ID), NULL if it has none
+const tlg_str_span* uTLGBotMsgQueue::msg_file_id(const tlg_type_message& msg)
+{
+    if(msg.present & TLG_MSG_HAS_DOCUMENT)
+        return &msg.document.file_id;
+    if((msg.present & TLG_MSG_HAS_PHOTO) && (msg.photo_count > 0))
+        return &msg.photo[msg.photo_count-1].file_id;
+    if(msg.present & TLG_MSG_HAS_STICKER)
+        return &msg.sticker.file_id;
+
+    return NULL;
+}
+
+// Get the maximum size of the packed record of the last received message of the Bot (escaped
+// strings are never shorter than unescaped ones)
+size_t uTLGBotMsgQueue::record_max_size(uTLGBot& bot)
+{
+    const tlg_type_message& msg = bot.get_msg(TLG_MSG_HAS_ALL);
+    const tlg_str_span* file_id = msg_file_id(msg);
+    size_t max_size;
+
+    max_size = sizeof(tlg_msg_record) + strlen(msg.text) + strlen(msg.from.first_name) +
+        strlen(msg.from.last_name) + strlen(msg.from.username) + strlen(msg.chat.type) +
+        strlen(msg.chat.title) + strlen(msg.chat.username) + msg.caption.len +
+        ((file_id != NULL) ? file_id->len : 0) + TLG_MSG_RECORD_NUM_STRS;
+
+    return MSG_RECORD_ALIGN_SIZE(max_size);
+}
+
+// Pack the last received message of the Bot in the provided memory (of record_max_size() bytes)
+// Return the record size
+size_t uTLGBotMsgQueue::pack(uTLGBot& bot, char* ptr)
+{
+    const tlg_type_message& msg = bot.get_msg(TLG_MSG_HAS_ALL);
+    const tlg_str_span* file_id = msg_file_id(msg);
+    tlg_msg_record* record = (tlg_msg_record*)ptr;
+    size_t record_len;
+
+    record->message_id = msg.message_id;
+    record->from_id = msg.from.id;
+    record->chat_id = msg.chat.id;
+    record->reply_to_message_id = msg.reply_to_message.message_id;
+    record->date = msg.date;
+    record->present = msg.present;
+    memset(record->str_pos, 0, sizeof(record->str_pos));
+    record_len = sizeof(tlg_msg_record);
+    put_str(ptr, &record_len, TLG_MSG_RECORD_TEXT, msg.text);
+    put_str(ptr, &record_len, TLG_MSG_RECORD_FROM_FIRST_NAME, msg.from.first_name);
+    put_str(ptr, &record_len, TLG_MSG_RECORD_FROM_LAST_NAME, msg.from.last_name);
+    put_str(ptr, &record_len, TLG_MSG_RECORD_FROM_USERNAME, msg.from.username);
+    put_str(ptr, &record_len, TLG_MSG_RECORD_CHAT_TYPE, msg.chat.type);
+    put_str(ptr, &record_len, TLG_MSG_RECORD_CHAT_TITLE, msg.chat.title);
+    put_str(ptr, &record_len, TLG_MSG_RECORD_CHAT_USERNAME, msg.chat.username);
+    if(bot.get_msg_str(msg.caption, ptr + record_len, msg.caption.len+1))
+        put_str(ptr, &record_len, TLG_MSG_RECORD_CAPTION, ptr + record_len);
+    if((file_id != NULL) && bot.get_msg_str(*file_id, ptr + record_len, file_id->len+1))
+        put_str(ptr, &record_len, TLG_MSG_RECORD_FILE_ID, ptr + record_len);
+    record->size = (uint16_t)MSG_RECORD_ALIGN_SIZE(record_len);
+
+    return record->size;
+}
+
+// Set a record string (empty strings are not stored), the string can be already in its place
+void uTLGBotMsgQueue::put_str(char* record, size_t* record_len, const uint8_t str,
+    const char* value)
+{
+    size_t len = strlen(value);
+
+    if(len == 0)
+        return;
+
+    memmove(record + *record_len, value, len+1);
+    ((tlg_msg_record*)record)->str_pos[str] = (uint16_t)(*record_len);
+    *record_len = *record_len + len + 1;
+}
+
+/**************************************************************************************************/
+
+/* Lock-free Queues */
+
+#if defined(UTLGBOT_LOCKFREE_QUEUES) && !defined(ARDUINO) && !defined(ESP_IDF)
+
+// Constructor (empty update)
+uTLGBotUpdate::uTLGBotUpdate(void)
+{
+    _record = NULL;
+}
+
+// Move constructor (the moved update gets empty)
+uTLGBotUpdate::uTLGBotUpdate(uTLGBotUpdate&& update)
+{
+    _record = update._record;
+    update._record = NULL;
+}
+
+// Move assignment (the moved update gets empty)
+uTLGBotUpdate& uTLGBotUpdate::operator=(uTLGBotUpdate&& update)
+{
+    if(this != &update)
+    {
+        free(_record);
+        _record = update._record;
+        update._record = NULL;
+    }
+
+    return *this;
+}
+
+// Destructor
+uTLGBotUpdate::~uTLGBotUpdate(void)
+{
+    free(_record);
+}
+
+// Copy the last received message of the Bot (it must be done before any other Bot request, while
+// the message strings spans are valid)
+bool uTLGBotUpdate::take(uTLGBot& bot)
+{
+    size_t max_size = uTLGBotMsgQueue::record_max_size(bot);
+
+    free(_record);
+    _record = (max_size <= UINT16_MAX) ? (tlg_msg_record*)malloc(max_size) : NULL;
+    if(_record == NULL)
+        return false;
+    uTLGBotMsgQueue::pack(bot, (char*)_record);
+
+    return true;
+}
+
+// Get the message record (NULL if the update is empty)
+const tlg_msg_record* uTLGBotUpdate::get(void)
+{
+    return _record;
+}
+
+// Constructor (empty message)
+uTLGBotOutMsg::uTLGBotOutMsg(void)
+{
+    _chat_id = 0;
+    _reply_to_message_id = 0;
+    _strs = NULL;
+    _parse_mode_pos = 0;
+    _reply_markup_pos = 0;
+}
+
+// Constructor (all strings are kept in a single memory block)
+uTLGBotOutMsg::uTLGBotOutMsg(const int64_t chat_id, const char* text, const char* parse_mode,
+    const uint64_t reply_to_message_id, const char* reply_markup)
+{
+    size_t text_len = strlen(text);
+    size_t parse_mode_len = strlen(parse_mode);
+
+    _chat_id = chat_id;
+    _reply_to_message_id = reply_to_message_id;
+    _parse_mode_pos = text_len + 1;
+    _reply_markup_pos = _parse_mode_pos + parse_mode_len + 1;
+    _strs = (char*)malloc(_reply_markup_pos + strlen(reply_markup) + 1);
+    if(_strs == NULL)
+        return;
+    memcpy(_strs, text, text_len + 1);
+    memcpy(_strs + _parse_mode_pos, parse_mode, parse_mode_len + 1);
+    strcpy(_strs + _reply_markup_pos, reply_markup);
+}
+
+// Move constructor (the moved message gets empty)
+uTLGBotOutMsg::uTLGBotOutMsg(uTLGBotOutMsg&& msg)
+{
+    _chat_id = msg._chat_id;
+    _reply_to_message_id = msg._reply_to_message_id;
+    _strs = msg._strs;
+    _parse_mode_pos = msg._parse_mode_pos;
+    _reply_markup_pos = msg._reply_markup_pos;
+    msg._strs = NULL;
+}
+
+// Move assignment (the moved message gets empty)
+uTLGBotOutMsg& uTLGBotOutMsg::operator=(uTLGBotOutMsg&& msg)
+{
+    if(this != &msg)
+    {
+        free(_strs);
+        _chat_id = msg._chat_id;
+        _reply_to_message_id = msg._reply_to_message_id;
+        _strs = msg._strs;
+        _parse_mode_pos = msg._parse_mode_pos;
+        _reply_markup_pos = msg._reply_markup_pos;
+        msg._strs = NULL;
+    }
+
+    return *this;
+}
+
+// Destructor
+uTLGBotOutMsg::~uTLGBotOutMsg(void)
+{
+    free(_strs);
+}
+
+// Check if the message has content (it is not empty or moved)
+bool uTLGBotOutMsg::is_valid(void)
+{
+    return (_strs != NULL);
+}
+
+// Send the message with the Bot
+uint8_t uTLGBotOutMsg::send(uTLGBot& bot)
+{
+    if(_strs == NULL)
+        return false;
+
+    return bot.sendMessage(_chat_id, _strs, _strs + _parse_mode_pos, false, false,
+        _reply_to_message_id, _strs + _reply_markup_pos);
+}
+
+#endif
+
+/**************************************************************************************************/
+
+/* Bots Reactor */
+
+#if defined(UTLGBOT_REACTOR)
+
+// Reactor bots states (waiting to send the poll request, poll request connecting or being
+// written, poll request sent and waiting for its response, and waiting to retry a failed poll
+// request)
+#define REACTOR_BOT_IDLE 0
+#define REACTOR_BOT_REQUEST 1
+#define REACTOR_BOT_POLLING 2
+#define REACTOR_BOT_RETRY 3
+
+// Bots lists initial size
+#define REACTOR_INITIAL_BOTS 8
+
+// Socket event of a bot send connection (event data is the bot entry plus this flag)
+#define REACTOR_SEND_EVENT 0x80000000UL
+
+// Constructor
+uTLGBotReactor::uTLGBotReactor(void)
+{
+    _epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    _entries = NULL;
+    _timers = NULL;
+    _num_entries = 0;
+    _entries_size = 0;
+    _num_polling = 0;
+    #if defined(UTLGBOT_COROUTINES)
+        _num_sending = 0;
+    #endif
+}
+
+// Destructor (bots with a request in flight are disconnected, so their next request doesn't get
+// the pending response)
+uTLGBotReactor::~uTLGBotReactor(void)
+{
+    for(uint32_t i = 0; i < _num_entries; i++)
+    {
+        if((_entries[i].state == REACTOR_BOT_REQUEST) ||
+            (_entries[i].state == REACTOR_BOT_POLLING))
+        {
+            abort(i);
+        }
+        #if defined(UTLGBOT_COROUTINES)
+            if(_entries[i].send_fd != -1)
+            {
+                send_unwatch(i);
+                _entries[i].bot->_tx_path.client->disconnect();
+                _entries[i].bot->_co_sending = false;
+            }
+            _entries[i].bot->_reactor = NULL;
+            _entries[i].bot->co_destroy_waiters();
+        #endif
+    }
+    if(_epoll_fd != -1)
+        close(_epoll_fd);
+    free(_entries);
+    free(_timers);
+}
+
+// Add a bot to the reactor, its updates are requested from next run and provided to the handler
+// Note: The bot must not be used outside the reactor handlers while the reactor is running
+bool uTLGBotReactor::add_bot(uTLGBot& bot, tlg_reactor_update_handler handler, void* arg)
+{
+    if(handler == NULL)
+        return false;
+
+    return add_entry(bot, handler, arg);
+}
+
+#if defined(UTLGBOT_COROUTINES)
+// Add a bot to the reactor which updates are provided to the coroutines that await them (its
+// send requests path is split, so messages can be sent while its poll request is in flight)
+// Note: The bot coroutines must send the messages with send_message(), as the blocking send
+// methods use the same connection
+bool uTLGBotReactor::add_bot(uTLGBot& bot)
+{
+    if(!bot.split_paths())
+        return false;
+
+    return add_entry(bot, co_handler, NULL);
+}
+#endif
+
+// Add a bot entry to the reactor (ready to send its poll request)
+bool uTLGBotReactor::add_entry(uTLGBot& bot, tlg_reactor_update_handler handler, void* arg)
+{
+    tlg_reactor_entry* entries;
+    uint32_t* timers;
+    uint32_t size;
+
+    if(_epoll_fd == -1)
+        return false;
+    for(uint32_t i = 0; i < _num_entries; i++)
+    {
+        if(_entries[i].bot == &bot)
+            return false;
+    }
+
+    // Grow the bots lists if needed
+    if(_num_entries >= _entries_size)
+    {
+        size = (_entries_size == 0) ? REACTOR_INITIAL_BOTS : (_entries_size*2);
+        entries = (tlg_reactor_entry*)realloc(_entries, size*sizeof(tlg_reactor_entry));
+        if(entries == NULL)
+            return false;
+        _entries = entries;
+        timers = (uint32_t*)realloc(_timers, size*sizeof(uint32_t));
+        if(timers == NULL)
+            return false;
+        _timers = timers;
+        _entries_size = size;
+    }
+
+    // Add the bot, ready to send its poll request
+    _entries[_num_entries].bot = &bot;
+    _entries[_num_entries].handler = handler;
+    _entries[_num_entries].arg = arg;
+    _entries[_num_entries].timer_pos = _num_entries;
+    _entries[_num_entries].fd = -1;
+    _entries[_num_entries].state = REACTOR_BOT_IDLE;
+    #if defined(UTLGBOT_COROUTINES)
+        _entries[_num_entries].send_fd = -1;
+        bot._reactor = this;
+        bot._reactor_entry = _num_entries;
+    #endif
+    _timers[_num_entries] = _num_entries;
+    _num_entries = _num_entries + 1;
+    timer_set(_num_entries-1, _millis());
+
+    return true;
+}
+
+// Run the reactor once: Start the poll requests of the bots that are ready for it, wait up to
+// max_wait_ms for the bots connections (less if any bot timer expires before), run the requests
+// which connection is ready and handle received updates
+// Return the number of received updates
+uint32_t uTLGBotReactor::run_once(const unsigned long max_wait_ms)
+{
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+    unsigned long now;
+    unsigned long wait_ms;
+    uint32_t entry;
+    uint32_t num_updates = 0;
+    uint8_t num_arms = 0;
+    uint8_t update_type;
+    uint8_t state;
+    int num_events;
+
+    if(_epoll_fd == -1)
+        return 0;
+
+    // Handle expired bots timers (start poll requests, retry failed ones and drop the ones that
+    // are not connected or have no response in time)
+    now = _millis();
+    while((_num_entries > 0) && (num_arms < REACTOR_MAX_ARMS_PER_RUN))
+    {
+        entry = _timers[0];
+        if(time_before(now, _entries[entry].deadline))
+            break;
+        if((_entries[entry].state == REACTOR_BOT_REQUEST) ||
+            (_entries[entry].state == REACTOR_BOT_POLLING))
+        {
+            abort(entry);
+        }
+        num_updates = num_updates + arm(entry);
+        num_arms = num_arms + 1;
+        now = _millis();
+    }
+
+    // Wait for the connections until next bot timer expires
+    wait_ms = max_wait_ms;
+    if(_num_entries > 0)
+    {
+        if(!time_before(now, _entries[_timers[0]].deadline))
+            wait_ms = 0;
+        else if(_entries[_timers[0]].deadline - now < wait_ms)
+            wait_ms = _entries[_timers[0]].deadline - now;
+    }
+    #if defined(UTLGBOT_COROUTINES)
+        if(_num_sending > 0)
+            wait_ms = send_timeouts(now, wait_ms);
+    #endif
+    if(wait_ms > INT32_MAX)
+        wait_ms = INT32_MAX;
+    num_events = epoll_wait(_epoll_fd, events, REACTOR_MAX_EVENTS, (int)wait_ms);
+
+    // Run the requests which connection is ready, and provide received updates to the bots
+    // handlers (the next poll request of the bot is made after the ones of the bots that were
+    // already waiting for it)
+    for(int i = 0; i < num_events; i++)
+    {
+        entry = events[i].data.u32;
+        #if defined(UTLGBOT_COROUTINES)
+            // Send request of a bot coroutine
+            if((entry & REACTOR_SEND_EVENT) != 0)
+            {
+                entry = entry & ~REACTOR_SEND_EVENT;
+                if((entry < _num_entries) && (_entries[entry].send_fd != -1))
+                    send_run(entry);
+                continue;
+            }
+        #endif
+        if((entry >= _num_entries) || ((_entries[entry].state != REACTOR_BOT_REQUEST) &&
+            (_entries[entry].state != REACTOR_BOT_POLLING)))
+        {
+            continue;
+        }
+        state = _entries[entry].bot->getUpdates_run(&update_type);
+        num_updates = num_updates + poll_state(entry, state, update_type);
+    }
+
+    return num_updates;
+}
+
+// Get the number of bots in the reactor
+uint32_t uTLGBotReactor::get_num_bots(void)
+{
+    return _num_entries;
+}
+
+// Get the number of bots with a poll request in flight (sent and waiting for its response)
+uint32_t uTLGBotReactor::get_num_polling(void)
+{
+    return _num_polling;
+}
+
+// Start the bot poll request, with the timer set to the connection and write timeout
+// Return the number of received updates (if the request is already done)
+uint32_t uTLGBotReactor::arm(const uint32_t entry)
+{
+    uint8_t update_type;
+    uint8_t state;
+
+    _entries[entry].state = REACTOR_BOT_REQUEST;
+    timer_set(entry, _millis() + HTTP_WAIT_RESPONSE_TIMEOUT);
+    state = _entries[entry].bot->getUpdates_request(&update_type);
+
+    return poll_state(entry, state, update_type);
+}
+
+// Handle the state of the bot poll request after run it: Watch the file descriptor it waits for
+// while it is in flight (with the timer set to the response timeout once it is written), provide
+// the update to the bot handler once it is done (its next request is made after the ones of the
+// bots that were already waiting for it), or retry it later if it fails
+// Return the number of received updates
+uint32_t uTLGBotReactor::poll_state(const uint32_t entry, const uint8_t state,
+    const uint8_t update_type)
+{
+    tlg_reactor_entry* bot_entry = &_entries[entry];
+    uTLGBot* bot = bot_entry->bot;
+
+    // Request done (or dropped, so it is made again)
+    if((state == MULTIHTTPSCLIENT_ASYNC_DONE) || (state == MULTIHTTPSCLIENT_ASYNC_IDLE))
+    {
+        unwatch(entry);
+        timer_set(entry, _millis());
+        if(update_type == TLG_UPDATE_NONE)
+            return 0;
+        bot_entry->handler(*bot, update_type, bot_entry->arg);
+        return 1;
+    }
+
+    // Request in flight
+    if(state != MULTIHTTPSCLIENT_ASYNC_FAIL)
+    {
+        if(watch_fd(&bot_entry->fd, bot->_client.get_socket(), bot->_client.async_wait_write(),
+            entry))
+        {
+            if((state == MULTIHTTPSCLIENT_ASYNC_READ) &&
+                (bot_entry->state != REACTOR_BOT_POLLING))
+            {
+                bot_entry->state = REACTOR_BOT_POLLING;
+                _num_polling = _num_polling + 1;
+                timer_set(entry, _millis() + (bot->_long_poll_timeout*1000UL) +
+                    HTTP_WAIT_RESPONSE_TIMEOUT);
+            }
+            return 0;
+        }
+        bot->_client.disconnect();
+    }
+
+    // Request failed: retry it later
+    unwatch(entry);
+    bot_entry->state = REACTOR_BOT_RETRY;
+    timer_set(entry, _millis() + REACTOR_RETRY_MS);
+
+    return 0;
+}
+
+// Watch a file descriptor for readable or writable (out) events with the given event data, in
+// place of the one watched before (the file descriptor is always set, as the same number can be
+// a new socket)
+// Return false if it can't be watched
+bool uTLGBotReactor::watch_fd(int* watched_fd, const int fd, const bool out, const uint32_t data)
+{
+    struct epoll_event event;
+    int op;
+
+    if(fd == -1)
+        return false;
+    if((*watched_fd != -1) && (*watched_fd != fd))
+        epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, *watched_fd, NULL);
+
+    event.events = out ? EPOLLOUT : EPOLLIN;
+    event.data.u64 = 0;
+    event.data.u32 = data;
+    op = (*watched_fd == fd) ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+    *watched_fd = -1;
+    if(epoll_ctl(_epoll_fd, op, fd, &event) != 0)
+    {
+        if((op == EPOLL_CTL_MOD) && (errno == ENOENT))
+            op = EPOLL_CTL_ADD;
+        else if((op == EPOLL_CTL_ADD) && (errno == EEXIST))
+            op = EPOLL_CTL_MOD;
+        else
+            return false;
+        if(epoll_ctl(_epoll_fd, op, fd, &event) != 0)
+            return false;
+    }
+    *watched_fd = fd;
+
+    return true;
+}
+
+// Stop watching the bot connection
+void uTLGBotReactor::unwatch(const uint32_t entry)
+{
+    if(_entries[entry].fd != -1)
+        epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, _entries[entry].fd, NULL);
+    _entries[entry].fd = -1;
+    if(_entries[entry].state == REACTOR_BOT_POLLING)
+        _num_polling = _num_polling - 1;
+    _entries[entry].state = REACTOR_BOT_IDLE;
+}
+
+// Drop the bot poll request in flight (its connection is closed, so the next request doesn't get
+// the pending response)
+void uTLGBotReactor::abort(const uint32_t entry)
+{
+    unwatch(entry);
+    _entries[entry].bot->_client.disconnect();
+}
+
+#if defined(UTLGBOT_COROUTINES)
+
+// Watch the file descriptor that the send request of a bot coroutine waits for (the request fails
+// if it is not done in time since it was started)
+// Return false if it can't be watched
+bool uTLGBotReactor::send_watch(const uint32_t entry)
+{
+    MultiHTTPSClient* client = _entries[entry].bot->_tx_path.client;
+    bool started = (_entries[entry].send_fd == -1);
+
+    if(!watch_fd(&_entries[entry].send_fd, client->get_socket(), client->async_wait_write(),
+        entry | REACTOR_SEND_EVENT))
+    {
+        if(!started)
+            _num_sending = _num_sending - 1;
+        return false;
+    }
+    if(started)
+    {
+        _entries[entry].send_deadline = _millis() + HTTP_WAIT_RESPONSE_TIMEOUT;
+        _num_sending = _num_sending + 1;
+    }
+
+    return true;
+}
+
+// Run the send request of a bot coroutine (its connection is ready), until it has to wait again
+// or it ends (the coroutine is resumed with the result)
+void uTLGBotReactor::send_run(const uint32_t entry)
+{
+    uint8_t state;
+
+    state = _entries[entry].bot->_tx_path.client->async_run();
+    if((state != MULTIHTTPSCLIENT_ASYNC_DONE) && (state != MULTIHTTPSCLIENT_ASYNC_FAIL) &&
+        send_watch(entry))
+    {
+        return;
+    }
+    send_unwatch(entry);
+    _entries[entry].bot->co_send_response(state);
+}
+
+// Stop watching the bot send connection
+void uTLGBotReactor::send_unwatch(const uint32_t entry)
+{
+    if(_entries[entry].send_fd == -1)
+        return;
+    epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, _entries[entry].send_fd, NULL);
+    _entries[entry].send_fd = -1;
+    _num_sending = _num_sending - 1;
+}
+
+// Fail the sent messages without response in time and get the time to wait until next send
+// response deadline (or wait_ms if it is before)
+// Note: Just a few bots are usually sending at a time, so they are not kept in the timers heap
+unsigned long uTLGBotReactor::send_timeouts(const unsigned long now, unsigned long wait_ms)
+{
+    for(uint32_t i = 0; (i < _num_entries) && (_num_sending > 0); i++)
+    {
+        if(_entries[i].send_fd == -1)
+            continue;
+        if(!time_before(now, _entries[i].send_deadline))
+        {
+            send_unwatch(i);
+            _entries[i].bot->co_send_response(MULTIHTTPSCLIENT_ASYNC_IDLE);
+            if(_entries[i].send_fd == -1)
+                continue;
+        }
+        if(!time_before(now, _entries[i].send_deadline))
+            wait_ms = 0;
+        else if(_entries[i].send_deadline - now < wait_ms)
+            wait_ms = _entries[i].send_deadline - now;
+    }
+
+    return wait_ms;
+}
+
+// Update handler of the bots added without handler (provide the update to their coroutines)
+void uTLGBotReactor::co_handler(uTLGBot& bot, const uint8_t update_type, void* arg)
+{
+    (void)arg;
+    bot.co_update(update_type);
+}
+
+#endif
+
+// Set the bot timer deadline, keeping the timers min-heap ordered by deadline
+void uTLGBotReactor::timer_set(const uint32_t entry, const unsigned long deadline)
+{
+    uint32_t pos = _entries[entry].timer_pos;
+    uint32_t child;
+
+    _entries[entry].deadline = deadline;
+
+    // Move the timer up while it expires before its parent
+    while((pos > 0) && time_before(deadline, _entries[_timers[(pos-1)/2]].deadline))
+    {
+        timer_swap(pos, (pos-1)/2);
+        pos = (pos-1)/2;
+    }
+
+    // Move the timer down while any of its childs expires before it
+    while(1)
+    {
+        child = (2*pos) + 1;
+        if(child >= _num_entries)
+            break;
+        if((child+1 < _num_entries) && time_before(_entries[_timers[child+1]].deadline,
+            _entries[_timers[child]].deadline))
+        {
+            child = child + 1;
+        }
+        if(!time_before(_entries[_timers[child]].deadline, deadline))
+            break;
+        timer_swap(pos, child);
+        pos = child;
+    }
+}
+
+// Swap two timers of the timers min-heap
+void uTLGBotReactor::timer_swap(const uint32_t pos_a, const uint32_t pos_b)
+{
+    uint32_t entry = _timers[pos_a];
+
+    _timers[pos_a] = _timers[pos_b];
+    _timers[pos_b] = entry;
+    _entries[_timers[pos_a]].timer_pos = pos_a;
+    _entries[_timers[pos_b]].timer_pos = pos_b;
+}
+
+// Check if a time (in ms) is before other one (millis counter overflow safe)
+bool uTLGBotReactor::time_before(const unsigned long t_a, const unsigned long t_b)
+{
+    return ((long)(t_a - t_b) < 0);
+}
+
+#endif
+
+/**************************************************************************************************/
+
+/* Reactor Coroutines */
+
+#if defined(UTLGBOT_COROUTINES)
+
+// Destroy the coroutines of a waiting list (they are never resumed)
+static void co_destroy_list(tlg_co_waiter* waiter)
+{
+    tlg_co_waiter* next;
+
+    while(waiter != NULL)
+    {
+        next = waiter->next;
+        waiter->handle.destroy();
+        waiter = next;
+    }
+}
+
+// Wait for the next received update of the bot that no coroutine awaits for its chat
+uTLGBotUpdateAwaiter uTLGBot::next_update(void)
+{
+    return uTLGBotUpdateAwaiter(this, true, 0);
+}
+
+// Wait for the next received update (message or callback query) of a chat
+uTLGBotUpdateAwaiter uTLGBot::next_update(const int64_t chat_id)
+{
+    return uTLGBotUpdateAwaiter(this, false, chat_id);
+}
+
+// Send a text message to a chat without blocking the reactor thread (the strings must be valid
+// until the coroutine is resumed)
+uTLGBotSendAwaiter uTLGBot::send_message(const int64_t chat_id, const char* text,
+    const char* parse_mode, const uint64_t reply_to_message_id, const char* reply_markup)
+{
+    return uTLGBotSendAwaiter(this, chat_id, text, parse_mode, reply_to_message_id,
+        reply_markup);
+}
+
+// Resume the coroutine that waits for a received update: the oldest one that waits for its chat,
+// or else the oldest one that waits for any update (the update is discarded if there is none)
+void uTLGBot::co_update(const uint8_t update_type)
+{
+    tlg_co_waiter** link;
+    tlg_co_waiter** found = NULL;
+    tlg_co_waiter* waiter;
+    int64_t chat_id = 0;
+
+    if(update_type == TLG_UPDATE_MESSAGE)
+        chat_id = get_msg_chat_id();
+    else if(update_type == TLG_UPDATE_CALLBACK_QUERY)
+        chat_id = received_callback_query.chat_id;
+
+    // Chat lists have the newest coroutines first
+    link = &_co_chats[(uint64_t)chat_id % COROUTINES_CHAT_BUCKETS];
+    while(*link != NULL)
+    {
+        if((*link)->chat_id == chat_id)
+            found = link;
+        link = &((*link)->next);
+    }
+    if(found != NULL)
+    {
+        waiter = *found;
+        *found = waiter->next;
+    }
+    else if(_co_updates_head != NULL)
+    {
+        waiter = _co_updates_head;
+        _co_updates_head = waiter->next;
+        if(_co_updates_head == NULL)
+            _co_updates_tail = NULL;
+    }
+    else
+    {
+        _println("[Bot] Update discarded (no coroutine waits for it).");
+        return;
+    }
+
+    waiter->result = update_type;
+    waiter->handle.resume();
+}
+
+// Send the oldest queued message if there is no one in flight (the coroutines of the ones that
+// can't be sent are resumed with the fail result)
+void uTLGBot::co_send_next(void)
+{
+    tlg_co_waiter* waiter;
+
+    // Not while a resumed coroutine queues another message (the loop sends it)
+    if(_co_sends_running)
+        return;
+    _co_sends_running = true;
+    while(!_co_sending && (_co_sends_head != NULL))
+    {
+        waiter = _co_sends_head;
+        if(co_send_start(waiter))
+        {
+            _co_sending = true;
+            break;
+        }
+        _co_sends_head = waiter->next;
+        if(_co_sends_head == NULL)
+            _co_sends_tail = NULL;
+        waiter->handle.resume();
+    }
+    _co_sends_running = false;
+}
+
+// Start a queued message request through the send path (connecting to the server if needed) and
+// watch its connection, so the reactor runs it (if it is not started or already ended, the waiter
+// gets its result)
+bool uTLGBot::co_send_start(tlg_co_waiter* waiter)
+{
+    tlg_req_path* path = &_tx_path;
+    uint8_t state;
+
+    _sent_message_id = 0;
+    waiter->result = false;
+    if((_reactor == NULL) || !split_paths())
+        return false;
+
+    // Create HTTP Body request data
+    snprintf(path->buffer, HTTP_MAX_RES_LENGTH, "{\"chat_id\":%" PRId64, waiter->chat_id);
+    if(!create_msg_body_fields(path->buffer, HTTP_MAX_RES_LENGTH, waiter->text,
+        waiter->parse_mode, false, false, waiter->reply_to_message_id, waiter->reply_markup))
+    {
+        cant_create_send_msg(path, path->buffer);
+        return false;
+    }
+
+    // Start the request and watch its connection (the response is received in the same buffer)
+    _println("[Bot] Trying to send message request...");
+    _println("Mesage to send:");
+    _println(path->buffer);
+    _println("");
+    state = tlg_async_post(path, API_CMD_SEND_MSG, path->buffer, strlen(path->buffer));
+    if((state == MULTIHTTPSCLIENT_ASYNC_DONE) || (state == MULTIHTTPSCLIENT_ASYNC_FAIL))
+    {
+        waiter->result = co_send_end(state);
+        return false;
+    }
+    if(!_reactor->send_watch(_reactor_entry))
+    {
+        _println("[Bot] Command fail, request can't be sent.");
+        co_send_end(MULTIHTTPSCLIENT_ASYNC_FAIL);
+        return false;
+    }
+
+    return true;
+}
+
+// End the message request in flight with the state of its connection (done, fail, or any other
+// one if there was no response in time) and get the send result
+uint8_t uTLGBot::co_send_end(const uint8_t state)
+{
+    tlg_req_path* path = &_tx_path;
+    uint8_t result = false;
+
+    // Check the response
+    if(state == MULTIHTTPSCLIENT_ASYNC_FAIL)
+    {
+        _println("[Bot] Command fail, no response received.");
+        REQ_TIMING_ADD(path, 0, false);
+    }
+    else if(state != MULTIHTTPSCLIENT_ASYNC_DONE)
+    {
+        _println("[Bot] Command fail, response timeout.");
+        REQ_TIMING_ADD(path, 0, false);
+    }
+    else if(tlg_check(path, 0, path->buffer, HTTP_MAX_RES_LENGTH))
+    {
+        parse_sent_message_id(path);
+        result = true;
+    }
+
+    // Disconnect from telegram server (it aborts the request if it is still in flight)
+    if(!result || _dont_keep_connection)
+        path->client->disconnect();
+
+    return result;
+}
+
+// Read the response of the message in flight (or fail it if there was no response in time), resume
+// the coroutine of the sent one and send the next queued one
+void uTLGBot::co_send_response(const uint8_t state)
+{
+    tlg_co_waiter* waiter = _co_sends_head;
+
+    _co_sending = false;
+    if(waiter == NULL)
+        return;
+    _co_sends_head = waiter->next;
+    if(_co_sends_head == NULL)
+        _co_sends_tail = NULL;
+
+    // Resume the coroutine with the send result (its next message is queued after the ones
+    // already waiting)
+    waiter->result = co_send_end(state);
+    waiter->handle.resume();
+    co_send_next();
+}
+
+// Destroy all the coroutines that wait for the bot (the reactor is being destroyed)
+void uTLGBot::co_destroy_waiters(void)
+{
+    tlg_co_waiter* waiter;
+
+    waiter = _co_updates_head;
+    _co_updates_head = NULL;
+    _co_updates_tail = NULL;
+    co_destroy_list(waiter);
+    waiter = _co_sends_head;
+    _co_sends_head = NULL;
+    _co_sends_tail = NULL;
+    co_destroy_list(waiter);
+    for(uint32_t i = 0; i < COROUTINES_CHAT_BUCKETS; i++)
+    {
+        waiter = _co_chats[i];
+        _co_chats[i] = NULL;
+        co_destroy_list(waiter);
+    }
+}
+
+// Update awaiter constructor
+uTLGBotUpdateAwaiter::uTLGBotUpdateAwaiter(uTLGBot* bot, const bool any_chat,
+    const int64_t chat_id)
+{
+    _bot = bot;
+    _any_chat = any_chat;
+    _waiter.next = NULL;
+    _waiter.chat_id = chat_id;
+    _waiter.text = NULL;
+    _waiter.parse_mode = NULL;
+    _waiter.reply_markup = NULL;
+    _waiter.reply_to_message_id = 0;
+    _waiter.result = TLG_UPDATE_NONE;
+}
+
+// Updates are always received later by the reactor
+bool uTLGBotUpdateAwaiter::await_ready(void)
+{
+    return false;
+}
+
+// Link the coroutine in the bot waiting lists (it is not suspended if the bot is not run by a
+// reactor, and gets no update)
+bool uTLGBotUpdateAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    tlg_co_waiter** chat_list;
+
+    if(_bot->_reactor == NULL)
+        return false;
+    _waiter.handle = handle;
+    if(_any_chat)
+    {
+        if(_bot->_co_updates_tail == NULL)
+            _bot->_co_updates_head = &_waiter;
+        else
+            _bot->_co_updates_tail->next = &_waiter;
+        _bot->_co_updates_tail = &_waiter;
+    }
+    else
+    {
+        chat_list = &_bot->_co_chats[(uint64_t)_waiter.chat_id % COROUTINES_CHAT_BUCKETS];
+        _waiter.next = *chat_list;
+        *chat_list = &_waiter;
+    }
+
+    return true;
+}
+
+// Get the received update type
+uint8_t uTLGBotUpdateAwaiter::await_resume(void)
+{
+    return _waiter.result;
+}
+
+// Send awaiter constructor
+uTLGBotSendAwaiter::uTLGBotSendAwaiter(uTLGBot* bot, const int64_t chat_id, const char* text,
+    const char* parse_mode, const uint64_t reply_to_message_id, const char* reply_markup)
+{
+    _bot = bot;
+    _waiter.next = NULL;
+    _waiter.chat_id = chat_id;
+    _waiter.text = text;
+    _waiter.parse_mode = parse_mode;
+    _waiter.reply_markup = reply_markup;
+    _waiter.reply_to_message_id = reply_to_message_id;
+    _waiter.result = false;
+}
+
+// Responses are always received later by the reactor
+bool uTLGBotSendAwaiter::await_ready(void)
+{
+    return false;
+}
+
+// Send the message now if no other one is in flight or queue it (the coroutine is not suspended
+// if it can't be sent now, and gets the fail result)
+bool uTLGBotSendAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    _waiter.handle = handle;
+    if(!_bot->_co_sending && !_bot->_co_sends_running && (_bot->_co_sends_head == NULL))
+    {
+        if(!_bot->co_send_start(&_waiter))
+            return false;
+        _bot->_co_sending = true;
+    }
+    if(_bot->_co_sends_tail == NULL)
+        _bot->_co_sends_head = &_waiter;
+    else
+        _bot->_co_sends_tail->next = &_waiter;
+    _bot->_co_sends_tail = &_waiter;
+
+    return true;
+}
+
+// Get the send result
+uint8_t uTLGBotSendAwaiter::await_resume(void)
+{
+    return _waiter.result;
+}
+
+#endif
+
+/**************************************************************************************************/
+
+/* Updates Dispatcher */
+
+#if defined(UTLGBOT_DISPATCHER)
+
+// No pending update or chat
+#define DISPATCH_NONE UINT32_MAX
+
+// Constructor (the memory keeps the pending messages records)
+uTLGBotDispatcher::uTLGBotDispatcher(uTLGBot& bot, void* memory, const size_t size,
+    tlg_dispatch_handler handler, void* arg, const uint8_t num_workers) :
+    _bot(bot), _records(memory, size)
+{
+    _handler = handler;
+    _arg = arg;
+    _num_workers = num_workers;
+    if(_num_workers == 0)
+        _num_workers = 1;
+    if(_num_workers > DISPATCHER_MAX_WORKERS)
+        _num_workers = DISPATCHER_MAX_WORKERS;
+    _received_offset = UINT64_MAX;
+    _running = false;
+    _stop = false;
+    reset();
+}
+
+// Destructor
+uTLGBotDispatcher::~uTLGBotDispatcher(void)
+{
+    stop();
+}
+
+// Start the worker threads
+bool uTLGBotDispatcher::start(void)
+{
+    if(_running || (_handler == NULL))
+        return false;
+
+    _stop = false;
+    for(uint8_t i = 0; i < _num_workers; i++)
+        _workers[i] = std::thread(&uTLGBotDispatcher::worker_run, this, i);
+    _running = true;
+
+    return true;
+}
+
+// Stop the worker threads once they complete the message that they are handling (it must be
+// called from the polling thread). The updates from the oldest not completed one are not
+// confirmed, so the bot receives them again. Note that Telegram just confirms the updates before
+// an offset, so the updates completed after the oldest pending one are received again too
+// (at-least-once delivery)
+void uTLGBotDispatcher::stop(void)
+{
+    if(!_running)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _work_cv.notify_all();
+    for(uint8_t i = 0; i < _num_workers; i++)
+        _workers[i].join();
+    _running = false;
+
+    // Request again the updates from the oldest not completed one (the previous ones are
+    // completed)
+    commit();
+    if(_num_pending > 0)
+        _bot._last_received_msg = _slots[_oldest].update_id;
+    _bot._updates_commit = UINT64_MAX;
+    _bot._updates_limit = 1;
+    _received_offset = _bot._last_received_msg;
+    reset();
+}
+
+// Get the next update of the bot and dispatch it (received messages are handled by the workers).
+// It waits while the maximum number of updates are pending or the received ones fill the window,
+// and before request again if the response had no new update while some are pending
+// Return the received update type
+uint8_t uTLGBotDispatcher::poll(void)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    uint64_t last_received;
+    uint32_t pending;
+    uint32_t slot;
+    uint8_t update_type;
+    bool pushed = false;
+
+    if(!_running)
+        return TLG_UPDATE_NONE;
+
+    // Wait for a free pending update slot, and for a window of received and not confirmed updates
+    // (from the oldest pending one, including the completed ones after it) that lets a new update
+    // fit in the response
+    commit();
+    while((_num_pending > 0) && ((_num_pending >= DISPATCHER_MAX_PENDING) ||
+        (_window_len >= _window_max)))
+    {
+        _done_cv.wait(lock);
+        commit();
+    }
+
+    // Request the next update from the oldest not completed one, so the pending ones are not
+    // confirmed (the bot skips them in the response)
+    _bot._updates_commit = (_num_pending > 0) ? _slots[_oldest].update_id : UINT64_MAX;
+    _bot._updates_limit = (uint8_t)(_num_pending + 1);
+    last_received = _bot._last_received_msg;
+    lock.unlock();
+    update_type = _bot.getUpdates();
+    lock.lock();
+    _received_offset = _bot._last_received_msg;
+    if(_bot._last_received_msg == last_received)
+    {
+        // The new update didn't fit in the response with the pending ones, so the window must be
+        // smaller to request it again
+        if(_bot._updates_truncated)
+        {
+            _window_max = _window_len;
+            return TLG_UPDATE_NONE;
+        }
+
+        // The response had no new update but the pending ones (Telegram answers at once while
+        // there are pending ones), so wait for the oldest one to be completed, or some time to
+        // get the new updates of other chats, before request again
+        pending = _num_pending;
+        _done_cv.wait_for(lock, std::chrono::milliseconds(DISPATCHER_REPOLL_MS),
+            [this, pending]() { commit(); return (_num_pending < pending); });
+        return TLG_UPDATE_NONE;
+    }
+
+    // Keep a copy of the received message, waiting for older ones to be completed if there is no
+    // space for it (a message that doesn't fit in the empty memory is not dispatched)
+    if(update_type == TLG_UPDATE_MESSAGE)
+    {
+        pushed = _records.push(_bot);
+        while(!pushed && (_records.get_count() > 0))
+        {
+            _done_cv.wait(lock);
+            commit();
+            pushed = _records.push(_bot);
+        }
+    }
+
+    // Add the update to the pending ones (callback queries are already handled)
+    slot = (_oldest + _num_pending) % DISPATCHER_MAX_PENDING;
+    _slots[slot].update_id = _bot._last_received_msg - 1;
+    _slots[slot].record = pushed ? _records.back() : NULL;
+    _slots[slot].next = DISPATCH_NONE;
+    _slots[slot].len = _bot._update_len + 1;
+    _slots[slot].done = !pushed;
+    _num_pending = _num_pending + 1;
+    _window_len = _window_len + _slots[slot].len;
+    if(pushed)
+        dispatch(slot);
+
+    return update_type;
+}
+
+// Get the offset of the oldest not completed update (the updates before it are completed, and
+// they are confirmed to Telegram on next request)
+uint64_t uTLGBotDispatcher::get_commit_offset(void)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    commit();
+    if(_num_pending > 0)
+        return _slots[_oldest].update_id;
+    return _received_offset;
+}
+
+// Get the number of received and not completed updates
+uint32_t uTLGBotDispatcher::get_num_pending(void)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    commit();
+    return _num_pending;
+}
+
+// Worker thread: Handle the oldest message of a ready chat of this worker (or of other worker if
+// there is none), one at a time, until the dispatcher is stopped
+void uTLGBotDispatcher::worker_run(const uint8_t worker)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    uint32_t chat;
+    uint32_t slot;
+
+    while(!_stop)
+    {
+        // Get a ready chat (the whole chat queue moves to this worker if it was from other one)
+        chat = ready_pop(worker);
+        for(uint8_t i = 1; (chat == DISPATCH_NONE) && (i < _num_workers); i++)
+            chat = ready_pop((worker + i) % _num_workers);
+        if(chat == DISPATCH_NONE)
+        {
+            _work_cv.wait(lock);
+            continue;
+        }
+        _chats[chat].worker = worker;
+
+        // Handle the chat oldest message
+        slot = _chats[chat].head;
+        lock.unlock();
+        _handler(*(_slots[slot].record), worker, _arg);
+        lock.lock();
+
+        // Complete it and make the chat ready again if it has more messages
+        _slots[slot].done = true;
+        _chats[chat].head = _slots[slot].next;
+        if(_chats[chat].head == DISPATCH_NONE)
+            _chats[chat].used = false;
+        else
+            ready_push(worker, chat);
+        _done_cv.notify_all();
+    }
+}
+
+// Release the oldest completed updates (they leave the window, that can take again its maximum
+// length once it is empty)
+void uTLGBotDispatcher::commit(void)
+{
+    while((_num_pending > 0) && _slots[_oldest].done)
+    {
+        if(_slots[_oldest].record != NULL)
+            _records.pop();
+        _window_len = _window_len - _slots[_oldest].len;
+        _oldest = (_oldest + 1) % DISPATCHER_MAX_PENDING;
+        _num_pending = _num_pending - 1;
+    }
+    if(_num_pending == 0)
+        _window_max = UPDATES_WINDOW_MAX_LENGTH;
+}
+
+// Add a received message to the queue of its chat (a new chat queue goes to the worker given by
+// the chat ID)
+void uTLGBotDispatcher::dispatch(const uint32_t slot)
+{
+    int64_t chat_id = _slots[slot].record->chat_id;
+    uint32_t chat = DISPATCH_NONE;
+    uint32_t free_chat = DISPATCH_NONE;
+
+    // Find the chat queue
+    for(uint32_t i = 0; i < DISPATCHER_MAX_PENDING; i++)
+    {
+        if(!_chats[i].used)
+        {
+            if(free_chat == DISPATCH_NONE)
+                free_chat = i;
+        }
+        else if(_chats[i].chat_id == chat_id)
+        {
+            chat = i;
+            break;
+        }
+    }
+
+    // Add the message to the existing chat queue (it is already ready or being handled)
+    if(chat != DISPATCH_NONE)
+    {
+        _slots[_chats[chat].tail].next = slot;
+        _chats[chat].tail = slot;
+        return;
+    }
+
+    // Create the chat queue (there is always a free one, as each one has a pending message)
+    chat = free_chat;
+    _chats[chat].chat_id = chat_id;
+    _chats[chat].head = slot;
+    _chats[chat].tail = slot;
+    _chats[chat].used = true;
+    ready_push((uint8_t)((((uint64_t)chat_id * 0x9E3779B97F4A7C15ULL) >> 32) % _num_workers),
+        chat);
+    _work_cv.notify_one();
+}
+
+// Add a chat at the end of a worker ready chats list
+void uTLGBotDispatcher::ready_push(const uint8_t worker, const uint32_t chat)
+{
+    _chats[chat].worker = worker;
+    _chats[chat].next_ready = DISPATCH_NONE;
+    if(_ready_tail[worker] == DISPATCH_NONE)
+        _ready_head[worker] = chat;
+    else
+        _chats[_ready_tail[worker]].next_ready = chat;
+    _ready_tail[worker] = chat;
+}
+
+// Get and remove the first chat of a worker ready chats list
+uint32_t uTLGBotDispatcher::ready_pop(const uint8_t worker)
+{
+    uint32_t chat = _ready_head[worker];
+
+    if(chat == DISPATCH_NONE)
+        return DISPATCH_NONE;
+    _ready_head[worker] = _chats[chat].next_ready;
+    if(_ready_head[worker] == DISPATCH_NONE)
+        _ready_tail[worker] = DISPATCH_NONE;
+
+    return chat;
+}
+
+// Clear all pending updates, chat queues and workers ready lists
+void uTLGBotDispatcher::reset(void)
+{
+    _records.clear();
+    _oldest = 0;
+    _num_pending = 0;
+    _window_len = 0;
+    _window_max = UPDATES_WINDOW_MAX_LENGTH;
+    for(uint32_t i = 0; i < DISPATCHER_MAX_PENDING; i++)
+        _chats[i].used = false;
+    for(uint8_t i = 0; i < DISPATCHER_MAX_WORKERS; i++)
+    {
+        _ready_head[i] = DISPATCH_NONE;
+        _ready_tail[i] = DISPATCH_NONE;
+    }
+}
+
+#endif
+
+/**************************************************************************************************/
+
+/* Updates Fan-out */
+
+#if defined(UTLGBOT_FANOUT)
+
+// Shared memory format identifier
+#define FANOUT_MAGIC 0x46544C75
+
+// Ring slot size (published update ID followed by the record, that always fits as the record
+// strings come from the received data)
+#define FANOUT_SLOT_SIZE (((sizeof(uint64_t) + sizeof(tlg_msg_record) + HTTP_MAX_RES_LENGTH + \
+    TLG_MSG_RECORD_NUM_STRS) + TLG_CACHE_LINE_SIZE-1) & ~(size_t)(TLG_CACHE_LINE_SIZE-1))
+
+// Shared memory layout: header, workers rings indexes and workers rings slots
+#define FANOUT_RINGS_POS sizeof(tlg_fanout_header)
+#define FANOUT_SLOTS_POS(num_workers) (FANOUT_RINGS_POS + ((num_workers)*sizeof(tlg_fanout_ring)))
+#define FANOUT_SIZE(num_workers, num_slots, slot_size) (FANOUT_SLOTS_POS(num_workers) + \
+    ((size_t)(num_workers)*(num_slots)*(slot_size)))
+
+// Wait until a shared memory word changes from the given value (or timeout)
+static void fanout_wait(std::atomic<uint32_t>* word, const uint32_t value,
+    const unsigned long timeout_ms)
+{
+    struct timespec timeout;
+
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = (timeout_ms % 1000) * 1000000L;
+    syscall(SYS_futex, (uint32_t*)word, FUTEX_WAIT, value, &timeout, NULL, 0);
+}
+
+// Wake the processes that wait for a shared memory word change
+static void fanout_wake(std::atomic<uint32_t>* word)
+{
+    syscall(SYS_futex, (uint32_t*)word, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+}
+
+// Constructor
+uTLGBotFanout::uTLGBotFanout(void)
+{
+    _bot = NULL;
+    _fd = -1;
+    _memory = NULL;
+    _size = 0;
+    _header = NULL;
+    _rings = NULL;
+    _slots = NULL;
+    _name[0] = '\0';
+    _received_offset = UINT64_MAX;
+    _oldest = UINT64_MAX;
+    _num_pending = 0;
+    window_clear();
+    _worker = -1;
+}
+
+// Destructor
+uTLGBotFanout::~uTLGBotFanout(void)
+{
+    close();
+}
+
+// Create the shared memory rings of the workers and get ready to publish the bot updates (the
+// number of slots of each worker ring is rounded up to a power of two)
+// Note: The name is a POSIX shared memory object name (i.e. "/mybot_updates")
+bool uTLGBotFanout::create(uTLGBot& bot, const char* name, const uint8_t num_workers,
+    const uint32_t num_slots)
+{
+    uint32_t slots = 1;
+    size_t size;
+    int fd;
+
+    if((_memory != NULL) || (num_workers == 0) || (num_workers > FANOUT_MAX_WORKERS))
+        return false;
+    if((name != NULL) && (strlen(name) >= FANOUT_MAX_NAME_LENGTH))
+        return false;
+    while((slots < num_slots) && (slots < (1UL << 24)))
+        slots = slots * 2;
+    size = FANOUT_SIZE(num_workers, slots, FANOUT_SLOT_SIZE);
+
+    // Create the shared memory (empty, so all the indexes start at 0)
+    if(name != NULL)
+        fd = shm_open(name, O_CREAT | O_TRUNC | O_RDWR, 0600);
+    else
+        fd = memfd_create("utlgbot_fanout", 0);
+    if(fd == -1)
+        return false;
+    if((ftruncate(fd, size) != 0) || !map(fd, size))
+    {
+        ::close(fd);
+        if(name != NULL)
+            shm_unlink(name);
+        return false;
+    }
+    new (_header) tlg_fanout_header();
+    for(uint32_t i = 0; i < num_workers; i++)
+        new (&_rings[i]) tlg_fanout_ring();
+    _header->num_workers = num_workers;
+    _header->num_slots = slots;
+    _header->slot_size = FANOUT_SLOT_SIZE;
+    _header->magic.store(FANOUT_MAGIC, std::memory_order_release);
+    _slots = _memory + FANOUT_SLOTS_POS(num_workers);
+
+    _bot = &bot;
+    _fd = fd;
+    snprintf(_name, FANOUT_MAX_NAME_LENGTH, "%s", (name != NULL) ? name : "");
+    _received_offset = bot._last_received_msg;
+    _oldest = UINT64_MAX;
+    _num_pending = 0;
+    window_clear();
+    _worker = -1;
+
+    return true;
+}
+
+// Attach to the shared memory rings created by the polling process, as the given worker
+bool uTLGBotFanout::attach(const char* name, const uint8_t worker)
+{
+    bool attached;
+    int fd;
+
+    fd = shm_open(name, O_RDWR, 0);
+    if(fd == -1)
+        return false;
+    attached = attach(fd, worker);
+    ::close(fd);
+
+    return attached;
+}
+
+// Attach to the shared memory rings of the given memory file descriptor, as the given worker
+// (the file descriptor can be closed once attached)
+bool uTLGBotFanout::attach(const int fd, const uint8_t worker)
+{
+    struct stat info;
+
+    if((_memory != NULL) || (fstat(fd, &info) != 0) || ((size_t)info.st_size < FANOUT_RINGS_POS))
+        return false;
+    if(!map(fd, info.st_size))
+        return false;
+
+    // Check the shared memory format and the worker number
+    if((_header->magic.load(std::memory_order_acquire) != FANOUT_MAGIC) ||
+        (worker >= _header->num_workers) || (_size != FANOUT_SIZE(_header->num_workers,
+        _header->num_slots, _header->slot_size)))
+    {
+        close();
+        return false;
+    }
+    _slots = _memory + FANOUT_SLOTS_POS(_header->num_workers);
+    _worker = worker;
+
+    return true;
+}
+
+// Close the shared memory. The polling process wakes the workers (they see it closed) and the
+// updates from the oldest pending one are not confirmed, so the bot receives them again. Note
+// that Telegram just confirms the updates before an offset, so the updates acknowledged after
+// the oldest pending one are received again too (at-least-once delivery)
+void uTLGBotFanout::close(void)
+{
+    if(_memory == NULL)
+        return;
+
+    if(_bot != NULL)
+    {
+        _header->closed.store(1);
+        for(uint32_t i = 0; i < _header->num_workers; i++)
+            fanout_wake(&_rings[i].tail);
+
+        // Request again the updates from the oldest pending one (the previous ones are completed)
+        commit();
+        if(_num_pending > 0)
+            _bot->_last_received_msg = _oldest;
+        _bot->_updates_commit = UINT64_MAX;
+        _bot->_updates_limit = 1;
+    }
+    munmap(_memory, _size);
+    if(_fd != -1)
+        ::close(_fd);
+    if(_name[0] != '\0')
+        shm_unlink(_name);
+    _bot = NULL;
+    _fd = -1;
+    _memory = NULL;
+    _size = 0;
+    _header = NULL;
+    _rings = NULL;
+    _slots = NULL;
+    _name[0] = '\0';
+    _num_pending = 0;
+    window_clear();
+    _worker = -1;
+}
+
+// Check if the shared memory is attached and the polling process didn't close it
+bool uTLGBotFanout::is_open(void)
+{
+    return ((_header != NULL) && (_header->closed.load() == 0));
+}
+
+// Get the shared memory file descriptor of the polling process (-1 if not created)
+int uTLGBotFanout::get_fd(void)
+{
+    return _fd;
+}
+
+// Get the next update of the bot and publish it to the worker of its chat (polling process). It
+// waits while the maximum number of updates are pending or the worker ring is full
+// Return the received update type
+uint8_t uTLGBotFanout::poll(void)
+{
+    uint64_t last_received;
+    uint32_t acks;
+    uint8_t update_type;
+
+    if(_bot == NULL)
+        return TLG_UPDATE_NONE;
+
+    // Wait for a free pending update, and for a window of received and not confirmed updates
+    // (from the oldest pending one, including the acknowledged ones after it) that lets a new
+    // update fit in the response
+    while(1)
+    {
+        acks = _header->acks.load();
+        commit();
+        if((_num_pending == 0) || ((_num_pending < FANOUT_MAX_PENDING) &&
+            (_window_count < FANOUT_MAX_WINDOW) && (_window_len < _window_max)))
+        {
+            break;
+        }
+        wait_acks(acks, FANOUT_REPOLL_MS);
+    }
+
+    // Request the next update from the oldest not acknowledged one, so the pending ones and the
+    // acknowledged ones after it are not confirmed (the bot skips them in the response)
+    _bot->_updates_commit = _oldest;
+    _bot->_updates_limit = (_num_pending > 0) ? (uint8_t)(_window_count + 1) : 1;
+    last_received = _bot->_last_received_msg;
+    update_type = _bot->getUpdates();
+    _received_offset = _bot->_last_received_msg;
+    if(_bot->_last_received_msg == last_received)
+    {
+        // The new update didn't fit in the response with the pending ones, so the window must be
+        // smaller to request it again
+        if(_bot->_updates_truncated)
+        {
+            _window_max = _window_len;
+            return TLG_UPDATE_NONE;
+        }
+
+        // The response had no new update but the pending ones, so wait for any of them to be
+        // acknowledged before request again
+        if(_num_pending > 0)
+            wait_acks(acks, FANOUT_REPOLL_MS);
+        return TLG_UPDATE_NONE;
+    }
+
+    // Publish the received message (callback queries are already handled), and keep it in the
+    // window
+    if(update_type == TLG_UPDATE_MESSAGE)
+        publish();
+    window_add();
+
+    return update_type;
+}
+
+// Get the offset of the oldest not acknowledged update (the updates before it are completed, and
+// they are confirmed to Telegram on next request)
+uint64_t uTLGBotFanout::get_commit_offset(void)
+{
+    if(_bot == NULL)
+        return UINT64_MAX;
+
+    commit();
+    if(_num_pending > 0)
+        return _oldest;
+    return _received_offset;
+}
+
+// Get the number of published and not acknowledged updates
+uint32_t uTLGBotFanout::get_num_pending(void)
+{
+    if(_bot == NULL)
+        return 0;
+
+    commit();
+    return _num_pending;
+}
+
+// Get the oldest not acknowledged record of the worker ring, waiting up to timeout_ms for it
+// (worker process). The same record is provided until it is acknowledged
+// Return NULL if there is no record
+const tlg_msg_record* uTLGBotFanout::receive(const unsigned long timeout_ms)
+{
+    tlg_fanout_ring* ring;
+    uint32_t head;
+
+    if((_header == NULL) || (_worker == -1))
+        return NULL;
+
+    // Wait for a published record (the polling process wakes the worker if it sees it waiting)
+    ring = &_rings[_worker];
+    head = ring->head.load(std::memory_order_relaxed);
+    if((ring->tail.load(std::memory_order_acquire) == head) && (timeout_ms > 0))
+    {
+        ring->worker_waiting.store(1);
+        if((ring->tail.load() == head) && (_header->closed.load() == 0))
+            fanout_wait(&ring->tail, head, timeout_ms);
+        ring->worker_waiting.store(0);
+    }
+    if(ring->tail.load(std::memory_order_acquire) == head)
+        return NULL;
+
+    return (const tlg_msg_record*)(slot(_worker, head) + sizeof(uint64_t));
+}
+
+// Acknowledge the received record once it is handled (worker process)
+// Return false if there is no record to acknowledge
+bool uTLGBotFanout::ack(void)
+{
+    tlg_fanout_ring* ring;
+    uint32_t head;
+
+    if((_header == NULL) || (_worker == -1))
+        return false;
+
+    ring = &_rings[_worker];
+    head = ring->head.load(std::memory_order_relaxed);
+    if(ring->tail.load(std::memory_order_acquire) == head)
+        return false;
+    ring->head.store(head + 1, std::memory_order_release);
+    _header->acks.fetch_add(1);
+    if(_header->poller_waiting.load() != 0)
+        fanout_wake(&_header->acks);
+
+    return true;
+}
+
+// Map the shared memory of the given file descriptor (the slots position is set once the header
+// is valid)
+bool uTLGBotFanout::map(const int fd, const size_t size)
+{
+    void* memory;
+
+    memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(memory == MAP_FAILED)
+        return false;
+    _memory = (char*)memory;
+    _size = size;
+    _header = (tlg_fanout_header*)_memory;
+    _rings = (tlg_fanout_ring*)(_memory + FANOUT_RINGS_POS);
+
+    return true;
+}
+
+// Get a slot of a worker ring (the index is wrapped to the ring size)
+char* uTLGBotFanout::slot(const uint32_t worker, const uint32_t index)
+{
+    return _slots + (((size_t)worker*_header->num_slots) + (index & (_header->num_slots-1))) *
+        _header->slot_size;
+}
+
+// Get the number of not acknowledged updates of all the workers and the oldest one
+void uTLGBotFanout::commit(void)
+{
+    uint64_t update_id;
+    uint32_t head;
+    uint32_t pending;
+
+    _num_pending = 0;
+    _oldest = UINT64_MAX;
+    for(uint32_t i = 0; i < _header->num_workers; i++)
+    {
+        head = _rings[i].head.load(std::memory_order_acquire);
+        pending = _rings[i].tail.load(std::memory_order_relaxed) - head;
+        if(pending == 0)
+            continue;
+        _num_pending = _num_pending + pending;
+        memcpy(&update_id, slot(i, head), sizeof(uint64_t));
+        if(update_id < _oldest)
+            _oldest = update_id;
+    }
+
+    // Drop the received updates before the oldest pending one from the window (they are
+    // confirmed on next request), it can take again its maximum length once it is empty
+    while((_window_count > 0) && (_window[_window_head].update_id < _oldest))
+    {
+        _window_len = _window_len - _window[_window_head].len;
+        _window_head = (_window_head + 1) % FANOUT_MAX_WINDOW;
+        _window_count = _window_count - 1;
+    }
+    if(_window_count == 0)
+        _window_max = UPDATES_WINDOW_MAX_LENGTH;
+}
+
+// Publish the last received message of the bot in the ring of the worker of its chat, waiting for
+// a free slot if it is full
+bool uTLGBotFanout::publish(void)
+{
+    int64_t chat_id = _bot->get_msg_chat_id();
+    uint64_t update_id = _bot->_last_received_msg - 1;
+    uint32_t worker;
+    uint32_t tail;
+    uint32_t acks;
+    tlg_fanout_ring* ring;
+    char* ptr;
+
+    if(uTLGBotMsgQueue::record_max_size(*_bot) > _header->slot_size - sizeof(uint64_t))
+        return false;
+
+    // Get the worker of the chat and wait for a free slot in its ring
+    worker = (uint32_t)((((uint64_t)chat_id * 0x9E3779B97F4A7C15ULL) >> 32) %
+        _header->num_workers);
+    ring = &_rings[worker];
+    tail = ring->tail.load(std::memory_order_relaxed);
+    while(1)
+    {
+        acks = _header->acks.load();
+        if(tail - ring->head.load(std::memory_order_acquire) < _header->num_slots)
+            break;
+        wait_acks(acks, FANOUT_REPOLL_MS);
+    }
+
+    // Fill the slot and publish it (the worker is woken if it sees it waiting)
+    ptr = slot(worker, tail);
+    memcpy(ptr, &update_id, sizeof(uint64_t));
+    uTLGBotMsgQueue::pack(*_bot, ptr + sizeof(uint64_t));
+    ring->tail.store(tail + 1, std::memory_order_release);
+    if(ring->worker_waiting.load() != 0)
+        fanout_wake(&ring->tail);
+
+    return true;
+}
+
+// Add the last received update of the bot to the window (there is always space, as it is not
+// requested while the window is full)
+void uTLGBotFanout::window_add(void)
+{
+    tlg_fanout_received* received;
+
+    if(_window_count >= FANOUT_MAX_WINDOW)
+        return;
+    received = &_window[(_window_head + _window_count) % FANOUT_MAX_WINDOW];
+    received->update_id = _bot->_last_received_msg - 1;
+    received->len = _bot->_update_len + 1;
+    _window_count = _window_count + 1;
+    _window_len = _window_len + received->len;
+}
+
+// Clear the window of received and not confirmed updates
+void uTLGBotFanout::window_clear(void)
+{
+    _window_head = 0;
+    _window_count = 0;
+    _window_len = 0;
+    _window_max = UPDATES_WINDOW_MAX_LENGTH;
+}
+
+// Wait until any worker acknowledges a record after the acks counter got the given value
+void uTLGBotFanout::wait_acks(const uint32_t acks, const unsigned long timeout_ms)
+{
+    _header->poller_waiting.store(1);
+    if(_header->acks.load() == acks)
+        fanout_wait(&_header->acks, acks, timeout_ms);
+    _header->poller_waiting.store(0);
+}
+
+#endif
+
+/**************************************************************************************************/
+
+/* Telegram API GET and POST Methods */
+
+// Make and send a HTTP GET request
+uint8_t uTLGBot::tlg_get(tlg_req_path* path, const char* command, char* response,
+    const size_t response_len, const unsigned long response_timeout)
+{
+    char uri[HTTP_MAX_URI_LENGTH];
+
+    // Create URI and send GET request
+    snprintf(uri, HTTP_MAX_URI_LENGTH, "%s/%s", _tlg_api, command);
+    return tlg_check(path, path->client->get(uri, TELEGRAM_HOST, response, response_len,
+        response_timeout), response, response_len);
+}
+
+// Make and send a HTTP POST request
+uint8_t uTLGBot::tlg_post(tlg_req_path* path, const char* command, char* request_response,
+    const size_t request_len, const size_t request_response_max_size,
+    const unsigned long response_timeout)
+{
+    char uri[HTTP_MAX_URI_LENGTH];
+
+    // Create URI and send POST request
+    snprintf(uri, HTTP_MAX_URI_LENGTH, "%s/%s", _tlg_api, command);
+    return tlg_check(path, path->client->post(uri, TELEGRAM_HOST, request_response, request_len,
+        request_response_max_size, response_timeout), request_response, request_response_max_size);
+}
+
+#if defined(UTLGBOT_REACTOR)
+
+// Start a HTTP POST request without waiting for it (it is run when its connection is ready, and
+// the response is received in the path buffer)
+// Return the request state (see MultiHTTPSClient::async_run())
+uint8_t uTLGBot::tlg_async_post(tlg_req_path* path, const char* command, const char* body,
+    const size_t body_len)
+{
+    char uri[HTTP_MAX_URI_LENGTH];
+
+    // Create URI and start POST request
+    snprintf(uri, HTTP_MAX_URI_LENGTH, "%s/%s", _tlg_api, command);
+    return path->client->async_post(TELEGRAM_HOST, HTTPS_PORT, uri, body, body_len,
+        path->buffer, HTTP_MAX_RES_LENGTH);
+}
+
+#endif
+
+// Make and send a HTTP POST request which body is provided in parts (body parts are not modified)
+uint8_t uTLGBot::tlg_post_parts(tlg_req_path* path, const char* command,
+    const char* const* body_parts, const size_t* body_parts_len, const uint8_t num_body_parts,
+    char* response, const size_t response_max_size, const unsigned long response_timeout)
+{
+    char uri[HTTP_MAX_URI_LENGTH];
+
+    // Create URI and send POST request
+    snprintf(uri, HTTP_MAX_URI_LENGTH, "%s/%s", _tlg_api, command);
+    return tlg_check(path, path->client->post_parts(uri, TELEGRAM_HOST, body_parts,
+        body_parts_len, num_body_parts, response, response_max_size, response_timeout), response,
+        response_max_size);
+}
+
+// Check the result of a HTTP request (client return code) and its response
+uint8_t uTLGBot::tlg_check(tlg_req_path* path, const uint8_t http_rc, const char* response,
+    const size_t response_max_size)
+{
+    uint8_t rc;
+
+    path->response_received = (http_rc == 0);
+    if(http_rc > 0)
+    {
+        REQ_TIMING_ADD(path, 0, false);
+        return false;
+    }
+
+    #if defined(UTLGBOT_TIMING)
+        uint64_t t0 = _micros();
+        rc = tlg_parse_response(path, response, response_max_size);
+        timing_add(path, _micros() - t0, rc);
+    #else
+        rc = tlg_parse_response(path, response, response_max_size);
+    #endif
+
+    return rc;
+}
+
+#if defined(UTLGBOT_TIMING)
+// Set the response check time and result of the last request of a path, and add them to its
+// total times
+void uTLGBot::timing_add(tlg_req_path* path, const uint64_t check_us, const bool ok)
+{
+    path->timing_last.check_us = check_us;
+    path->timing_last.errors = ok ? 0 : 1;
+    path->timing_total.check_us = path->timing_total.check_us + check_us;
+    path->timing_total.errors = path->timing_total.errors + path->timing_last.errors;
+}
+#endif
+
+// Check received HTTP response in a single pass (status code and "ok" value) and get the position
+// and length of the "result" attribute json value in the buffer (the buffer is not modified)
+// i.e. for response: {"ok":true,"result":[{"id":123456789,"first_name":"esp8266_Bot"}]}
+// result is: [{"id":123456789,"first_name":"esp8266_Bot"}]
+uint8_t uTLGBot::tlg_parse_response(tlg_req_path* path, const char* response,
+    const size_t response_max_size)
+{
+    const char* end;
+    const char* body;
+    uint16_t status;
+    size_t response_len;
+    size_t pos;
+    int32_t header_end;
+    int32_t value_end;
+    bool ok = false;
+    bool result_found = false;
+
+    path->result_pos = 0;
+    path->result_len = 0;
+
+    // Check response status line (i.e. "HTTP/1.1 200 OK")
+    end = (const char*)memchr(response, '\0', response_max_size);
+    response_len = (end != NULL) ? (size_t)(end - response) : response_max_size;
+    if((response_len < 12) || (strncmp(response, "HTTP/1.", strlen("HTTP/1.")) != 0))
+    {
+        _println("[Bot] Unexpected response.");
+        return false;
+    }
+    status = ((response[9]-'0')*100) + ((response[10]-'0')*10) + (response[11]-'0');
+
+    // Skip response header (just check response body)
+    header_end = cstr_get_substr_pos_end(response, response_len, "\r\n\r\n",
+        strlen("\r\n\r\n"));
+    if(header_end == -1)
+    {
+        _println("[Bot] Unexpected response.");
+        return false;
+    }
+    body = response + header_end;
+    response_len = response_len - header_end;
+
+    // Walk the response root object keys, skipping their values (in any order)
+    pos = json_skip_spaces(body, response_len, 0);
+    if((pos >= response_len) || (body[pos] != '{'))
+    {
+        _println("[Bot] Unexpected response.");
+        _println(body);
+        return false;
+    }
+    pos = json_skip_spaces(body, response_len, pos+1);
+    while((pos < response_len) && (body[pos] == '"'))
+    {
+        // Get key and value positions
+        value_end = json_skip_value(body, response_len, pos);
+        if(value_end == -1)
+            break;
+        const char* key = body + pos + 1;
+        size_t key_len = value_end - pos - 2;
+        pos = json_skip_spaces(body, response_len, value_end);
+        if((pos >= response_len) || (body[pos] != ':'))
+            break;
+        pos = json_skip_spaces(body, response_len, pos+1);
+        value_end = json_skip_value(body, response_len, pos);
+        if(value_end == -1)
+            break;
+
+        // Check "ok" value and get "result" value position
+        if((key_len == strlen("ok")) && (strncmp(key, "ok", key_len) == 0))
+            ok = (strncmp(body+pos, "true", strlen("true")) == 0);
+        else if((key_len == strlen("result")) && (strncmp(key, "result", key_len) == 0))
+        {
+            path->result_pos = (uint32_t)((body + pos) - response);
+            path->result_len = (uint32_t)(value_end - pos);
+            result_found = true;
+        }
+
+        // Go to next key
+        pos = json_skip_spaces(body, response_len, value_end);
+        if((pos < response_len) && (body[pos] == ','))
+            pos = json_skip_spaces(body, response_len, pos+1);
+    }
+
+    // Check that request was successful
+    if((status != 200) || !ok)
+    {
+        _printf("[Bot] Bad request (HTTP status %" PRIu16 ").\n", status);
+        _println(body);
+        path->result_len = 0;
+        return false;
+    }
+    if(!result_found)
+    {
+        _println("[Bot] Unexpected response.");
+        _println(body);
+        return false;
+    }
+
+    return true;
+}
+
+/**************************************************************************************************/
+
+/* Private Auxiliar Methods */
+
+// Clear and set all received message data to default values (just the fields present in the
+// last received message, as absent ones were not modified)
+void uTLGBot::clear_msg_data(void)
+{
+    json_clear_object(tlg_message_fields, TLG_FIELDS_NUM(tlg_message_fields), &received_msg,
+        received_msg.present);
+    received_msg.present = 0;
+    _msg_pending_fields = 0;
+}
+
+// Decode the given fields (TLG_MSG_HAS_* bits) of the received message that were not decoded yet
+// (lazy decode)
+void uTLGBot::msg_decode_fields(const uint32_t fields)
+{
+    uint32_t pending = _msg_pending_fields & fields;
+
+    if(pending == 0)
+        return;
+
+    // Decode each field from its value (the message object is not walked again)
+    for(uint8_t f = 0; f < TLG_MSG_NUM_FIELDS; f++)
+    {
+        if(pending & (1UL << f))
+        {
+            json_decode_value(_msg_json_str, _msg_field_tokens[f], &tlg_message_fields[f],
+                &received_msg);
+        }
+    }
+    if((pending & TLG_MSG_CHAT_ID_ONLY) && !(pending & TLG_MSG_HAS_CHAT) &&
+        (_json_elements[_msg_field_tokens[TLG_MSG_FIELD_CHAT]].type == JSMN_OBJECT))
+    {
+        json_decode_object(_msg_json_str, _msg_field_tokens[TLG_MSG_FIELD_CHAT],
+            tlg_chat_id_fields, TLG_FIELDS_NUM(tlg_chat_id_fields), &received_msg.chat);
+    }
+    _msg_pending_fields = _msg_pending_fields & ~pending;
+
+    // Chat ID is decoded with the full chat
+    if(pending & TLG_MSG_HAS_CHAT)
+        _msg_pending_fields = _msg_pending_fields & ~TLG_MSG_CHAT_ID_ONLY;
+}
+
+// Decode all the received message fields not decoded yet in a single pass (before the data buffer
+// is reused)
+void uTLGBot::msg_decode_pending(void)
+{
+    msg_decode_fields(_msg_pending_fields);
+}
+
+// Release the received data buffer to be reused by a new request (lazy fields not decoded yet are
+// decoded, and received message strings spans are not valid anymore)
+void uTLGBot::msg_release_buffer(void)
+{
+    msg_decode_pending();
+    _msg_spans_valid = false;
+}
+
+// Get the working memory to use it for a new request, releasing the received data of the bot
+// that used it last (this one, or other bot that shares the arena)
+// Return false if there is no working memory
+bool uTLGBot::arena_acquire(void)
+{
+    if(_buffer == NULL)
+    {
+        _println("[Bot] Error: Not enough working memory.");
+        return false;
+    }
+
+    if((_arena->_owner != NULL) && (_arena->_owner != this))
+        _arena->_owner->msg_release_buffer();
+    _arena->_owner = this;
+    msg_release_buffer();
+
+    return true;
+}
+
+// Get the working memory for a getUpdates request, the received message is replaced by the
+// response, so in lazy decode mode its fields not decoded yet are dropped instead of decoded
+// Return false if there is no working memory
+bool uTLGBot::updates_arena_acquire(void)
+{
+    if(_lazy_decode)
+        clear_msg_data();
+
+    return arena_acquire();
+}
+
+// Get the path for a new send request: the send path if it is split, or the receive path after
+// get its working memory (received data in it is released, as it is reused)
+// Return NULL if there is no working memory
+tlg_req_path* uTLGBot::send_path(void)
+{
+    #if defined(UTLGBOT_SPLIT_PATHS)
+        if(_tx_path.client != NULL)
+            return &_tx_path;
+    #endif
+
+    if(!arena_acquire())
+        return NULL;
+
+    return &_rx_path;
+}
+
+// Create all sendMessage JSON body fields but chat_id, appending them to the provided body
+// (i.e. body: {"chat_id":1234 -> {"chat_id":1234,"text":"Hello",...})
+bool uTLGBot::create_msg_body_fields(char* body, const size_t body_max_size, const char* text,
+    const char* parse_mode, bool disable_web_page_preview, bool disable_notification,
+    uint64_t reply_to_message_id, const char* reply_markup)
+{
+    char tmp[MAX_TMP_BUFFER_LENGTH];
+    size_t body_len;
+
+    // Append text (JSON escaped to keep the request valid)
+    if(!cstr_strncat(body, body_max_size, ",\"text\":\"", strlen(",\"text\":\"")))
+        return false;
+    body_len = strlen(body);
+    if(json_escape_str(text, strlen(text), body+body_len, body_max_size-body_len) == -1)
+        return false;
+    if(!cstr_strncat(body, body_max_size, "\"", strlen("\"")))
+        return false;
+
+    // Append parse_mode if it is not empty
+    if(parse_mode[0] != '\0')
+    {
+        // If parse mode has an expected value
+        if((strcmp(parse_mode, "Markdown") == 0) || (strcmp(parse_mode, "HTML") == 0))
+        {
+            snprintf(tmp, MAX_TMP_BUFFER_LENGTH, ",\"parse_mode\":\"%s\"", parse_mode);
+            if(!cstr_strncat(body, body_max_size, tmp, strlen(tmp)))
+                return false;
+        }
+        else
+            _println("[Bot] Warning: Invalid parse_mode provided.");
+    }
+
+    // Append disable_web_page_preview value if true
+    if(disable_web_page_preview)
+    {
+        if(!cstr_strncat(body, body_max_size, ",\"disable_web_page_preview\":true",
+            strlen(",\"disable_web_page_preview\":true")))
+        {
+            return false;
+        }
+    }
+
+    // Append disable_notification value if true
+    if(disable_notification)
+    {
+        if(!cstr_strncat(body, body_max_size, ",\"disable_notification\":true",
+            strlen(",\"disable_notification\":true")))
+        {
+            return false;
+        }
+    }
+
+    // Append reply_to_message_id value if set
+    if(reply_to_message_id != 0)
+    {
+        snprintf(tmp, MAX_TMP_BUFFER_LENGTH, ",\"reply_to_message_id\":%" PRIu64,
+            reply_to_message_id);
+        if(!cstr_strncat(body, body_max_size, tmp, strlen(tmp)))
+            return false;
+    }
+
+    // Append reply_markup if it is not empty
+    if(reply_markup[0] != '\0')
+    {
+        if(!cstr_strncat(body, body_max_size, ",\"reply_markup\":", strlen(",\"reply_markup\":")))
+            return false;
+        if(!cstr_strncat(body, body_max_size, reply_markup, strlen(reply_markup)))
+            return false;
+    }
+
+    // Close JSON body
+    return cstr_strncat(body, body_max_size, "}", strlen("}"));
+}
+
+// Clear and set all received callback query data to default values
+void uTLGBot::clear_callback_query_data(void)
+{
+    json_clear_object(tlg_callback_query_fields, TLG_FIELDS_NUM(tlg_callback_query_fields),
+        &received_callback_query);
+    received_callback_query.data_len = 0;
+}
+
+// Get the callback query fields from the callback query json object (token position)
+uint8_t uTLGBot::parse_callback_query(const char* json_str, const uint32_t obj_token)
+{
+    clear_msg_data();
+    clear_callback_query_data();
+    _callback_query_answered = false;
+
+    if(_json_elements[obj_token].type != JSMN_OBJECT)
+    {
+        _println("[Bot] Error: Invalid callback query.");
+        return false;
+    }
+
+    // Decode the callback query object
+    json_decode_object(json_str, obj_token, tlg_callback_query_fields,
+        TLG_FIELDS_NUM(tlg_callback_query_fields), &received_callback_query);
+    if(received_callback_query.id[0] == '\0')
+    {
+        _println("[Bot] Error: Callback query without id.");
+        return false;
+    }
+    received_callback_query.data_len = strlen(received_callback_query.data);
+
+    return true;
+}
+
+// Call the first callback query handler which data prefix match the received callback query data
+// and answer the callback query if the handler didn't (to stop the button "loading" state as soon
+// as possible and before any other request of the application)
+void uTLGBot::dispatch_callback_query(void)
+{
+    tlg_callback_query_entry* entry;
+
+    _printf("[Bot] Callback query received (data: %s).\n", received_callback_query.data);
+    for(uint8_t i = 0; i < _num_callback_query_handlers; i++)
+    {
+        entry = &_callback_query_handlers[i];
+        if(entry->data_prefix_len > received_callback_query.data_len)
+            continue;
+        if(memcmp(entry->data_prefix, received_callback_query.data, entry->data_prefix_len) != 0)
+            continue;
+
+        entry->handler(*this, received_callback_query, entry->arg);
+        break;
+    }
+
+    if(!_callback_query_answered)
+        answerCallbackQuery(received_callback_query.id);
+}
+
+// Get the message ID from a sent message response (Message object kept in the buffer)
+// Note: "message_id" is the first Message attribute, so the first match belongs to the sent message
+// and not to a nested one (i.e. reply_to_message)
+void uTLGBot::parse_sent_message_id(tlg_req_path* path)
+{
+    int32_t pos;
+
+    _sent_message_id = 0;
+    pos = cstr_get_substr_pos_end(path->buffer+path->result_pos, path->result_len,
+        "\"message_id\":", strlen("\"message_id\":"));
+    if(pos == -1)
+        return;
+    pos = pos + path->result_pos;
+    cstr_to_int64(path->buffer+pos, strspn(path->buffer+pos, "-0123456789"), &_sent_message_id);
+}
+
+// Send message fail to be created
+void uTLGBot::cant_create_send_msg(tlg_req_path* path, const char* msg)
+{
+    _println("[Bot] Can't create send message:");
+    _println(msg);
+
+    // Disconnect from telegram server
+    if(path->client->is_connected())
+        path_disconnect(path);
+}
+
+// Parse and get each json elements from provided json format string into the JSON tokens pool
+// If the pool is too small, the needed tokens are counted and the pool is grown (Generic devices)
+uint32_t uTLGBot::json_parse_str(const char* json_str, const size_t json_str_len)
+{
+    jsmn_parser json_parser;
+    int num_elements;
+
+    num_elements = json_tokenize(json_str, json_str_len);
+    if(num_elements == JSMN_ERROR_NOMEM)
+    {
+        // Count the needed tokens (jsmn without tokens array) and parse again in a bigger pool
+        jsmn_init(&json_parser);
+        num_elements = jsmn_parse(&json_parser, json_str, json_str_len, NULL, 0);
+        if(num_elements > 0)
+        {
+            if(json_reserve_tokens(num_elements))
+                num_elements = json_tokenize(json_str, json_str_len);
+            else
+                num_elements = JSMN_ERROR_NOMEM;
+        }
+    }
+    if(num_elements < 0)
+    {
+#if defined(ARDUINO) // ESP32 Arduino Framework
+        _print("Can't parse JSON data. Code ");
+        _println(num_elements);
+        _println();
+#else
+        _printf("Can't parse JSON data. Code %d\n", num_elements);
+#endif
+        return 0;
+    }
+    if((num_elements == 0) || (_json_elements[0].type != JSMN_OBJECT))
+    {
+        _println("Can't parse JSON data (invalid sintax?).");
+        return 0;
+    }
+
+    return num_elements;
+}
+
+// Tokenize a json format string into the JSON tokens pool (number of tokens or jsmn error code)
+int uTLGBot::json_tokenize(const char* json_str, const size_t json_str_len)
+{
+#if defined(UTLGBOT_SIMD_WIDTH)
+    return json_simd_parse(json_str, json_str_len, _json_elements, _json_elements_size);
+#else
+    jsmn_parser json_parser;
+    jsmn_init(&json_parser);
+    return jsmn_parse(&json_parser, json_str, json_str_len, _json_elements, _json_elements_size);
+#endif
+}
+
+// Make sure the JSON tokens pool has at least the provided number of tokens
+// Generic devices grow the pool (at least doubling its size, so it quickly reaches the size needed
+// by the biggest received updates and then it is just reused), ESP32 devices have a fixed pool
+bool uTLGBot::json_reserve_tokens(const uint32_t num_tokens)
+{
+    if(num_tokens <= _json_elements_size)
+        return true;
+
+#if defined(UTLGBOT_JSON_TOKENS_POOL_GROW)
+    jsmntok_t* json_elements;
+    uint32_t* json_subtree_len;
+    uint32_t size;
+
+    // The pool of the working memory can't grow, so the first time it is moved to the heap (the
+    // pool content is not kept, and the current pool is kept if the new one can't be allocated)
+    size = (_json_elements_size > 0) ? _json_elements_size*2 : MAX_JSON_ELEMENTS;
+    if(size < num_tokens)
+        size = num_tokens;
+    json_elements = (jsmntok_t*)malloc(sizeof(jsmntok_t)*size);
+    json_subtree_len = (uint32_t*)malloc(sizeof(uint32_t)*size);
+    if((json_elements == NULL) || (json_subtree_len == NULL))
+    {
+        free(json_elements);
+        free(json_subtree_len);
+        _println("[Bot] Error: Not enough memory for JSON tokens.");
+        return false;
+    }
+    if(_json_tokens_heap)
+    {
+        free(_json_elements);
+        free(_json_subtree_len);
+    }
+    _json_elements = json_elements;
+    _json_subtree_len = json_subtree_len;
+    _json_tokens_heap = true;
+    _json_elements_size = size;
+    _printf("[Bot] JSON tokens pool grown to %" PRIu32 " tokens.\n", size);
+
+    return true;
+#else
+    _printf("[Bot] Error: JSON needs %" PRIu32 " tokens (working memory pool is %" PRIu32 ").\n",
+        num_tokens, _json_elements_size);
+
+    return false;
+#endif
+}
+
+// Get the known key ID of given json element (token), TLG_KEY_UNKNOWN if it is not a known key
+uint8_t uTLGBot::json_get_key_id(const char* json_str, jsmntok_t* token)
+{
+    const char* key = json_str + token->start;
+    size_t key_len = token->end - token->start;
+    uint8_t key_id;
+
+    // Note: There is no known key shorter than 2 characters
+    if(key_len < 2)
+        return TLG_KEY_UNKNOWN;
+
+    // Get the key ID from hash table and check that it is really that key
+    key_id = tlg_keys_hash_table.key_id[tlg_key_hash(key_len, key[0], key[key_len-2],
+        key[key_len-1])];
+    if(key_id == TLG_KEY_UNKNOWN)
+        return TLG_KEY_UNKNOWN;
+    if((strncmp(key, tlg_keys[key_id], key_len) != 0) || (tlg_keys[key_id][key_len] != '\0'))
+        return TLG_KEY_UNKNOWN;
+
+    return key_id;
+}
+
+// Get the number of tokens of each json element (token), including all its nested elements, so
+// any element can be skipped in O(1)
+// Note: Tokens are processed from last to first, so each token just visit its direct children
+// (already indexed), which makes it O(num_tokens)
+void uTLGBot::json_index_subtrees(jsmntok_t* json_tokens, const uint32_t num_tokens,
+    uint32_t* subtree_len)
+{
+    uint32_t i, j;
+
+    i = num_tokens;
+    while(i > 0)
+    {
+        i = i - 1;
+        j = i + 1;
+        while((j < num_tokens) && (json_tokens[j].start < json_tokens[i].end))
+            j = j + subtree_len[j];
+        subtree_len[i] = j - i;
+    }
+}
+
+// Get the position of all known keys of given json object (token) in a single pass, checking
+// just its own keys and skipping nested elements (position of first match of each key, and 0
+// for keys that are not found)
+void uTLGBot::json_map_keys(const char* json_str, jsmntok_t* json_tokens,
+    const uint32_t* subtree_len, const uint32_t obj_token, uint32_t* keys_position)
+{
+    uint32_t obj_end = obj_token + subtree_len[obj_token];
+    uint32_t i = obj_token + 1;
+    uint8_t key_id;
+
+    memset(keys_position, 0, sizeof(uint32_t)*TLG_NUM_KEYS);
+    while(i+1 < obj_end)
+    {
+        // Check the key and jump to next one skipping its value
+        if(json_tokens[i].type == JSMN_STRING)
+        {
+            key_id = json_get_key_id(json_str, &json_tokens[i]);
+            if((key_id != TLG_KEY_UNKNOWN) && (keys_position[key_id] == 0))
+                keys_position[key_id] = i;
+        }
+        i = i + 1 + subtree_len[i+1];
+    }
+}
+
+// Decode the fields of given json object (token position) into the provided Telegram type struct,
+// walking the object keys once and dispatching each known key to its entry of the fields table
+// (keys not in the table, or which table entry bit is not set in fields mask, are skipped with
+// all their nested elements)
+// The value token of each table entry which key is in the object is set in fields_tokens (if
+// provided), so its fields can be decoded later without walking the object again
+// Return the mask of table entries which key is in the object (decoded or not), so a zero fields
+// mask can be used to just check which fields are present
+uint32_t uTLGBot::json_decode_object(const char* json_str, const uint32_t obj_token,
+    const tlg_json_field* fields, const uint8_t num_fields, void* obj, const uint32_t fields_mask,
+    uint32_t* fields_tokens)
+{
+    uint32_t obj_end = obj_token + _json_subtree_len[obj_token];
+    uint32_t i = obj_token + 1;
+    uint32_t found = 0;
+    uint8_t key_id;
+    uint8_t f;
+
+    while(i+1 < obj_end)
+    {
+        // Get the field of the key (if any)
+        key_id = TLG_KEY_UNKNOWN;
+        if(_json_elements[i].type == JSMN_STRING)
+            key_id = json_get_key_id(json_str, &_json_elements[i]);
+        f = 0;
+        while((f < num_fields) && (fields[f].key_id != key_id))
+            f = f + 1;
+        if(f < num_fields)
+        {
+            found = found | (1UL << f);
+            if(fields_tokens != NULL)
+                fields_tokens[f] = i+1;
+        }
+
+        // Decode the value into the struct member
+        if((f < num_fields) && (fields_mask & (1UL << f)))
+            json_decode_value(json_str, i+1, &fields[f], obj);
+
+        // Jump to next key skipping the value
+        i = i + 1 + _json_subtree_len[i+1];
+    }
+
+    return found;
+}
+
+// Decode a json value (token position) into the struct member of its fields table entry
+void uTLGBot::json_decode_value(const char* json_str, const uint32_t value_token,
+    const tlg_json_field* field, void* obj)
+{
+    jsmntok_t* token = &_json_elements[value_token];
+    char* member = (char*)obj + field->offset;
+    uint32_t j, array_end;
+    uint8_t* count;
+    int64_t value;
+    uint8_t item;
+
+    switch(field->type)
+    {
+        case TLG_FIELD_INT64:
+            json_get_element_int(json_str, token, (int64_t*)member);
+            break;
+        case TLG_FIELD_UINT32:
+            if(json_get_element_int(json_str, token, &value))
+                *(uint32_t*)member = (uint32_t)value;
+            break;
+        case TLG_FIELD_BOOL:
+            *(bool*)member = json_get_element_bool(json_str, token);
+            break;
+        case TLG_FIELD_STR:
+            json_get_element_string(json_str, token, member, field->size);
+            break;
+        case TLG_FIELD_STR_AT:
+            member[0] = '@';
+            json_get_element_string(json_str, token, member+1, field->size-1);
+            break;
+        case TLG_FIELD_SPAN:
+            if(token->type == JSMN_STRING)
+            {
+                ((tlg_str_span*)member)->pos = (uint16_t)((json_str - _buffer) + token->start);
+                ((tlg_str_span*)member)->len = (uint16_t)(token->end - token->start);
+            }
+            break;
+        case TLG_FIELD_OBJECT:
+            if(token->type == JSMN_OBJECT)
+                json_decode_object(json_str, value_token, field->fields, field->num_fields, member);
+            break;
+        case TLG_FIELD_ARRAY:
+            if(token->type != JSMN_ARRAY)
+                break;
+
+            // Decode each object item in next free slot (if there is no more free slots, the last
+            // one is reused, so the last item of the array is always kept)
+            count = (uint8_t*)obj + field->count_offset;
+            array_end = value_token + _json_subtree_len[value_token];
+            j = value_token + 1;
+            while(j < array_end)
+            {
+                if(_json_elements[j].type == JSMN_OBJECT)
+                {
+                    if(*count < field->max_items)
+                    {
+                        item = *count;
+                        *count = *count + 1;
+                    }
+                    else
+                    {
+                        item = field->max_items - 1;
+                        json_clear_object(field->fields, field->num_fields,
+                            member + (item * field->size));
+                    }
+                    json_decode_object(json_str, j, field->fields, field->num_fields,
+                        member + (item * field->size));
+                }
+                j = j + _json_subtree_len[j];
+            }
+            break;
+    }
+}
+
+// Set the fields of the fields table of given Telegram type struct to default values (just the
+// table entries which bit is set in fields mask)
+void uTLGBot::json_clear_object(const tlg_json_field* fields, const uint8_t num_fields,
+    void* obj, const uint32_t fields_mask)
+{
+    char* member;
+
+    for(uint8_t f = 0; f < num_fields; f++)
+    {
+        if((fields_mask & (1UL << f)) == 0)
+            continue;
+
+        member = (char*)obj + fields[f].offset;
+        switch(fields[f].type)
+        {
+            case TLG_FIELD_INT64:
+                *(int64_t*)member = 0;
+                break;
+            case TLG_FIELD_UINT32:
+                *(uint32_t*)member = 0;
+                break;
+            case TLG_FIELD_BOOL:
+                *(bool*)member = false;
+                break;
+            case TLG_FIELD_STR:
+            case TLG_FIELD_STR_AT:
+                member[0] = '\0';
+                break;
+            case TLG_FIELD_SPAN:
+                ((tlg_str_span*)member)->pos = 0;
+                ((tlg_str_span*)member)->len = 0;
+                break;
+            case TLG_FIELD_OBJECT:
+                json_clear_object(fields[f].fields, fields[f].num_fields, member);
+                break;
+            case TLG_FIELD_ARRAY:
+                for(uint8_t item = 0; item < fields[f].max_items; item++)
+                {
+                    json_clear_object(fields[f].fields, fields[f].num_fields,
+                        member + (item * fields[f].size));
+                }
+                *((uint8_t*)obj + fields[f].count_offset) = 0;
+                break;
+        }
+    }
+}
+
+// Get the position of next non whitespace character of a json string from given position
+size_t uTLGBot::json_skip_spaces(const char* json_str, const size_t json_str_len, size_t pos)
+{
+    while((pos < json_str_len) && ((json_str[pos] == ' ') || (json_str[pos] == '\t') ||
+        (json_str[pos] == '\r') || (json_str[pos] == '\n')))
+    {
+        pos = pos + 1;
+    }
+
+    return pos;
+}
+
+// Get the integer value of a key of a json object, without parsing the object (just its root
+// keys are checked, in any order)
+bool uTLGBot::json_get_root_int(const char* json_str, const size_t json_str_len, const char* key,
+    int64_t* value)
+{
+    size_t key_len = strlen(key);
+    size_t pos;
+    int32_t value_end;
+
+    pos = json_skip_spaces(json_str, json_str_len, 0);
+    if((pos >= json_str_len) || (json_str[pos] != '{'))
+        return false;
+    pos = json_skip_spaces(json_str, json_str_len, pos+1);
+    while((pos < json_str_len) && (json_str[pos] == '"'))
+    {
+        // Get key and value positions
+        value_end = json_skip_value(json_str, json_str_len, pos);
+        if(value_end == -1)
+            return false;
+        const char* str_key = json_str + pos + 1;
+        size_t str_key_len = value_end - pos - 2;
+        pos = json_skip_spaces(json_str, json_str_len, value_end);
+        if((pos >= json_str_len) || (json_str[pos] != ':'))
+            return false;
+        pos = json_skip_spaces(json_str, json_str_len, pos+1);
+        value_end = json_skip_value(json_str, json_str_len, pos);
+        if(value_end == -1)
+            return false;
+
+        // Check the key and get its value
+        if((str_key_len == key_len) && (strncmp(str_key, key, key_len) == 0))
+            return cstr_to_int64(json_str + pos, value_end - pos, value);
+
+        // Go to next key
+        pos = json_skip_spaces(json_str, json_str_len, value_end);
+        if((pos < json_str_len) && (json_str[pos] == ','))
+            pos = json_skip_spaces(json_str, json_str_len, pos+1);
+    }
+
+    return false;
+}
+
+// Get the end position (next character) of the json value (string, primitive, object or list)
+// that starts at given position, skipping all its nested values
+// Return -1 if the value is not complete
+int32_t uTLGBot::json_skip_value(const char* json_str, const size_t json_str_len, size_t pos)
+{
+    const char* quote;
+    uint32_t depth = 0;
+    char c;
+
+    while(pos < json_str_len)
+    {
+        c = json_str[pos];
+        if(c == '"')
+        {
+            // Jump to string end quote (the one not escaped by an odd number of backslashes)
+            do
+            {
+                quote = (const char*)memchr(json_str+pos+1, '"', json_str_len-pos-1);
+                if(quote == NULL)
+                    return -1;
+                pos = quote - json_str;
+                size_t bslashes = 0;
+                while(json_str[pos-1-bslashes] == '\\')
+                    bslashes = bslashes + 1;
+                if((bslashes & 1) == 0)
+                    break;
+            } while(true);
+        }
+        else if((c == '{') || (c == '['))
+            depth = depth + 1;
+        else if((c == '}') || (c == ']'))
+        {
+            if(depth == 0)
+                return pos;
+            depth = depth - 1;
+        }
+        else if((depth == 0) && ((c == ',') || (c == ' ') || (c == '\t') || (c == '\r') ||
+            (c == '\n') || (c == ':')))
+        {
+            return pos;
+        }
+        pos = pos + 1;
+        if(depth == 0)
+        {
+            // A string or container just ended, or it is a primitive that continues
+            if((c == '"') || (c == '}') || (c == ']'))
+                return pos;
+        }
+    }
+
+    return (depth == 0) ? (int32_t)pos : -1;
+}
+
+// Get the corresponding string of given json element (token), unescaped and null terminated
+void uTLGBot::json_get_element_string(const char* json_str, jsmntok_t* token, char* converted_str,
+    const uint32_t converted_str_len)
+{
+    const char* value = json_str + token->start;
+    uint32_t value_len = token->end - token->start;
+
+    // Strings are unescaped while copied (primitives don't have escape sequences)
+    json_unescape_str(value, value_len, converted_str, converted_str_len);
+}
+
+// Get the integer value of given json element (token) directly from the json string
+// Return false if the element is not an integer number (value is not modified)
+bool uTLGBot::json_get_element_int(const char* json_str, jsmntok_t* token, int64_t* value)
+{
+    if(token->type != JSMN_PRIMITIVE)
+        return false;
+
+    return cstr_to_int64(json_str + token->start, token->end - token->start, value);
+}
+
+// Get the boolean value of given json element (token) directly from the json string
+bool uTLGBot::json_get_element_bool(const char* json_str, jsmntok_t* token)
+{
+    return ((token->type == JSMN_PRIMITIVE) && (json_str[token->start] == 't'));
+}
+
+// Get the JSON value of a chat ID, numeric IDs as they are and any other (i.e. "@channelusername")
+// as a JSON escaped string
+// Return false if it doesn't fit in destination
+bool uTLGBot::json_chat_id(const char* chat_id, char* dest, const size_t dest_max_size)
+{
+    size_t len = strlen(chat_id);
+    size_t pos = (chat_id[0] == '-') ? 1 : 0;
+    int32_t escaped_len;
+
+    // Numeric ID (optional sign and digits)
+    if((pos < len) && (strspn(chat_id+pos, "0123456789") == len-pos))
+    {
+        if(len >= dest_max_size)
+            return false;
+        memcpy(dest, chat_id, len+1);
+        return true;
+    }
+
+    // String ID
+    if(dest_max_size < 3)
+        return false;
+    dest[0] = '"';
+    escaped_len = json_escape_str(chat_id, len, dest+1, dest_max_size-2);
+    if(escaped_len == -1)
+        return false;
+    dest[escaped_len+1] = '"';
+    dest[escaped_len+2] = '\0';
+
+    return true;
+}
+
+// Escape a string to be placed inside a JSON string value (quotes, backslashes and control chars)
+// Clean runs of bytes are scanned and copied by blocks (SIMD on Generic devices), and only the
+// bytes that need escape are handled one by one
+// Return the escaped string length or -1 if it doesn't fit in destination
+int32_t uTLGBot::json_escape_str(const char* src, const size_t src_len, char* dest,
+    const size_t dest_max_size)
+{
+    static const char hex[] = "0123456789abcdef";
+    size_t i = 0;
+    size_t o = 0;
+
+    if(dest_max_size == 0)
+        return -1;
+
+    while(i < src_len)
+    {
+#if defined(UTLGBOT_SIMD_WIDTH)
+        // Copy blocks without any byte to escape (the full block is stored and the output is
+        // just advanced up to the first byte that needs escape)
+        while((i + UTLGBOT_SIMD_WIDTH <= src_len) && (o + UTLGBOT_SIMD_WIDTH < dest_max_size))
+        {
+            uint64_t mask;
+    #if defined(UTLGBOT_SIMD_AVX2)
+            __m256i v = _mm256_loadu_si256((const __m256i*)(src + i));
+            __m256i esc = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')),
+                    _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))),
+                _mm256_cmpeq_epi8(_mm256_min_epu8(v, _mm256_set1_epi8(0x1F)), v));
+            _mm256_storeu_si256((__m256i*)(dest + o), v);
+            mask = (uint32_t)_mm256_movemask_epi8(esc);
+    #elif defined(UTLGBOT_SIMD_SSE2)
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+            __m128i esc = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')),
+                    _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))),
+                _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(0x1F)), v));
+            _mm_storeu_si128((__m128i*)(dest + o), v);
+            mask = (uint32_t)_mm_movemask_epi8(esc);
+    #elif defined(UTLGBOT_SIMD_NEON)
+            uint8x16_t v = vld1q_u8((const uint8_t*)(src + i));
+            uint8x16_t esc = vorrq_u8(vorrq_u8(vceqq_u8(v, vdupq_n_u8('"')),
+                vceqq_u8(v, vdupq_n_u8('\\'))), vcltq_u8(v, vdupq_n_u8(0x20)));
+            vst1q_u8((uint8_t*)(dest + o), v);
+            // Narrow each byte of the comparison to a nibble (4 mask bits per byte)
+            mask = vget_lane_u64(vreinterpret_u64_u8(
+                vshrn_n_u16(vreinterpretq_u16_u8(esc), 4)), 0);
+            if(mask != 0)
+                mask = (uint64_t)1 << (_ctz(mask) >> 2);
+    #endif
+            if(mask == 0)
+            {
+                i = i + UTLGBOT_SIMD_WIDTH;
+                o = o + UTLGBOT_SIMD_WIDTH;
+                continue;
+            }
+            i = i + _ctz(mask);
+            o = o + _ctz(mask);
+            break;
+        }
+        if(i >= src_len)
+            break;
+#else
+        // Scan the clean run and copy it at once
+        size_t run = i;
+        while((run < src_len) && (src[run] != '"') && (src[run] != '\\') &&
+            ((uint8_t)src[run] >= 0x20))
+        {
+            run = run + 1;
+        }
+        if(run > i)
+        {
+            if(o + (run - i) >= dest_max_size)
+            {
+                dest[o] = '\0';
+                return -1;
+            }
+            memcpy(dest + o, src + i, run - i);
+            o = o + (run - i);
+            i = run;
+            if(i >= src_len)
+                break;
+        }
+#endif
+
+        // Handle next byte
+        char c = src[i];
+        if((c != '"') && (c != '\\') && ((uint8_t)c >= 0x20))
+        {
+            if(o + 1 >= dest_max_size)
+            {
+                dest[o] = '\0';
+                return -1;
+            }
+            dest[o] = c;
+            o = o + 1;
+            i = i + 1;
+            continue;
+        }
+        size_t esc_len = 2;
+        if((c != '"') && (c != '\\') && (c != '\b') && (c != '\f') && (c != '\n') &&
+            (c != '\r') && (c != '\t'))
+        {
+            esc_len = 6;
+        }
+        if(o + esc_len >= dest_max_size)
+        {
+            dest[o] = '\0';
+            return -1;
+        }
+        dest[o] = '\\';
+        switch(c)
+        {
+            case '"':  dest[o+1] = '"';  break;
+            case '\\': dest[o+1] = '\\'; break;
+            case '\b': dest[o+1] = 'b';  break;
+            case '\f': dest[o+1] = 'f';  break;
+            case '\n': dest[o+1] = 'n';  break;
+            case '\r': dest[o+1] = 'r';  break;
+            case '\t': dest[o+1] = 't';  break;
+            default:
+                dest[o+1] = 'u';
+                dest[o+2] = '0';
+                dest[o+3] = '0';
+                dest[o+4] = hex[((uint8_t)c >> 4) & 0x0F];
+                dest[o+5] = hex[(uint8_t)c & 0x0F];
+                break;
+        }
+        o = o + esc_len;
+        i = i + 1;
+
+        _yield();
+    }
+    dest[o] = '\0';
+
+    return (int32_t)o;
+}
+
+// Unescape a JSON string value (as it comes inside the JSON, without the quotes) to UTF-8
+// Runs of bytes without backslashes are located with memchr() and moved at once, and "\uXXXX"
+// escapes (including UTF-16 surrogate pairs) are converted to UTF-8
+// The unescaped string is never longer than the source one, so it can be done in-place (dest
+// equal to src), and if it doesn't fit in destination it is truncated at a character boundary
+// Return the unescaped string length
+uint32_t uTLGBot::json_unescape_str(const char* src, const size_t src_len, char* dest,
+    const size_t dest_max_size)
+{
+    size_t i = 0;
+    size_t o = 0;
+    uint32_t cp, cp_low;
+    uint8_t cp_len;
+    bool truncated = false;
+
+    if(dest_max_size == 0)
+        return 0;
+
+    while(i < src_len)
+    {
+        // Move the run until next backslash at once (memchr() is word/SIMD optimized by libc)
+        const char* bslash = (const char*)memchr(src + i, '\\', src_len - i);
+        size_t run = (bslash != NULL) ? (size_t)(bslash - src) : src_len;
+        if(run > i)
+        {
+            if(o + (run - i) >= dest_max_size)
+            {
+                memmove(dest + o, src + i, dest_max_size - 1 - o);
+                o = dest_max_size - 1;
+                truncated = true;
+                break;
+            }
+            memmove(dest + o, src + i, run - i);
+            o = o + (run - i);
+            i = run;
+            if(i >= src_len)
+                break;
+        }
+
+        // Handle the escape sequence (a trailing lone backslash is just dropped)
+        if(i + 1 >= src_len)
+            break;
+        cp = (uint8_t)src[i+1];
+        i = i + 2;
+        switch(cp)
+        {
+            case 'b': cp = '\b'; break;
+            case 'f': cp = '\f'; break;
+            case 'n': cp = '\n'; break;
+            case 'r': cp = '\r'; break;
+            case 't': cp = '\t'; break;
+            case 'u':
+                // Invalid "\u" escapes are left as plain "u" (same as other unknown escapes)
+                if(!cstr_hex4_to_u16(src + i, src_len - i, &cp))
+                    break;
+                i = i + 4;
+                // High surrogate must be followed by a low one to get the full code point (lone
+                // surrogates are replaced by U+FFFD, the replacement character)
+                if((cp >= 0xD800) && (cp <= 0xDBFF))
+                {
+                    if((i + 6 <= src_len) && (src[i] == '\\') && (src[i+1] == 'u') &&
+                        cstr_hex4_to_u16(src + i + 2, 4, &cp_low) &&
+                        (cp_low >= 0xDC00) && (cp_low <= 0xDFFF))
+                    {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (cp_low - 0xDC00);
+                        i = i + 6;
+                    }
+                    else
+                        cp = 0xFFFD;
+                }
+                else if((cp >= 0xDC00) && (cp <= 0xDFFF))
+                    cp = 0xFFFD;
+                break;
+            default: // '"', '\\', '/' (and unknown escapes) are the char itself
+                break;
+        }
+
+        // Write the character as UTF-8 (if it fits)
+        cp_len = (cp < 0x80) ? 1 : (cp < 0x800) ? 2 : (cp < 0x10000) ? 3 : 4;
+        if(o + cp_len >= dest_max_size)
+        {
+            truncated = true;
+            break;
+        }
+        switch(cp_len)
         {
-            str[a] = str[b];
-            a = a + 1;
+            case 1:
+                dest[o] = (char)cp;
+                break;
+            case 2:
+                dest[o] = (char)(0xC0 | (cp >> 6));
+                dest[o+1] = (char)(0x80 | (cp & 0x3F));
+                break;
+            case 3:
+                dest[o] = (char)(0xE0 | (cp >> 12));
+                dest[o+1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+                dest[o+2] = (char)(0x80 | (cp & 0x3F));
+                break;
+            default:
+                dest[o] = (char)(0xF0 | (cp >> 18));
+                dest[o+1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+                dest[o+2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+                dest[o+3] = (char)(0x80 | (cp & 0x3F));
+                break;
         }
+        o = o + cp_len;
 
         _yield();
     }
-    str[a] = '\0';
+
+    // If the string was truncated, don't leave an incomplete UTF-8 character at the end
+    if(truncated)
+        o = cstr_utf8_trim(dest, o);
+    dest[o] = '\0';
+
+    return (uint32_t)o;
+}
+
+// Convert a decimal integer string of given length (optional '-' and up to 19 digits) to int64
+// Digits are converted in blocks of 8 at once without branches (SWAR), so usual Telegram IDs
+// need just 2 blocks and a few single digits
+// Return false if the string is not a valid integer (value is not modified)
+bool uTLGBot::cstr_to_int64(const char* str, const size_t str_len, int64_t* value)
+{
+    const char* end = str + str_len;
+    bool negative = ((str_len > 0) && (str[0] == '-'));
+    uint64_t result = 0;
+    uint64_t block;
+    uint8_t digit;
+
+    str = str + negative;
+    if((str == end) || (end - str > 19))
+        return false;
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    while(end - str >= 8)
+    {
+        memcpy(&block, str, 8);
+
+        // Check that all 8 bytes are digits ('0'-'9' are 0x30-0x39)
+        if(((block & 0xF0F0F0F0F0F0F0F0ULL) |
+            (((block + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) !=
+            0x3333333333333333ULL)
+        {
+            return false;
+        }
+
+        // Combine digits by pairs, then pairs of 2 digits and then pairs of 4 digits
+        block = ((block & 0x0F0F0F0F0F0F0F0FULL) * 2561) >> 8;
+        block = ((block & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+        block = ((block & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32;
+        result = (result * 100000000) + (uint32_t)block;
+        str = str + 8;
+    }
+#endif
+    while(str < end)
+    {
+        digit = (uint8_t)(*str - '0');
+        if(digit > 9)
+            return false;
+        result = (result * 10) + digit;
+        str = str + 1;
+    }
+
+    // Check int64 range
+    if(result > ((uint64_t)INT64_MAX + negative))
+        return false;
+    *value = negative ? (int64_t)(0 - result) : (int64_t)result;
+
+    return true;
+}
+
+// Convert an int64 to a decimal string (at least 21 bytes), writing 2 digits at once from a table
+// Return the string length
+uint32_t uTLGBot::cstr_from_int64(const int64_t value, char* str)
+{
+    static const char digits_pairs[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+    char tmp[20];
+    uint64_t num = (value < 0) ? (0 - (uint64_t)value) : (uint64_t)value;
+    uint32_t i = sizeof(tmp);
+    uint32_t len = 0;
+
+    while(num >= 100)
+    {
+        i = i - 2;
+        memcpy(tmp + i, digits_pairs + ((num % 100) * 2), 2);
+        num = num / 100;
+    }
+    if(num >= 10)
+    {
+        i = i - 2;
+        memcpy(tmp + i, digits_pairs + (num * 2), 2);
+    }
+    else
+    {
+        i = i - 1;
+        tmp[i] = (char)('0' + num);
+    }
+
+    if(value < 0)
+    {
+        str[0] = '-';
+        len = 1;
+    }
+    memcpy(str + len, tmp + i, sizeof(tmp) - i);
+    len = len + sizeof(tmp) - i;
+    str[len] = '\0';
+
+    return len;
+}
+
+// Convert 4 hexadecimal chars (i.e. the XXXX of a "\uXXXX" JSON escape) to its 16 bits value
+// Return false if there are less than 4 chars or any of them is not hexadecimal
+bool uTLGBot::cstr_hex4_to_u16(const char* str, const size_t str_len, uint32_t* value)
+{
+    uint32_t result = 0;
+    uint8_t c;
+
+    if(str_len < 4)
+        return false;
+
+    for(uint8_t i = 0; i < 4; i++)
+    {
+        c = (uint8_t)str[i];
+        if((c >= '0') && (c <= '9'))
+            c = c - '0';
+        else if(((c | 0x20) >= 'a') && ((c | 0x20) <= 'f'))
+            c = (c | 0x20) - 'a' + 10;
+        else
+            return false;
+        result = (result << 4) | c;
+    }
+    *value = result;
+
+    return true;
+}
+
+// Get the length of a UTF-8 string of given length without its last character if it is
+// incomplete (i.e. the string was truncated in the middle of a multibyte character)
+size_t uTLGBot::cstr_utf8_trim(const char* str, const size_t str_len)
+{
+    size_t start = str_len;
+    size_t char_len;
+    uint8_t c;
+
+    // Find the start of last character (up to 3 continuation bytes back)
+    while((start > 0) && (str_len - start < 4) && (((uint8_t)str[start-1] & 0xC0) == 0x80))
+        start = start - 1;
+    if(start == 0)
+        return str_len;
+    c = (uint8_t)str[start-1];
+    if(c < 0x80)
+        return str_len;
+    char_len = (c >= 0xF0) ? 4 : (c >= 0xE0) ? 3 : 2;
+    if(str_len - (start-1) < char_len)
+        return start - 1;
+
+    return str_len;
+}
+
+// Return the substring end position from given input string
+// Example: str=="Hello\r\nWorld." substr=="\r\n" -> result: 7
+// Return -1 if substring is not found
+int32_t uTLGBot::cstr_get_substr_pos_end(const char* str, const size_t str_len,
+    const char* substr, const size_t substr_len)
+{
+    const char* ptr = str;
+    const char* end = str + str_len;
+
+    if((substr_len == 0) || (substr_len > str_len))
+        return -1;
+
+    // Look for the first substring character and just compare from there
+    while((ptr = (const char*)memchr(ptr, substr[0], (end - ptr) - substr_len + 1)) != NULL)
+    {
+        if(memcmp(ptr, substr, substr_len) == 0)
+            return (int32_t)((ptr - str) + substr_len);
+        ptr = ptr + 1;
+        if(end - ptr < (ptrdiff_t)substr_len)
+            break;
+    }
+
+    return -1;
 }
 
 // Safe concatenate a substring to provided string
@@ -21,6 +21,12 @@
     #define MULTIHTTPSCLIENT_NO_DEBUG
 #endif
 
+// Requests phases timing is just available on Generic devices (Multihttpsclient library enables
+// its requests timing with it too, so it must be a global define)
+#if defined(UTLGBOT_TIMING) && (defined(ARDUINO) || defined(ESP_IDF))
+    #undef UTLGBOT_TIMING
+#endif
+
 // Set default and limit memory usage level
 #ifndef UTLGBOT_MEMORY_LEVEL
     #define UTLGBOT_MEMORY_LEVEL 5
@@ -48,22 +54,46 @@
 #endif
 
 #include <inttypes.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "utility/multihttpsclient/multihttpsclient.h"
 #include "utility/jsmn/jsmn.h"
 
+#if !defined(ARDUINO) && !defined(ESP_IDF) // Generic devices (dispatcher threads, paths lock)
+    #include <chrono>
+    #include <condition_variable>
+    #include <mutex>
+    #include <thread>
+#endif
+#if !defined(ARDUINO) || defined(ARDUINO_ARCH_ESP32) // Devices with atomics (lock-free queues)
+    #include <atomic>
+    #include <new>
+    #include <utility>
+#endif
+#if defined(__linux__) && !defined(ARDUINO) && !defined(ESP_IDF) && \
+    defined(__cpp_impl_coroutine) // Linux devices and C++20 compilers (reactor coroutines)
+    #include <coroutine>
+    #include <exception>
+#endif
+
 /**************************************************************************************************/
 
 /* Constants */
 
-// Telegram HTTPS Server Port
-#define HTTPS_PORT 443
+// Telegram HTTPS Server Port (it can be changed by a compiler flag, i.e. to test with a local
+// server)
+#if !defined(HTTPS_PORT)
+    #define HTTPS_PORT 443
+#endif
 
 // Telegram Server address and address lenght
 #define TELEGRAM_SERVER "https://api.telegram.org"
-#define TELEGRAM_HOST "api.telegram.org"
+#if !defined(TELEGRAM_HOST)
+    #define TELEGRAM_HOST "api.telegram.org"
+#endif
 #define TELEGRAM_SERVER_LENGTH 28
 
 // Bot token max lenght (Note: Actual token lenght is 46, but it seems was increased in the past,
@@ -86,7 +116,16 @@
 #define MAX_CHAT_DESCRIPTION_LENGTH 128
 #define MAX_URL_LENGTH 64
 #define MAX_STICKER_NAME 32
+#define MAX_CHAT_ID_LENGTH 34 // Numeric ID or "@channelusername" (up to 32 characters)
 #define MAX_TEXT_LENGTH 4097 // Yes, it is 4097 instead 4096 (telegram big brain)
+#define MAX_CALLBACK_QUERY_ID_LENGTH 32
+#define MAX_CALLBACK_DATA_LENGTH 65 // 1-64 bytes
+#define MAX_FILE_ID_LENGTH 128
+#define MAX_FILE_UNIQUE_ID_LENGTH 32
+#define MAX_FILE_NAME_LENGTH 64
+#define MAX_MIME_TYPE_LENGTH 32
+#define MAX_PHOTO_SIZES 4 // Bigger sizes are the last ones, and the last one is always kept
+#define MAX_MSG_ENTITIES 8
 
 // Memory usage level apply
 #undef MAX_TEXT_LENGTH
@@ -117,15 +156,140 @@
 #define HTTP_MAX_URI_LENGTH 128
 #define HTTP_MAX_RES_LENGTH MAX_TEXT_LENGTH + 1024
 
-// JSON Max values length
-#define MAX_JSON_STR_LEN MAX_TEXT_LENGTH
-#define MAX_JSON_SUBVAL_STR_LEN 512
-#define MAX_JSON_ELEMENTS 64
-#define MAX_JSON_SUBELEMENTS 32
+// JSON tokens pool size (Generic devices start with this size and grow the pool as needed, while
+// ESP32 devices use a fixed size pool to avoid dynamic memory)
+#ifndef MAX_JSON_ELEMENTS
+    #define MAX_JSON_ELEMENTS 64
+#endif
+#if !defined(ARDUINO) && !defined(ESP_IDF)
+    #define UTLGBOT_JSON_TOKENS_POOL_GROW
+#endif
+
+// Bot working memory size (received and sent data buffers, and a JSON tokens pool of the given
+// number of tokens, plus some bytes to align the pool)
+#define TLG_BOT_ARENA_SIZE(num_tokens) ((2*(HTTP_MAX_RES_LENGTH)) + sizeof(uint64_t) + \
+    ((num_tokens)*(sizeof(jsmntok_t)+sizeof(uint32_t))))
+#define TLG_BOT_ARENA_DEFAULT_SIZE TLG_BOT_ARENA_SIZE(MAX_JSON_ELEMENTS)
+
+// Bots reactor (single thread event loop that polls many bots at once, just on Linux devices):
+// maximum socket events handled per wait, time to wait before retry a failed poll request and
+// maximum poll requests sent per run (to keep handling responses while many bots are armed)
+#if defined(__linux__) && !defined(ARDUINO) && !defined(ESP_IDF)
+    #define UTLGBOT_REACTOR
+#endif
+#define REACTOR_MAX_EVENTS 64
+#define REACTOR_RETRY_MS 1000
+#define REACTOR_MAX_ARMS_PER_RUN 16
+
+// Reactor coroutines (awaitable bot operations for coroutines run by a reactor, just with C++20
+// compilers) and number of lists of the coroutines waiting for a message of a chat
+#if defined(UTLGBOT_REACTOR) && defined(__cpp_impl_coroutine)
+    #define UTLGBOT_COROUTINES
+#endif
+#define COROUTINES_CHAT_BUCKETS 128
+
+// Received and not confirmed updates window (dispatcher and fan-out): maximum length of the
+// updates requested again with the new one (the rest of the response buffer is kept for the HTTP
+// header and the new update)
+#define UPDATES_WINDOW_MAX_LENGTH (HTTP_MAX_RES_LENGTH - 1024)
+
+// Updates dispatcher (worker threads that handle the received messages, just on Generic devices):
+// maximum and default number of workers, maximum pending updates (received and not completed,
+// less than 100 as they are requested again with the next one) and time to wait before request
+// again the updates while all the received ones are pending
+#if !defined(ARDUINO) && !defined(ESP_IDF)
+    #define UTLGBOT_DISPATCHER
+#endif
+#define DISPATCHER_MAX_WORKERS 16
+#define DISPATCHER_DEFAULT_WORKERS 4
+#define DISPATCHER_MAX_PENDING 32
+#define DISPATCHER_REPOLL_MS 1000
+
+// Updates fan-out (the polling process publishes the received messages in a shared memory ring
+// for worker processes, just on Linux devices): maximum number of workers, default number of
+// slots of each worker ring, maximum pending updates (received and not acknowledged), maximum
+// received updates from the oldest pending one to the last one (less than 100, the getUpdates
+// limit, as they are requested again with the next one) and time to wait before request again
+// the updates while all the received ones are pending
+#if defined(__linux__) && !defined(ARDUINO) && !defined(ESP_IDF)
+    #define UTLGBOT_FANOUT
+#endif
+#define FANOUT_MAX_WORKERS 64
+#define FANOUT_DEFAULT_SLOTS 64
+#define FANOUT_MAX_PENDING 64
+#define FANOUT_MAX_WINDOW 99
+#define FANOUT_REPOLL_MS 1000
+#define FANOUT_MAX_NAME_LENGTH 64
+
+// Lock-free queues (bounded queues to pass objects between threads, just on devices with atomic
+// instructions) and cache line size to keep apart the indexes written by different threads
+#if !defined(ARDUINO) || defined(ARDUINO_ARCH_ESP32)
+    #define UTLGBOT_LOCKFREE_QUEUES
+#endif
+#ifndef TLG_CACHE_LINE_SIZE
+    #define TLG_CACHE_LINE_SIZE 64
+#endif
+
+// Split requests paths (a second connection and data buffers for the send requests, so they can
+// be sent from other threads while the Bot is receiving updates, and a third one for the callback
+// answers, so they are not delayed by the send requests, just on Generic devices)
+#if !defined(ARDUINO) && !defined(ESP_IDF)
+    #define UTLGBOT_SPLIT_PATHS
+#endif
 
 // Others
-#define MAX_KEYBOARD_MARKUP_LENGTH 128
-#define MAX_TMP_BUFFER_LENGTH MAX_KEYBOARD_MARKUP_LENGTH*2
+#define MAX_TMP_BUFFER_LENGTH 64
+
+// Maximum number of callback query handlers
+#define MAX_CALLBACK_QUERY_HANDLERS 8
+
+// getUpdates() received update types
+#define TLG_UPDATE_NONE 0
+#define TLG_UPDATE_MESSAGE 1
+#define TLG_UPDATE_CALLBACK_QUERY 2
+
+// Received message fields presence bits (tlg_type_message present), also used to select the
+// fields to decode with get_msg() in lazy decode mode
+#define TLG_MSG_HAS_MESSAGE_ID (1UL << 0)
+#define TLG_MSG_HAS_FROM (1UL << 1)
+#define TLG_MSG_HAS_DATE (1UL << 2)
+#define TLG_MSG_HAS_CHAT (1UL << 3)
+#define TLG_MSG_HAS_TEXT (1UL << 4)
+#define TLG_MSG_HAS_DOCUMENT (1UL << 5)
+#define TLG_MSG_HAS_PHOTO (1UL << 6)
+#define TLG_MSG_HAS_STICKER (1UL << 7)
+#define TLG_MSG_HAS_REPLY_TO_MESSAGE (1UL << 8)
+#define TLG_MSG_HAS_FORWARD_FROM (1UL << 9)
+#define TLG_MSG_HAS_ENTITIES (1UL << 10)
+#define TLG_MSG_HAS_CAPTION (1UL << 11)
+#define TLG_MSG_NUM_FIELDS 12
+#define TLG_MSG_HAS_ALL ((1UL << TLG_MSG_NUM_FIELDS) - 1)
+
+// Broadcast default rate limits (Telegram: ~30 messages per second to different chats and no more
+// than 1 message per second to the same chat)
+#define DEFAULT_BROADCAST_MAX_MSGS_PER_SECOND 30
+#define DEFAULT_BROADCAST_CHAT_MIN_INTERVAL_MS 1000
+#define BROADCAST_RECENT_CHATS DEFAULT_BROADCAST_MAX_MSGS_PER_SECOND
+
+// Packed message records strings (index of each string in the record)
+#define TLG_MSG_RECORD_TEXT 0
+#define TLG_MSG_RECORD_FROM_FIRST_NAME 1
+#define TLG_MSG_RECORD_FROM_LAST_NAME 2
+#define TLG_MSG_RECORD_FROM_USERNAME 3
+#define TLG_MSG_RECORD_CHAT_TYPE 4
+#define TLG_MSG_RECORD_CHAT_TITLE 5
+#define TLG_MSG_RECORD_CHAT_USERNAME 6
+#define TLG_MSG_RECORD_CAPTION 7
+#define TLG_MSG_RECORD_FILE_ID 8 // Document, biggest photo size or sticker file ID
+#define TLG_MSG_RECORD_NUM_STRS 9
+
+// Live message default minimum time between edits
+#define DEFAULT_LIVE_MSG_MIN_INTERVAL_MS 3000
+
+// Broadcast per-recipient results
+#define BROADCAST_RESULT_PENDING 0
+#define BROADCAST_RESULT_SENT 1
+#define BROADCAST_RESULT_FAIL 2
 
 /**************************************************************************************************/
 
@@ -135,6 +299,9 @@
 #define API_CMD_GET_ME "getMe"
 #define API_CMD_SEND_MSG "sendMessage"
 #define API_CMD_GET_UPDATES "getUpdates"
+#define API_CMD_ANSWER_CALLBACK_QUERY "answerCallbackQuery"
+#define API_CMD_EDIT_MSG_TEXT "editMessageText"
+#define API_CMD_EDIT_MSG_REPLY_MARKUP "editMessageReplyMarkup"
 
 /**************************************************************************************************/
 
@@ -143,7 +310,7 @@
 // User: https://core.telegram.org/bots/api#user
 typedef struct tlg_type_user
 {
-    char id[MAX_ID_LENGTH];
+    int64_t id;
     bool is_bot;
     char first_name[MAX_USER_LENGTH];
     char last_name[MAX_USER_LENGTH];
@@ -154,7 +321,7 @@ typedef struct tlg_type_user
 // Chat: https://core.telegram.org/bots/api#chat
 typedef struct tlg_type_chat
 {
-    char id[MAX_ID_LENGTH];
+    int64_t id;
     char type[MAX_CHAT_TYPE_LENGTH];
     char title[MAX_CHAT_TITLE_LENGTH];
     char username[MAX_USERNAME_LENGTH];
@@ -169,7 +336,69 @@ typedef struct tlg_type_chat
     //bool can_set_sticker_set; // Uninplemented
 } tlg_type_chat;
 
+// String of received data: Position and length of a string value inside the received JSON data
+// (still escaped), so big optional strings (file IDs, captions...) don't need space in the message
+// struct (get them with uTLGBot::get_msg_str(), they are valid until next Bot request)
+typedef struct tlg_str_span
+{
+    uint16_t pos;
+    uint16_t len;
+} tlg_str_span;
+
+// PhotoSize: https://core.telegram.org/bots/api#photosize
+typedef struct tlg_type_photo_size
+{
+    tlg_str_span file_id;
+    tlg_str_span file_unique_id;
+    uint32_t width;
+    uint32_t height;
+    int64_t file_size;
+} tlg_type_photo_size;
+
+// Document: https://core.telegram.org/bots/api#document
+typedef struct tlg_type_document
+{
+    tlg_str_span file_id;
+    tlg_str_span file_unique_id;
+    tlg_type_photo_size thumb;
+    tlg_str_span file_name;
+    tlg_str_span mime_type;
+    int64_t file_size;
+} tlg_type_document;
+
+// Sticker: https://core.telegram.org/bots/api#sticker
+typedef struct tlg_type_sticker
+{
+    tlg_str_span file_id;
+    tlg_str_span file_unique_id;
+    uint32_t width;
+    uint32_t height;
+    bool is_animated;
+    tlg_str_span emoji;
+    tlg_str_span set_name;
+    int64_t file_size;
+} tlg_type_sticker;
+
+// MessageEntity: https://core.telegram.org/bots/api#messageentity
+typedef struct tlg_type_message_entity
+{
+    tlg_str_span type;
+    uint32_t offset;
+    uint32_t length;
+} tlg_type_message_entity;
+
+// Replied message (just the fields needed to identify it, not a full Message)
+typedef struct tlg_type_message_ref
+{
+    int64_t message_id;
+    int64_t from_id;
+    uint32_t date;
+    tlg_str_span text;
+} tlg_type_message_ref;
+
 // Message: https://core.telegram.org/bots/api#message
+// Note: Optional fields that are not in the message are left cleared, check the TLG_MSG_HAS_*
+// bits of present to know which ones were received
 typedef struct tlg_type_message
 {
     int64_t message_id;
@@ -177,30 +406,455 @@ typedef struct tlg_type_message
     uint32_t date;
     tlg_type_chat chat;
     char text[MAX_TEXT_LENGTH];
-    //tlg_type_user forward_from;
+    tlg_type_document document;
+    tlg_type_photo_size photo[MAX_PHOTO_SIZES];
+    uint8_t photo_count;
+    tlg_type_sticker sticker;
+    tlg_type_message_ref reply_to_message;
+    tlg_type_user forward_from;
+    tlg_type_message_entity entities[MAX_MSG_ENTITIES];
+    uint8_t entities_count;
+    tlg_str_span caption;
+    uint32_t present;
     //tlg_type_chat forward_from_chat;
     //int32_t forward_from_message_id;
     //...
 } tlg_type_message;
 
+// CallbackQuery: https://core.telegram.org/bots/api#callbackquery
+// Note: Just the fields needed to identify and answer the query (chat_id and message_id are from
+// the message with the pressed button, if any)
+typedef struct tlg_type_callback_query
+{
+    char id[MAX_CALLBACK_QUERY_ID_LENGTH];
+    int64_t from_id;
+    int64_t chat_id;
+    int64_t message_id;
+    char data[MAX_CALLBACK_DATA_LENGTH];
+    uint8_t data_len;
+} tlg_type_callback_query;
+
+/* Library Data Types */
+
+class uTLGBot;
+class uTLGBotReactor;
+class uTLGBotUpdateAwaiter;
+class uTLGBotSendAwaiter;
+
+// JSON decode table entry of a Telegram type field (defined in the library source)
+struct tlg_json_field;
+
+#if defined(UTLGBOT_TIMING)
+// Requests phases times (us) of a requests path: HTTPS client phases (connection, request write,
+// time to first response byte and response read), response check (status, "ok" and "result"
+// value) and number of failed requests (connection, HTTPS request or response check fail)
+typedef struct tlg_req_timing
+{
+    multihttpsclient_timing http;
+    uint64_t check_us;
+    uint32_t errors;
+} tlg_req_timing;
+#endif
+
+// Requests path (server connection, request/response data buffer, auxiliar request data buffer,
+// position and length of the last response "result" value in the data buffer, and if the last
+// request got a response, even if it is an API error)
+typedef struct tlg_req_path
+{
+    MultiHTTPSClient* client;
+    char* buffer;
+    char* aux_buffer;
+    uint32_t result_pos;
+    uint32_t result_len;
+    bool response_received;
+#if defined(UTLGBOT_TIMING)
+    tlg_req_timing timing_last;
+    tlg_req_timing timing_total;
+#endif
+} tlg_req_path;
+
+// Callback query handler (called for received callback queries which data starts with the
+// handler data prefix)
+typedef void (*tlg_callback_query_handler)(uTLGBot& bot, const tlg_type_callback_query& query,
+    void* arg);
+
+// Callback query handlers dispatch table entry
+typedef struct tlg_callback_query_entry
+{
+    const char* data_prefix;
+    uint8_t data_prefix_len;
+    tlg_callback_query_handler handler;
+    void* arg;
+} tlg_callback_query_entry;
+
+// Reactor update handler (called for each update received by a reactor bot)
+typedef void (*tlg_reactor_update_handler)(uTLGBot& bot, const uint8_t update_type, void* arg);
+
+// Reactor bot entry
+typedef struct tlg_reactor_entry
+{
+    uTLGBot* bot;
+    tlg_reactor_update_handler handler;
+    void* arg;
+    unsigned long deadline;
+    uint32_t timer_pos;
+    int fd;
+    uint8_t state;
+#if defined(UTLGBOT_COROUTINES)
+    unsigned long send_deadline;
+    int send_fd;
+#endif
+} tlg_reactor_entry;
+
+#if defined(UTLGBOT_COROUTINES)
+// Coroutine waiting for a bot operation (it lives in the suspended coroutine frame and is linked
+// in a bot waiting list), with the operation parameters and result
+typedef struct tlg_co_waiter
+{
+    std::coroutine_handle<> handle;
+    struct tlg_co_waiter* next;
+    int64_t chat_id;
+    const char* text;
+    const char* parse_mode;
+    const char* reply_markup;
+    uint64_t reply_to_message_id;
+    uint8_t result;
+} tlg_co_waiter;
+#endif
+
+// Broadcast options (NULL options means no optional fields and default rate limits)
+typedef struct tlg_broadcast_options
+{
+    const char* parse_mode;
+    bool disable_web_page_preview;
+    bool disable_notification;
+    const char* reply_markup;
+    uint16_t max_msgs_per_second;
+    uint16_t chat_min_interval_ms;
+} tlg_broadcast_options;
+
+// Broadcast report (results must point to an array of num_chat_ids elements, or be NULL)
+typedef struct tlg_broadcast_report
+{
+    uint8_t* results;
+    uint32_t sent;
+    uint32_t failed;
+    uint32_t elapsed_ms;
+    float msgs_per_second;
+} tlg_broadcast_report;
+
+// Packed received message record: Fixed header with the message IDs followed by its strings (null
+// terminated, and just the received ones), so it takes the real size of the message instead of
+// all the tlg_type_message fixed size arrays (get the strings with uTLGBotMsgQueue::get_str())
+typedef struct tlg_msg_record
+{
+    int64_t message_id;
+    int64_t from_id;
+    int64_t chat_id;
+    int64_t reply_to_message_id;
+    uint32_t date;
+    uint32_t present;
+    uint16_t size;
+    uint16_t str_pos[TLG_MSG_RECORD_NUM_STRS];
+} tlg_msg_record;
+
+// Dispatcher message handler (called from a worker thread, in order for the messages of a chat)
+typedef void (*tlg_dispatch_handler)(const tlg_msg_record& record, const uint8_t worker,
+    void* arg);
+
+// Dispatcher pending update (the ones of the same chat are linked in order) and its length in the
+// getUpdates response
+typedef struct tlg_dispatch_slot
+{
+    uint64_t update_id;
+    const tlg_msg_record* record;
+    uint32_t next;
+    uint32_t len;
+    bool done;
+} tlg_dispatch_slot;
+
+// Dispatcher chat queue (chats with pending messages, in the ready list of a worker or being
+// handled by it)
+typedef struct tlg_dispatch_chat
+{
+    int64_t chat_id;
+    uint32_t head;
+    uint32_t tail;
+    uint32_t next_ready;
+    uint8_t worker;
+    bool used;
+} tlg_dispatch_chat;
+
+#if defined(UTLGBOT_FANOUT)
+// Fan-out shared memory header (ring parameters, closed flag and acknowledged updates counter
+// that the polling process waits on)
+typedef struct tlg_fanout_header
+{
+    std::atomic<uint32_t> magic;
+    uint32_t num_workers;
+    uint32_t num_slots;
+    uint32_t slot_size;
+    std::atomic<uint32_t> closed;
+    alignas(TLG_CACHE_LINE_SIZE) std::atomic<uint32_t> acks;
+    std::atomic<uint32_t> poller_waiting;
+} tlg_fanout_header;
+
+// Fan-out worker ring indexes (published records, written by the polling process, and
+// acknowledged ones, written by the worker, in different cache lines)
+typedef struct tlg_fanout_ring
+{
+    alignas(TLG_CACHE_LINE_SIZE) std::atomic<uint32_t> tail;
+    std::atomic<uint32_t> worker_waiting;
+    alignas(TLG_CACHE_LINE_SIZE) std::atomic<uint32_t> head;
+} tlg_fanout_ring;
+
+// Fan-out received update that is not confirmed yet (its ID and its length in the getUpdates
+// response)
+typedef struct tlg_fanout_received
+{
+    uint64_t update_id;
+    uint32_t len;
+} tlg_fanout_received;
+#endif
+
+/**************************************************************************************************/
+
+/* Keyboard Markup Builders */
+
+// Compile-time keyboards: Static menus can be created at compile time as constant JSON strings, so
+// they are not created again on each send, i.e.:
+//   static constexpr auto menu = tlg_keyboard(
+//       tlg_row(tlg_button("On"), tlg_button("Off")),
+//       tlg_row(tlg_button("Status")));
+//   static constexpr auto actions = tlg_inline_keyboard(
+//       tlg_row(tlg_inline_button("Yes", "act:yes"), tlg_inline_button("No", "act:no")));
+//   Bot.sendMessage(chat_id, "Select an option", "", false, false, 0, menu.str);
+// Note: Texts are not escaped, so a text with quotes, backslashes or control characters causes a
+// build error (tlg_keyboard_text_needs_json_escape() is not constexpr)
+
+// Compile-time index sequence (C++11 doesn't provide std::index_sequence)
+template<size_t... I> struct tlg_index_seq {};
+template<size_t N, size_t... I> struct tlg_make_index_seq : tlg_make_index_seq<N-1, N-1, I...> {};
+template<size_t... I> struct tlg_make_index_seq<0, I...> { typedef tlg_index_seq<I...> type; };
+
+// Compile-time string of N characters
+template<size_t N>
+struct tlg_cstr
+{
+    char str[N+1];
+
+    template<size_t... I>
+    constexpr tlg_cstr(const char (&s)[N+1], tlg_index_seq<I...>) : str{s[I]..., '\0'} {}
+
+    template<size_t M, size_t... I>
+    constexpr tlg_cstr(const tlg_cstr<M>& a, const tlg_cstr<N-M>& b, tlg_index_seq<I...>) :
+        str{((I < M) ? a.str[I] : b.str[I-M])..., '\0'} {}
+
+    constexpr size_t length() const { return N; }
+};
+
+template<size_t A, size_t B>
+constexpr tlg_cstr<A+B> operator+(const tlg_cstr<A>& a, const tlg_cstr<B>& b)
+{
+    return tlg_cstr<A+B>(a, b, typename tlg_make_index_seq<A+B>::type());
+}
+
+template<size_t N>
+constexpr tlg_cstr<N-1> tlg_literal(const char (&s)[N])
+{
+    return tlg_cstr<N-1>(s, typename tlg_make_index_seq<N-1>::type());
+}
+
+// Compile-time check for texts that would need JSON escape
+void tlg_keyboard_text_needs_json_escape();
+constexpr bool tlg_json_safe_text(const char* s, size_t i=0)
+{
+    return (s[i] == '\0') ? true : (((s[i] == '"') || (s[i] == '\\') ||
+        ((unsigned char)s[i] < 0x20)) ? false : tlg_json_safe_text(s, i+1));
+}
+template<size_t N>
+constexpr tlg_cstr<N-1> tlg_json_text(const char (&s)[N])
+{
+    return tlg_json_safe_text(s) ? tlg_literal(s) :
+        (tlg_keyboard_text_needs_json_escape(), tlg_literal(s));
+}
+
+// Comma separated join of compile-time strings
+template<typename... T> struct tlg_join_length;
+template<size_t A> struct tlg_join_length<tlg_cstr<A>>
+{
+    static const size_t value = A;
+};
+template<size_t A, typename... T> struct tlg_join_length<tlg_cstr<A>, T...>
+{
+    static const size_t value = A + 1 + tlg_join_length<T...>::value;
+};
+
+template<size_t A>
+constexpr tlg_cstr<A> tlg_join(const tlg_cstr<A>& a)
+{
+    return a;
+}
+template<size_t A, typename... T>
+constexpr tlg_cstr<tlg_join_length<tlg_cstr<A>, T...>::value> tlg_join(const tlg_cstr<A>& a,
+    const T&... rest)
+{
+    return a + tlg_literal(",") + tlg_join(rest...);
+}
+
+// Keyboard elements
+template<size_t N>
+constexpr tlg_cstr<N+1> tlg_button(const char (&text)[N])
+{
+    return tlg_literal("\"") + tlg_json_text(text) + tlg_literal("\"");
+}
+
+template<size_t N, size_t M>
+constexpr tlg_cstr<N+M+28> tlg_inline_button(const char (&text)[N], const char (&callback_data)[M])
+{
+    return tlg_literal("{\"text\":\"") + tlg_json_text(text) +
+        tlg_literal("\",\"callback_data\":\"") + tlg_json_text(callback_data) + tlg_literal("\"}");
+}
+
+template<typename... T>
+constexpr tlg_cstr<tlg_join_length<T...>::value+2> tlg_row(const T&... buttons)
+{
+    return tlg_literal("[") + tlg_join(buttons...) + tlg_literal("]");
+}
+
+template<typename... T>
+constexpr tlg_cstr<tlg_join_length<T...>::value+15> tlg_keyboard(const T&... rows)
+{
+    return tlg_literal("{\"keyboard\":[") + tlg_join(rows...) + tlg_literal("]}");
+}
+
+template<typename... T>
+constexpr tlg_cstr<tlg_join_length<T...>::value+22> tlg_inline_keyboard(const T&... rows)
+{
+    return tlg_literal("{\"inline_keyboard\":[") + tlg_join(rows...) + tlg_literal("]}");
+}
+
+// Runtime keyboards: Dynamic keyboards are created in the provided buffer, escaping texts, and the
+// buffer always keeps a complete JSON keyboard that can be directly used as reply_markup (buttons
+// that don't fit are discarded and is_valid() returns false, and if not even an empty keyboard
+// fits, the buffer is left empty), i.e.:
+//   char markup[256];
+//   uTLGBotKeyboard kb(markup, sizeof(markup), true);
+//   kb.inline_button("Item 1", "item:1"); kb.inline_button("Item 2", "item:2");
+//   kb.row(); kb.inline_button("Back", "back");
+//   if(kb.is_valid()) Bot.sendMessage(chat_id, "Select an item", "", false, false, 0, kb.get());
+class uTLGBotKeyboard
+{
+    public:
+        // Public Methods
+        uTLGBotKeyboard(char* buffer, const size_t buffer_size, const bool inline_keyboard=false);
+        bool clear();
+        bool row();
+        bool button(const char* text);
+        bool inline_button(const char* text, const char* callback_data);
+        bool is_valid();
+        const char* get();
+
+    private:
+        // Private Attributtes
+        char* _buffer;
+        size_t _buffer_size;
+        size_t _length;
+        bool _inline_keyboard;
+        bool _row_empty;
+        bool _new_row;
+        bool _valid;
+
+        // Private Methods
+        bool append(const char* str, const bool escape=false);
+        void add_separator();
+        bool close(const size_t prev_length, const bool prev_row_empty, const bool prev_new_row);
+};
+
+/**************************************************************************************************/
+
+/* Bot Working Memory */
+
+// Working memory arena: Memory for the bots received and sent data buffers and JSON tokens pool,
+// that can be shared by any number of bots used from the same thread (i.e. all the bots of a
+// worker thread), so memory scales with threads instead of bots. Just one bot uses it at a time,
+// and the received message of the last one is fully decoded before other bot reuses it (its
+// received message strings spans are not valid anymore), i.e.:
+//   static uint32_t memory[TLG_BOT_ARENA_DEFAULT_SIZE/sizeof(uint32_t)];
+//   uTLGBotArena arena(memory, sizeof(memory));
+//   uTLGBot Bot1(TOKEN_1, arena);
+//   uTLGBot Bot2(TOKEN_2, arena);
+// Note: Bots created without arena use their own memory (allocated once by the constructor)
+class uTLGBotArena
+{
+    friend class uTLGBot;
+
+    public:
+        // Public Methods
+        uTLGBotArena(void* memory=NULL, const size_t size=0);
+
+    private:
+        // Private Attributtes
+        char* _memory;
+        size_t _size;
+        uTLGBot* _owner;
+};
+
 /**************************************************************************************************/
 
 class uTLGBot
 {
+    friend class uTLGBotKeyboard;
+    friend class uTLGBotLiveMessage;
+    friend class uTLGBotReactor;
+    friend class uTLGBotDispatcher;
+    friend class uTLGBotFanout;
+#if defined(UTLGBOT_COROUTINES)
+    friend class uTLGBotUpdateAwaiter;
+    friend class uTLGBotSendAwaiter;
+#endif
+#if defined(UTLGBOT_TESTS)
+    friend class uTLGBotTests;
+#endif
+
     public:
         // Public Attributtes
         tlg_type_message received_msg;
+        tlg_type_callback_query received_callback_query;
 
         // Public Methods
         uTLGBot(const char* token, const bool dont_keep_connection=false);
+        uTLGBot(const char* token, uTLGBotArena& arena, const bool dont_keep_connection=false);
         ~uTLGBot();
         void set_debug(const uint8_t debug_level);
         void set_token(const char* token);
         void set_cert(const uint8_t* ca_pem_start, const uint8_t* ca_pem_end=NULL);
         void set_cert(const char* cert_https_server);
+#if !defined(ARDUINO) && !defined(ESP_IDF)
+        bool set_tls_mem_pool(MultiHTTPSClientMemPool* mem_pool);
+#endif
         void set_polling_timeout(const uint8_t seconds);
+        void set_lazy_decode(const bool lazy_decode);
+#if defined(UTLGBOT_SPLIT_PATHS)
+        bool split_paths();
+#endif
+#if defined(UTLGBOT_TIMING)
+        bool get_timing(tlg_req_timing* last, tlg_req_timing* total=NULL,
+            const bool tx_path=false);
+        void reset_timing();
+#endif
         char* get_token();
         uint8_t get_polling_timeout();
+        int64_t get_sent_message_id();
+        int64_t get_msg_id();
+        uint32_t get_msg_date();
+        const char* get_msg_text();
+        int64_t get_msg_chat_id();
+        const tlg_type_user& get_msg_from();
+        const tlg_type_chat& get_msg_chat();
+        const tlg_type_document& get_msg_document();
+        const tlg_type_message& get_msg(const uint32_t fields=TLG_MSG_HAS_ALL);
+        bool get_msg_str(const tlg_str_span& span, char* dest, const size_t dest_size);
         uint8_t connect();
         void disconnect();
         bool is_connected();
@@ -208,9 +862,39 @@ class uTLGBot
         uint8_t sendMessage(const char* chat_id, const char* text, const char* parse_mode="",
             bool disable_web_page_preview=false, bool disable_notification=false,
             uint64_t reply_to_message_id=0, const char* reply_markup="");
+        uint8_t sendMessage(const int64_t chat_id, const char* text, const char* parse_mode="",
+            bool disable_web_page_preview=false, bool disable_notification=false,
+            uint64_t reply_to_message_id=0, const char* reply_markup="");
         uint8_t sendReplyKeyboardMarkup(const char* chat_id, const char* text,
             const char* keyboard);
+        uint8_t editMessageText(const char* chat_id, const int64_t message_id, const char* text,
+            const char* parse_mode="", bool disable_web_page_preview=false,
+            const char* reply_markup="");
+        uint8_t editMessageText(const int64_t chat_id, const int64_t message_id,
+            const char* text, const char* parse_mode="", bool disable_web_page_preview=false,
+            const char* reply_markup="");
+        uint8_t editMessageReplyMarkup(const char* chat_id, const int64_t message_id,
+            const char* reply_markup="");
+        uint8_t editMessageReplyMarkup(const int64_t chat_id, const int64_t message_id,
+            const char* reply_markup="");
+        uint32_t broadcast(const char* const* chat_ids, const uint32_t num_chat_ids,
+            const char* text, const tlg_broadcast_options* options=NULL,
+            tlg_broadcast_report* report=NULL);
+        uint32_t broadcast(const int64_t* chat_ids, const uint32_t num_chat_ids,
+            const char* text, const tlg_broadcast_options* options=NULL,
+            tlg_broadcast_report* report=NULL);
         uint8_t getUpdates();
+        bool add_callback_query_handler(const char* data_prefix,
+            tlg_callback_query_handler handler, void* arg=NULL);
+        uint8_t answerCallbackQuery(const char* callback_query_id, const char* text="",
+            bool show_alert=false);
+#if defined(UTLGBOT_COROUTINES)
+        uTLGBotUpdateAwaiter next_update();
+        uTLGBotUpdateAwaiter next_update(const int64_t chat_id);
+        uTLGBotSendAwaiter send_message(const int64_t chat_id, const char* text,
+            const char* parse_mode="", const uint64_t reply_to_message_id=0,
+            const char* reply_markup="");
+#endif
 
     private:
         // Private Attributtes
@@ -220,40 +904,790 @@ class uTLGBot
         uint8_t _long_poll_timeout;
         char _token[TOKEN_LENGTH];
         char _tlg_api[TELEGRAM_API_LENGTH];
-        char _buffer[HTTP_MAX_RES_LENGTH];
-        jsmntok_t _json_elements[MAX_JSON_ELEMENTS];
-        jsmntok_t _json_subelements[MAX_JSON_SUBELEMENTS];
-        char _json_value_str[MAX_JSON_STR_LEN];
-        char _json_subvalue_str[MAX_JSON_SUBVAL_STR_LEN];
-        char json_keyboard[MAX_KEYBOARD_MARKUP_LENGTH];
+        uTLGBotArena _own_arena;
+        uTLGBotArena* _arena;
+        char* _buffer;
+        char* _tx_buffer;
+        jsmntok_t* _json_elements;
+        uint32_t* _json_subtree_len;
+        uint32_t _json_elements_size;
+#if defined(UTLGBOT_JSON_TOKENS_POOL_GROW)
+        bool _json_tokens_heap;
+#endif
         uint64_t _last_received_msg;
+        uint64_t _updates_commit;
+        uint8_t _updates_limit;
+        uint32_t _update_len;
+        bool _updates_truncated;
+        int64_t _sent_message_id;
+        tlg_req_path _rx_path;
+#if defined(UTLGBOT_SPLIT_PATHS)
+        tlg_req_path _tx_path;
+        std::recursive_mutex _tx_mutex;
+        tlg_req_path _cb_path;
+        std::mutex _cb_mutex;
+        MultiHTTPSClientMemPool* _tls_mem_pool;
+#endif
+        tlg_callback_query_entry _callback_query_handlers[MAX_CALLBACK_QUERY_HANDLERS];
+        uint8_t _num_callback_query_handlers;
+        bool _callback_query_answered;
+        bool _lazy_decode;
+        const char* _msg_json_str;
+        uint32_t _msg_field_tokens[TLG_MSG_NUM_FIELDS];
+        uint32_t _msg_pending_fields;
+        bool _msg_spans_valid;
         bool _dont_keep_connection;
         uint8_t _debug_level;
+#if defined(UTLGBOT_COROUTINES)
+        uTLGBotReactor* _reactor;
+        uint32_t _reactor_entry;
+        tlg_co_waiter* _co_updates_head;
+        tlg_co_waiter* _co_updates_tail;
+        tlg_co_waiter* _co_chats[COROUTINES_CHAT_BUCKETS];
+        tlg_co_waiter* _co_sends_head;
+        tlg_co_waiter* _co_sends_tail;
+        bool _co_sending;
+        bool _co_sends_running;
+#endif
 
         // Private Methods
-        uint8_t tlg_get(const char* command, char* response, const size_t response_len,
+        void init(const char* token, uTLGBotArena* arena, const bool dont_keep_connection);
+        bool arena_acquire();
+        bool updates_arena_acquire();
+        tlg_req_path* send_path();
+        uint8_t path_connect(tlg_req_path* path);
+        void path_disconnect(tlg_req_path* path);
+#if defined(UTLGBOT_SPLIT_PATHS)
+        bool path_create(tlg_req_path* path, const bool aux_buffer);
+        void path_destroy(tlg_req_path* path);
+#endif
+        uint8_t tlg_get(tlg_req_path* path, const char* command, char* response,
+            const size_t response_len,
+            const unsigned long response_timeout=HTTP_WAIT_RESPONSE_TIMEOUT);
+        uint8_t tlg_post(tlg_req_path* path, const char* command, char* request_response,
+            const size_t request_len, const size_t request_response_max_size,
             const unsigned long response_timeout=HTTP_WAIT_RESPONSE_TIMEOUT);
-        uint8_t tlg_post(const char* command, char* request_response, const size_t request_len,
-            const size_t request_response_max_size,
+        uint8_t tlg_post_parts(tlg_req_path* path, const char* command,
+            const char* const* body_parts, const size_t* body_parts_len,
+            const uint8_t num_body_parts, char* response, const size_t response_max_size,
             const unsigned long response_timeout=HTTP_WAIT_RESPONSE_TIMEOUT);
+        uint8_t tlg_check(tlg_req_path* path, const uint8_t http_rc, const char* response,
+            const size_t response_max_size);
+        uint8_t tlg_parse_response(tlg_req_path* path, const char* response,
+            const size_t response_max_size);
+#if defined(UTLGBOT_TIMING)
+        void timing_add(tlg_req_path* path, const uint64_t check_us, const bool ok);
+#endif
+#if defined(UTLGBOT_REACTOR)
+        uint8_t tlg_async_post(tlg_req_path* path, const char* command, const char* body,
+            const size_t body_len);
+        uint8_t getUpdates_request(uint8_t* update_type);
+        uint8_t getUpdates_run(uint8_t* update_type);
+        uint8_t getUpdates_result(const uint8_t state, uint8_t* update_type);
+#endif
+#if defined(UTLGBOT_COROUTINES)
+        void co_update(const uint8_t update_type);
+        void co_send_next();
+        bool co_send_start(tlg_co_waiter* waiter);
+        void co_send_response(const uint8_t state);
+        uint8_t co_send_end(const uint8_t state);
+        void co_destroy_waiters();
+#endif
+        void create_updates_body();
+        bool updates_window();
+        uint8_t parse_updates();
 
         void clear_msg_data();
-        void cant_create_send_msg(const char* msg);
-        uint32_t json_parse_str(const char* json_str, const size_t json_str_len,
-            jsmntok_t* json_tokens, const uint32_t json_tokens_len);
-        uint32_t json_has_key(const char* json_str, jsmntok_t* json_tokens,
-            const uint32_t num_tokens, const char* key);
+        void msg_decode_fields(const uint32_t fields);
+        void msg_decode_pending();
+        void msg_release_buffer();
+        void clear_callback_query_data();
+        uint8_t parse_callback_query(const char* json_str, const uint32_t obj_token);
+        void dispatch_callback_query();
+        uint8_t callback_query_answer(tlg_req_path* path, const char* callback_query_id,
+            const char* text, const bool show_alert);
+        bool create_msg_body_fields(char* body, const size_t body_max_size, const char* text,
+            const char* parse_mode, bool disable_web_page_preview, bool disable_notification,
+            uint64_t reply_to_message_id, const char* reply_markup);
+        void cant_create_send_msg(tlg_req_path* path, const char* msg);
+        uint32_t broadcast_chats(const char* const* str_chat_ids, const int64_t* int_chat_ids,
+            const uint32_t num_chat_ids, const char* text, const tlg_broadcast_options* options,
+            tlg_broadcast_report* report);
+        void parse_sent_message_id(tlg_req_path* path);
+        uint32_t json_parse_str(const char* json_str, const size_t json_str_len);
+        int json_tokenize(const char* json_str, const size_t json_str_len);
+        bool json_reserve_tokens(const uint32_t num_tokens);
+        uint8_t json_get_key_id(const char* json_str, jsmntok_t* token);
+        void json_index_subtrees(jsmntok_t* json_tokens, const uint32_t num_tokens,
+            uint32_t* subtree_len);
+        void json_map_keys(const char* json_str, jsmntok_t* json_tokens,
+            const uint32_t* subtree_len, const uint32_t obj_token, uint32_t* keys_position);
+        uint32_t json_decode_object(const char* json_str, const uint32_t obj_token,
+            const tlg_json_field* fields, const uint8_t num_fields, void* obj,
+            const uint32_t fields_mask=UINT32_MAX, uint32_t* fields_tokens=NULL);
+        void json_decode_value(const char* json_str, const uint32_t value_token,
+            const tlg_json_field* field, void* obj);
+        static void json_clear_object(const tlg_json_field* fields, const uint8_t num_fields,
+            void* obj, const uint32_t fields_mask=UINT32_MAX);
+        static size_t json_skip_spaces(const char* json_str, const size_t json_str_len,
+            size_t pos);
+        static int32_t json_skip_value(const char* json_str, const size_t json_str_len,
+            size_t pos);
+        static bool json_get_root_int(const char* json_str, const size_t json_str_len,
+            const char* key, int64_t* value);
         void json_get_element_string(const char* json_str, jsmntok_t* token, char* converted_str,
             const uint32_t converted_str_len);
-        uint8_t json_get_key_value(const char* key, const char* json_str, jsmntok_t* tokens,
-            const uint32_t num_tokens, char* converted_str, const uint32_t converted_str_len);
-        int32_t cstr_get_substr_pos_end(char* str, const size_t str_len, const char* substr,
+        bool json_get_element_int(const char* json_str, jsmntok_t* token, int64_t* value);
+        bool json_get_element_bool(const char* json_str, jsmntok_t* token);
+        static bool json_chat_id(const char* chat_id, char* dest, const size_t dest_max_size);
+        static int32_t json_escape_str(const char* src, const size_t src_len, char* dest,
+            const size_t dest_max_size);
+        static uint32_t json_unescape_str(const char* src, const size_t src_len, char* dest,
+            const size_t dest_max_size);
+        int32_t cstr_get_substr_pos_end(const char* str, const size_t str_len, const char* substr,
             const size_t substr_len);
-        void cstr_rm_char(char* str, const size_t str_len, const char c_remove);
+        static bool cstr_to_int64(const char* str, const size_t str_len, int64_t* value);
+        static uint32_t cstr_from_int64(const int64_t value, char* str);
+        static bool cstr_hex4_to_u16(const char* str, const size_t str_len, uint32_t* value);
+        static size_t cstr_utf8_trim(const char* str, const size_t str_len);
         bool cstr_strncat(char* dest, const size_t dest_max_size, const char* src,
             const size_t src_len);
+
+        // Not copyable (owns its working memory)
+        uTLGBot(const uTLGBot&);
+        uTLGBot& operator=(const uTLGBot&);
+};
+
+/**************************************************************************************************/
+
+/* Live Messages */
+
+// Live message: A message that shows a frequently changing status (i.e. progress of a long job).
+// The latest desired text and the last sent one are kept in the provided buffer (each one in a
+// half of it) and the message is edited at most once each min_interval_ms (intermediate texts
+// are dropped and identical texts are not sent again).
+// The message is sent on first update (if no message_id is provided), i.e.:
+//   char status[128];
+//   uTLGBotLiveMessage live(Bot, chat_id, status, sizeof(status));
+//   for(i = 0; i <= 1000; i++) { snprintf(txt, sizeof(txt), "Progress: %d", i); live.update(txt); }
+//   live.flush(true);
+class uTLGBotLiveMessage
+{
+    public:
+        // Public Methods
+        uTLGBotLiveMessage(uTLGBot& bot, const char* chat_id, char* buffer,
+            const size_t buffer_size,
+            const unsigned long min_interval_ms=DEFAULT_LIVE_MSG_MIN_INTERVAL_MS,
+            const int64_t message_id=0);
+        uTLGBotLiveMessage(uTLGBot& bot, const int64_t chat_id, char* buffer,
+            const size_t buffer_size,
+            const unsigned long min_interval_ms=DEFAULT_LIVE_MSG_MIN_INTERVAL_MS,
+            const int64_t message_id=0);
+        bool update(const char* text);
+        bool flush(const bool force=false);
+        bool is_pending();
+        int64_t get_message_id();
+
+    private:
+        // Private Attributtes
+        uTLGBot& _bot;
+        char _chat_id[MAX_CHAT_ID_LENGTH];
+        char* _text;
+        char* _sent_text;
+        size_t _text_size;
+        size_t _text_len;
+        size_t _sent_text_len;
+        unsigned long _min_interval_ms;
+        unsigned long _t_last_flush;
+        int64_t _message_id;
+        bool _sent;
+        bool _flushed;
+        bool _pending;
+};
+
+/**************************************************************************************************/
+
+/* Message Records Queue */
+
+// Queue of packed received messages records in the provided memory (FIFO ring of variable size
+// records), to keep pending updates or a messages history at the real size of each message, i.e.:
+//   static uint64_t memory[4096];
+//   uTLGBotMsgQueue queue(memory, sizeof(memory));
+//   if(Bot.getUpdates() == TLG_UPDATE_MESSAGE) queue.push(Bot);
+//   while((record = queue.front()) != NULL) { process(record); queue.pop(); }
+// Note: Push with overwrite_oldest makes a history of the last messages that fit in the memory
+class uTLGBotMsgQueue
+{
+    friend class uTLGBotUpdate;
+    friend class uTLGBotFanout;
+
+    public:
+        // Public Methods
+        uTLGBotMsgQueue(void* memory, const size_t size);
+        bool push(uTLGBot& bot, const bool overwrite_oldest=false);
+        const tlg_msg_record* front();
+        const tlg_msg_record* back();
+        bool pop();
+        void clear();
+        uint32_t get_count();
+        size_t get_used();
+        static const char* get_str(const tlg_msg_record* record, const uint8_t str);
+
+    private:
+        // Private Attributtes
+        char* _memory;
+        size_t _size;
+        size_t _head;
+        size_t _tail;
+        size_t _back;
+        size_t _wrap_end;
+        size_t _used;
+        uint32_t _count;
+
+        // Private Methods
+        char* reserve(const size_t size);
+        static const tlg_str_span* msg_file_id(const tlg_type_message& msg);
+        static size_t record_max_size(uTLGBot& bot);
+        static size_t pack(uTLGBot& bot, char* ptr);
+        static void put_str(char* record, size_t* record_len, const uint8_t str,
+            const char* value);
 };
 
 /**************************************************************************************************/
 
+/* Lock-free Queues */
+
+#if defined(UTLGBOT_LOCKFREE_QUEUES)
+
+// Single producer single consumer queue: Bounded lock-free FIFO of N (power of 2) objects to pass
+// them from one thread to other (i.e. from the receiving thread to the handling one). Objects are
+// moved in and out of the queue, so move-only objects can be used, i.e.:
+//   static uTLGBotSPSCQueue<uTLGBotUpdate, 64> updates;
+//   Receiver thread: if(Bot.getUpdates() == TLG_UPDATE_MESSAGE) { update.take(Bot);
+//       updates.push(std::move(update)); }
+//   Handler thread: while(updates.pop(update)) handle(update.get());
+// Note: Each index is written by just one thread and it is in its own cache line, with a cached
+// copy of the other thread index, so threads don't share written cache lines while the queue is
+// not empty or full
+template<typename T, size_t N>
+class uTLGBotSPSCQueue
+{
+    static_assert((N >= 2) && ((N & (N-1)) == 0), "Queue size must be a power of 2");
+
+    public:
+        // Public Methods
+        uTLGBotSPSCQueue() : _head(0), _tail_cache(0), _tail(0), _head_cache(0) {}
+
+        ~uTLGBotSPSCQueue()
+        {
+            T item;
+            while(pop(item)) {}
+        }
+
+        // Add an object at the end of the queue (producer thread)
+        // Return false if the queue is full (the object is not moved)
+        bool push(T&& item)
+        {
+            size_t tail = _tail.load(std::memory_order_relaxed);
+
+            if(tail - _head_cache >= N)
+            {
+                _head_cache = _head.load(std::memory_order_acquire);
+                if(tail - _head_cache >= N)
+                    return false;
+            }
+            new (&_items[tail & (N-1)]) T(std::move(item));
+            _tail.store(tail + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        // Get and remove the oldest object of the queue (consumer thread)
+        // Return false if the queue is empty
+        bool pop(T& item)
+        {
+            size_t head = _head.load(std::memory_order_relaxed);
+            T* ptr;
+
+            if(head == _tail_cache)
+            {
+                _tail_cache = _tail.load(std::memory_order_acquire);
+                if(head == _tail_cache)
+                    return false;
+            }
+            ptr = reinterpret_cast<T*>(&_items[head & (N-1)]);
+            item = std::move(*ptr);
+            ptr->~T();
+            _head.store(head + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        // Get the number of objects in the queue (just an estimation while other thread uses it)
+        size_t get_count()
+        {
+            return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);
+        }
+
+    private:
+        // Private Attributtes
+        alignas(TLG_CACHE_LINE_SIZE) std::atomic<size_t> _head;
+        size_t _tail_cache;
+        alignas(TLG_CACHE_LINE_SIZE) std::atomic<size_t> _tail;
+        size_t _head_cache;
+        alignas(TLG_CACHE_LINE_SIZE) typename std::aligned_storage<sizeof(T), alignof(T)>::type
+            _items[N];
+
+        // Not copyable
+        uTLGBotSPSCQueue(const uTLGBotSPSCQueue&);
+        uTLGBotSPSCQueue& operator=(const uTLGBotSPSCQueue&);
+};
+
+// Multiple producers single consumer queue: Bounded lock-free FIFO of N (power of 2) objects to
+// pass them from many threads to one (i.e. from the handlers threads to the sending one). Objects
+// are moved in and out of the queue, so move-only objects can be used, i.e.:
+//   static uTLGBotMPSCQueue<uTLGBotOutMsg, 64> out_msgs;
+//   Handler threads: out_msgs.push(uTLGBotOutMsg(record->chat_id, "Done"));
+//   Sender thread: while(out_msgs.pop(msg)) msg.send(Bot);
+// Note: Each slot has a sequence number that tells producers and consumer when it is free or
+// ready, so producers just compete for the tail index (its own cache line)
+template<typename T, size_t N>
+class uTLGBotMPSCQueue
+{
+    static_assert((N >= 2) && ((N & (N-1)) == 0), "Queue size must be a power of 2");
+
+    public:
+        // Public Methods
+        uTLGBotMPSCQueue() : _tail(0), _head(0)
+        {
+            for(size_t i = 0; i < N; i++)
+                _slots[i].seq.store(i, std::memory_order_relaxed);
+        }
+
+        ~uTLGBotMPSCQueue()
+        {
+            T item;
+            while(pop(item)) {}
+        }
+
+        // Add an object at the end of the queue (any producer thread)
+        // Return false if the queue is full (the object is not moved)
+        bool push(T&& item)
+        {
+            size_t tail = _tail.load(std::memory_order_relaxed);
+            slot* ptr_slot;
+            intptr_t diff;
+
+            // Get a free slot (the tail one, if no other producer takes it before)
+            while(1)
+            {
+                ptr_slot = &_slots[tail & (N-1)];
+                diff = (intptr_t)ptr_slot->seq.load(std::memory_order_acquire) - (intptr_t)tail;
+                if(diff == 0)
+                {
+                    if(_tail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if(diff < 0)
+                    return false;
+                else
+                    tail = _tail.load(std::memory_order_relaxed);
+            }
+
+            // Fill the slot and mark it as ready
+            new (&ptr_slot->item) T(std::move(item));
+            ptr_slot->seq.store(tail + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        // Get and remove the oldest object of the queue (consumer thread)
+        // Return false if the queue is empty (or the oldest object is not ready yet)
+        bool pop(T& item)
+        {
+            slot* ptr_slot = &_slots[_head & (N-1)];
+            T* ptr;
+
+            if(ptr_slot->seq.load(std::memory_order_acquire) != _head + 1)
+                return false;
+            ptr = reinterpret_cast<T*>(&ptr_slot->item);
+            item = std::move(*ptr);
+            ptr->~T();
+            ptr_slot->seq.store(_head + N, std::memory_order_release);
+            _head = _head + 1;
+
+            return true;
+        }
+
+    private:
+        // Private Data Types
+        struct slot
+        {
+            std::atomic<size_t> seq;
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type item;
+        };
+
+        // Private Attributtes
+        alignas(TLG_CACHE_LINE_SIZE) std::atomic<size_t> _tail;
+        alignas(TLG_CACHE_LINE_SIZE) size_t _head;
+        alignas(TLG_CACHE_LINE_SIZE) slot _slots[N];
+
+        // Not copyable
+        uTLGBotMPSCQueue(const uTLGBotMPSCQueue&);
+        uTLGBotMPSCQueue& operator=(const uTLGBotMPSCQueue&);
+};
+
+#endif
+
+#if defined(UTLGBOT_LOCKFREE_QUEUES) && !defined(ARDUINO) && !defined(ESP_IDF)
+
+// Received update: Move-only copy of the last received message of a bot (packed record in its own
+// memory) to pass it between threads, i.e. through lock-free queues
+class uTLGBotUpdate
+{
+    public:
+        // Public Methods
+        uTLGBotUpdate();
+        uTLGBotUpdate(uTLGBotUpdate&& update);
+        uTLGBotUpdate& operator=(uTLGBotUpdate&& update);
+        ~uTLGBotUpdate();
+        bool take(uTLGBot& bot);
+        const tlg_msg_record* get();
+
+    private:
+        // Private Attributtes
+        tlg_msg_record* _record;
+
+        // Not copyable (owns its record)
+        uTLGBotUpdate(const uTLGBotUpdate&);
+        uTLGBotUpdate& operator=(const uTLGBotUpdate&);
+};
+
+// Outbound message: Move-only sendMessage request (it owns a copy of its strings) to pass it
+// between threads, i.e. from handlers threads to the sending one
+class uTLGBotOutMsg
+{
+    public:
+        // Public Methods
+        uTLGBotOutMsg();
+        uTLGBotOutMsg(const int64_t chat_id, const char* text, const char* parse_mode="",
+            const uint64_t reply_to_message_id=0, const char* reply_markup="");
+        uTLGBotOutMsg(uTLGBotOutMsg&& msg);
+        uTLGBotOutMsg& operator=(uTLGBotOutMsg&& msg);
+        ~uTLGBotOutMsg();
+        bool is_valid();
+        uint8_t send(uTLGBot& bot);
+
+    private:
+        // Private Attributtes
+        int64_t _chat_id;
+        uint64_t _reply_to_message_id;
+        char* _strs;
+        size_t _parse_mode_pos;
+        size_t _reply_markup_pos;
+
+        // Not copyable (owns its strings)
+        uTLGBotOutMsg(const uTLGBotOutMsg&);
+        uTLGBotOutMsg& operator=(const uTLGBotOutMsg&);
+};
+
+#endif
+
+/**************************************************************************************************/
+
+/* Reactor Coroutines */
+
+#if defined(UTLGBOT_COROUTINES)
+
+// Coroutine task: Return type of the coroutines run by a reactor, the coroutine starts when it is
+// called and its frame is released when it finishes, i.e.:
+//   uTLGBotTask conversation(uTLGBot& bot, int64_t chat_id)
+//   {
+//       co_await bot.send_message(chat_id, "What's your name?");
+//       co_await bot.next_update(chat_id);
+//       ...
+//   }
+class uTLGBotTask
+{
+    public:
+        struct promise_type
+        {
+            uTLGBotTask get_return_object() { return uTLGBotTask(); }
+            std::suspend_never initial_suspend() noexcept { return std::suspend_never(); }
+            std::suspend_never final_suspend() noexcept { return std::suspend_never(); }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+};
+
+// Awaitable received update (next_update()), the result is the update type and the update is in
+// the bot received data until the coroutine awaits again
+class uTLGBotUpdateAwaiter
+{
+    public:
+        uTLGBotUpdateAwaiter(uTLGBot* bot, const bool any_chat, const int64_t chat_id);
+        bool await_ready();
+        bool await_suspend(std::coroutine_handle<> handle);
+        uint8_t await_resume();
+
+    private:
+        uTLGBot* _bot;
+        bool _any_chat;
+        tlg_co_waiter _waiter;
+};
+
+// Awaitable sent message (send_message()), the result is true if the message was sent (its ID is
+// provided by get_sent_message_id() until the coroutine awaits again)
+class uTLGBotSendAwaiter
+{
+    public:
+        uTLGBotSendAwaiter(uTLGBot* bot, const int64_t chat_id, const char* text,
+            const char* parse_mode, const uint64_t reply_to_message_id,
+            const char* reply_markup);
+        bool await_ready();
+        bool await_suspend(std::coroutine_handle<> handle);
+        uint8_t await_resume();
+
+    private:
+        uTLGBot* _bot;
+        tlg_co_waiter _waiter;
+};
+
+#endif
+
+/**************************************************************************************************/
+
+/* Bots Reactor */
+
+#if defined(UTLGBOT_REACTOR)
+
+// Reactor: Single thread event loop that keeps a getUpdates long poll request in flight for each
+// added bot and runs each request phase (host resolution, connection, TLS handshake, request
+// write and response read) when its connection is ready for it, so the thread never waits for a
+// bot (many bots/tokens can be handled by the same thread), i.e.:
+//   uTLGBotReactor reactor;
+//   reactor.add_bot(Bot1, handle_update);
+//   reactor.add_bot(Bot2, handle_update);
+//   while(1) reactor.run_once();
+// Note: Handlers can use the bot API (i.e. sendMessage) as the bot connection is idle at that time
+// With C++20 compilers, bots added without handler provide their updates to the coroutines that
+// await them, and the messages sent with send_message() are written by the reactor thread while
+// the coroutines are suspended (so thousands of conversations are just suspended frames):
+//   uTLGBotTask bot_main(uTLGBot& bot)
+//   {
+//       while(1)
+//       {
+//           co_await bot.next_update();
+//           conversation(bot, bot.get_msg_chat_id());
+//       }
+//   }
+//   reactor.add_bot(Bot1);
+//   bot_main(Bot1);
+//   while(1) reactor.run_once();
+// Note: Coroutines still waiting when the reactor is destroyed are destroyed too
+class uTLGBotReactor
+{
+    friend class uTLGBot;
+
+    public:
+        // Public Methods
+        uTLGBotReactor();
+        ~uTLGBotReactor();
+        bool add_bot(uTLGBot& bot, tlg_reactor_update_handler handler, void* arg=NULL);
+#if defined(UTLGBOT_COROUTINES)
+        bool add_bot(uTLGBot& bot);
+#endif
+        uint32_t run_once(const unsigned long max_wait_ms=REACTOR_RETRY_MS);
+        uint32_t get_num_bots();
+        uint32_t get_num_polling();
+
+    private:
+        // Private Attributtes
+        int _epoll_fd;
+        tlg_reactor_entry* _entries;
+        uint32_t* _timers;
+        uint32_t _num_entries;
+        uint32_t _entries_size;
+        uint32_t _num_polling;
+#if defined(UTLGBOT_COROUTINES)
+        uint32_t _num_sending;
+#endif
+
+        // Private Methods
+        bool add_entry(uTLGBot& bot, tlg_reactor_update_handler handler, void* arg);
+        uint32_t arm(const uint32_t entry);
+        uint32_t poll_state(const uint32_t entry, const uint8_t state,
+            const uint8_t update_type);
+        bool watch_fd(int* watched_fd, const int fd, const bool out, const uint32_t data);
+        void unwatch(const uint32_t entry);
+        void abort(const uint32_t entry);
+#if defined(UTLGBOT_COROUTINES)
+        bool send_watch(const uint32_t entry);
+        void send_run(const uint32_t entry);
+        void send_unwatch(const uint32_t entry);
+        unsigned long send_timeouts(const unsigned long now, unsigned long wait_ms);
+        static void co_handler(uTLGBot& bot, const uint8_t update_type, void* arg);
+#endif
+        void timer_set(const uint32_t entry, const unsigned long deadline);
+        void timer_swap(const uint32_t pos_a, const uint32_t pos_b);
+        static bool time_before(const unsigned long t_a, const unsigned long t_b);
+
+        // Not copyable (owns its event loop)
+        uTLGBotReactor(const uTLGBotReactor&);
+        uTLGBotReactor& operator=(const uTLGBotReactor&);
+};
+
+#endif
+
+/**************************************************************************************************/
+
+/* Updates Dispatcher */
+
+#if defined(UTLGBOT_DISPATCHER)
+
+// Dispatcher: Hands the received messages of a bot to a pool of worker threads, so a slow handler
+// doesn't stop the other chats. The messages of a chat are handled in order, one at a time (each
+// chat goes to a worker by its ID, and idle workers take the whole chat from busy ones). Updates
+// are confirmed to Telegram just when they and all the previous ones are completed (a stopped
+// dispatcher gets again from Telegram all the updates from the oldest not completed one, so
+// delivery is at-least-once), i.e.:
+//   static uint64_t memory[8192];
+//   uTLGBotDispatcher dispatcher(Bot, memory, sizeof(memory), handle_msg);
+//   dispatcher.start();
+//   while(1) dispatcher.poll();
+// Note: Handlers receive a copy of the message and must not use the polling bot (use a bot per
+// worker to reply, i.e. bots[worker].sendMessage(record.chat_id, "Done"))
+class uTLGBotDispatcher
+{
+    public:
+        // Public Methods
+        uTLGBotDispatcher(uTLGBot& bot, void* memory, const size_t size,
+            tlg_dispatch_handler handler, void* arg=NULL,
+            const uint8_t num_workers=DISPATCHER_DEFAULT_WORKERS);
+        ~uTLGBotDispatcher();
+        bool start();
+        void stop();
+        uint8_t poll();
+        uint64_t get_commit_offset();
+        uint32_t get_num_pending();
+
+    private:
+        // Private Attributtes
+        uTLGBot& _bot;
+        uTLGBotMsgQueue _records;
+        tlg_dispatch_handler _handler;
+        void* _arg;
+        std::thread _workers[DISPATCHER_MAX_WORKERS];
+        std::mutex _mutex;
+        std::condition_variable _work_cv;
+        std::condition_variable _done_cv;
+        tlg_dispatch_slot _slots[DISPATCHER_MAX_PENDING];
+        tlg_dispatch_chat _chats[DISPATCHER_MAX_PENDING];
+        uint32_t _ready_head[DISPATCHER_MAX_WORKERS];
+        uint32_t _ready_tail[DISPATCHER_MAX_WORKERS];
+        uint64_t _received_offset;
+        uint32_t _oldest;
+        uint32_t _num_pending;
+        uint32_t _window_len;
+        uint32_t _window_max;
+        uint8_t _num_workers;
+        bool _running;
+        bool _stop;
+
+        // Private Methods
+        void worker_run(const uint8_t worker);
+        void commit();
+        void dispatch(const uint32_t slot);
+        void ready_push(const uint8_t worker, const uint32_t chat);
+        uint32_t ready_pop(const uint8_t worker);
+        void reset();
+
+        // Not copyable (owns its worker threads)
+        uTLGBotDispatcher(const uTLGBotDispatcher&);
+        uTLGBotDispatcher& operator=(const uTLGBotDispatcher&);
+};
+
+#endif
+
+/**************************************************************************************************/
+
+/* Updates Fan-out */
+
+#if defined(UTLGBOT_FANOUT)
+
+// Fan-out: Telegram allows just one getUpdates consumer per token, so one process polls the bot
+// and publishes the received messages records in a shared memory ring of each worker process
+// (the messages of a chat always go to the same worker, in order). Workers acknowledge each
+// record once it is handled, and updates are confirmed to Telegram just when they and all the
+// previous ones are acknowledged (a crashed worker gets its not acknowledged records again when it
+// attaches again, and a crashed or closed polling process gets again from Telegram all the updates
+// from the oldest not acknowledged one, so delivery is at-least-once), i.e.:
+//   Polling process:
+//     uTLGBotFanout fanout;
+//     fanout.create(Bot, "/mybot_updates", 4);
+//     while(1) fanout.poll();
+//   Worker processes (worker 0 to 3):
+//     uTLGBotFanout fanout;
+//     fanout.attach("/mybot_updates", worker);
+//     while(fanout.is_open())
+//         if((record = fanout.receive()) != NULL) { handle(record); fanout.ack(); }
+// Note: A NULL name creates an anonymous memory file (memfd) for forked workers (attach them
+// with the get_fd() file descriptor)
+class uTLGBotFanout
+{
+    public:
+        // Public Methods
+        uTLGBotFanout();
+        ~uTLGBotFanout();
+        bool create(uTLGBot& bot, const char* name, const uint8_t num_workers,
+            const uint32_t num_slots=FANOUT_DEFAULT_SLOTS);
+        bool attach(const char* name, const uint8_t worker);
+        bool attach(const int fd, const uint8_t worker);
+        void close();
+        bool is_open();
+        int get_fd();
+        uint8_t poll();
+        uint64_t get_commit_offset();
+        uint32_t get_num_pending();
+        const tlg_msg_record* receive(const unsigned long timeout_ms=FANOUT_REPOLL_MS);
+        bool ack();
+
+    private:
+        // Private Attributtes
+        uTLGBot* _bot;
+        int _fd;
+        char* _memory;
+        size_t _size;
+        tlg_fanout_header* _header;
+        tlg_fanout_ring* _rings;
+        char* _slots;
+        char _name[FANOUT_MAX_NAME_LENGTH];
+        uint64_t _received_offset;
+        uint64_t _oldest;
+        uint32_t _num_pending;
+        tlg_fanout_received _window[FANOUT_MAX_WINDOW];
+        uint32_t _window_head;
+        uint32_t _window_count;
+        uint32_t _window_len;
+        uint32_t _window_max;
+        int _worker;
+
+        // Private Methods
+        bool map(const int fd, const size_t size);
+        char* slot(const uint32_t worker, const uint32_t index);
+        void commit();
+        bool publish();
+        void window_add();
+        void window_clear();
+        void wait_acks(const uint32_t acks, const unsigned long timeout_ms);
+
+        // Not copyable (owns its shared memory mapping)
+        uTLGBotFanout(const uTLGBotFanout&);
+        uTLGBotFanout& operator=(const uTLGBotFanout&);
+};
+
+#endif
+
+/**************************************************************************************************/
+
 #endif
@@ -0,0 +1,456 @@
+/**************************************************************************************************/
+// Project: uTLGBotLib
+// File: bench_json.cpp
+// Description: JSON kernels benchmarks (library kernels against plain loops, on realistic message
+//              texts and getUpdates responses).
+// Created on: 19 oct. 2026
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include "unit.h"
+#include "test.h"
+
+/**************************************************************************************************/
+
+/* Constants */
+
+// Broadcast texts size
+#define TEXT_LEN 4096
+
+#define ESCAPE_RUNS 20000
+#define UNESCAPE_RUNS 20000
+#define KEYS_RUNS 200000
+#define TOKENIZE_BYTES (256 * 1024 * 1024)
+
+// Updates of the batched getUpdates response
+#define BATCH_UPDATES 100
+
+// Maximum number of tokens of the benchmarked JSON
+#define MAX_TOKENS 8192
+
+/**************************************************************************************************/
+
+/* Message Texts */
+
+// Create a text of TEXT_LEN bytes repeating the given sample
+static std::string make_text(const char* sample)
+{
+    std::string text;
+
+    while(text.size() < TEXT_LEN)
+        text += sample;
+    text.resize(TEXT_LEN);
+    return text;
+}
+
+// Realistic broadcast texts: plain prose, Markdown with lines and quotes, non Latin UTF-8 and a
+// code snippet (many bytes to escape)
+static const char* text_names[] = { "plain", "markdown", "utf8", "code" };
+static const char* text_samples[] =
+{
+    "The weekly report is ready, all services are running and there is no pending incident "
+    "for this week. Next maintenance window is planned for Sunday morning. ",
+    "*Weekly report*\n- Uptime: 99.98%\n- Incidents: 0\n\nSee the \"status\" page for details "
+    "and reply /help to get the list of commands.\n",
+    "\xd0\x9f\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82, \xd0\xbc\xd0\xb8\xd1\x80! "
+    "\xf0\x9f\x98\x80 \xe4\xbd\xa0\xe5\xa5\xbd\xe4\xb8\x96\xe7\x95\x8c "
+    "\xd0\x9e\xd1\x82\xd1\x87\xd0\xb5\xd1\x82 \xd0\xb3\xd0\xbe\xd1\x82\xd0\xbe\xd0\xb2. ",
+    "```\nif(strcmp(argv[1], \"-v\") == 0)\n{\n\tprintf(\"path: %s\\n\", \"C:\\\\bot\");\n}\n"
+    "```\n"
+};
+
+// Text message update of a getUpdates response (command with entities, from a user in a
+// private chat)
+static const char update_json[] =
+    "{\"update_id\":784512390,\"message\":{\"message_id\":5531,\"from\":{\"id\":611234567,"
+    "\"is_bot\":false,\"first_name\":\"Alice\",\"last_name\":\"Smith\",\"username\":\"alice_s\","
+    "\"language_code\":\"en\"},\"chat\":{\"id\":611234567,\"first_name\":\"Alice\","
+    "\"last_name\":\"Smith\",\"username\":\"alice_s\",\"type\":\"private\"},\"date\":1760870400,"
+    "\"text\":\"/status web-01 please\",\"entities\":[{\"offset\":0,\"length\":7,"
+    "\"type\":\"bot_command\"}]}}";
+
+// Create a getUpdates response with the given number of updates (texts of different lengths,
+// some with escapes)
+static std::string make_updates_response(const uint32_t num_updates)
+{
+    std::string response = "{\"ok\":true,\"result\":[";
+    std::string update;
+    std::string text;
+    char update_id[16];
+
+    for(uint32_t i = 0; i < num_updates; i++)
+    {
+        text = std::string(update_json);
+        text = text.substr(text.find("\"update_id\"") + 21);
+        snprintf(update_id, sizeof(update_id), "%u", 784512390 + i);
+        update = std::string("{\"update_id\":") + update_id + text;
+        if(i % 3 == 1)
+        {
+            update.replace(update.find("/status web-01 please"), 21, std::string(i * 4, 'x') +
+                " \\\"quoted\\\"\\nnext line");
+        }
+        if(i > 0)
+            response += ",";
+        response += update;
+    }
+    response += "]}";
+    return response;
+}
+
+/**************************************************************************************************/
+
+/* Plain Loops */
+
+// Escape a string byte by byte
+static int32_t naive_escape(const char* src, const size_t src_len, char* dest,
+    const size_t dest_max_size)
+{
+    static const char hex[] = "0123456789abcdef";
+    size_t o = 0;
+
+    for(size_t i = 0; i < src_len; i++)
+    {
+        char c = src[i];
+        if(o + 6 >= dest_max_size)
+            return -1;
+        switch(c)
+        {
+            case '"':  dest[o++] = '\\'; dest[o++] = '"';  break;
+            case '\\': dest[o++] = '\\'; dest[o++] = '\\'; break;
+            case '\b': dest[o++] = '\\'; dest[o++] = 'b';  break;
+            case '\f': dest[o++] = '\\'; dest[o++] = 'f';  break;
+            case '\n': dest[o++] = '\\'; dest[o++] = 'n';  break;
+            case '\r': dest[o++] = '\\'; dest[o++] = 'r';  break;
+            case '\t': dest[o++] = '\\'; dest[o++] = 't';  break;
+            default:
+                if((uint8_t)c < 0x20)
+                {
+                    dest[o++] = '\\';
+                    dest[o++] = 'u';
+                    dest[o++] = '0';
+                    dest[o++] = '0';
+                    dest[o++] = hex[(uint8_t)c >> 4];
+                    dest[o++] = hex[(uint8_t)c & 0x0F];
+                }
+                else
+                    dest[o++] = c;
+                break;
+        }
+    }
+    dest[o] = '\0';
+    return (int32_t)o;
+}
+
+// Get the value of 4 hexadecimal chars (-1 if they are not)
+static int32_t naive_hex4(const char* str)
+{
+    int32_t value = 0;
+
+    for(uint32_t i = 0; i < 4; i++)
+    {
+        char c = str[i];
+        value = value << 4;
+        if((c >= '0') && (c <= '9'))
+            value = value | (c - '0');
+        else if(((c | 0x20) >= 'a') && ((c | 0x20) <= 'f'))
+            value = value | ((c | 0x20) - 'a' + 10);
+        else
+            return -1;
+    }
+    return value;
+}
+
+// Unescape a JSON string value byte by byte (surrogate pairs are decoded)
+static uint32_t naive_unescape(const char* src, const size_t src_len, char* dest,
+    const size_t dest_max_size)
+{
+    size_t o = 0;
+    int32_t cp, cp_low;
+
+    for(size_t i = 0; i < src_len; i++)
+    {
+        if(o + 4 >= dest_max_size)
+            break;
+        if((src[i] != '\\') || (i + 1 >= src_len))
+        {
+            dest[o++] = src[i];
+            continue;
+        }
+        i = i + 1;
+        switch(src[i])
+        {
+            case 'b': dest[o++] = '\b'; break;
+            case 'f': dest[o++] = '\f'; break;
+            case 'n': dest[o++] = '\n'; break;
+            case 'r': dest[o++] = '\r'; break;
+            case 't': dest[o++] = '\t'; break;
+            case 'u':
+                cp = (i + 4 < src_len) ? naive_hex4(src + i + 1) : -1;
+                if(cp < 0)
+                {
+                    dest[o++] = 'u';
+                    break;
+                }
+                i = i + 4;
+                if((cp >= 0xD800) && (cp <= 0xDBFF) && (i + 6 < src_len) && (src[i+1] == '\\') &&
+                    (src[i+2] == 'u') && ((cp_low = naive_hex4(src + i + 3)) >= 0xDC00) &&
+                    (cp_low <= 0xDFFF))
+                {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (cp_low - 0xDC00);
+                    i = i + 6;
+                }
+                if(cp < 0x80)
+                    dest[o++] = (char)cp;
+                else if(cp < 0x800)
+                {
+                    dest[o++] = (char)(0xC0 | (cp >> 6));
+                    dest[o++] = (char)(0x80 | (cp & 0x3F));
+                }
+                else if(cp < 0x10000)
+                {
+                    dest[o++] = (char)(0xE0 | (cp >> 12));
+                    dest[o++] = (char)(0x80 | ((cp >> 6) & 0x3F));
+                    dest[o++] = (char)(0x80 | (cp & 0x3F));
+                }
+                else
+                {
+                    dest[o++] = (char)(0xF0 | (cp >> 18));
+                    dest[o++] = (char)(0x80 | ((cp >> 12) & 0x3F));
+                    dest[o++] = (char)(0x80 | ((cp >> 6) & 0x3F));
+                    dest[o++] = (char)(0x80 | (cp & 0x3F));
+                }
+                break;
+            default: dest[o++] = src[i]; break;
+        }
+    }
+    dest[o] = '\0';
+    return (uint32_t)o;
+}
+
+// Get the position of a key in the given tokens looking at each one (strlen() and strncmp() for
+// each string token), as json_has_key() did before the known keys hash table
+static uint32_t linear_has_key(const char* json_str, jsmntok_t* json_tokens,
+    const uint32_t num_tokens, const char* key)
+{
+    for(uint32_t i = 0; i < num_tokens; i++)
+    {
+        if(json_tokens[i].type != JSMN_STRING)
+            continue;
+        if(strlen(key) != (unsigned int)(json_tokens[i].end-json_tokens[i].start))
+            continue;
+        if(strncmp(json_str + json_tokens[i].start, key,
+            json_tokens[i].end - json_tokens[i].start) == 0)
+        {
+            return i;
+        }
+    }
+    return 0;
+}
+
+/**************************************************************************************************/
+
+/* Benchmarks */
+
+// Escape of the broadcast texts (sendMessage text field), library kernel against the byte by
+// byte loop
+static void bench_escape(void)
+{
+    static char dest[(TEXT_LEN * 6) + 1];
+    char name[64];
+    uint64_t t0;
+
+    printf("bench_escape (%u bytes texts)\n", TEXT_LEN);
+    for(uint32_t t = 0; t < sizeof(text_samples)/sizeof(text_samples[0]); t++)
+    {
+        std::string text = make_text(text_samples[t]);
+
+        t0 = bench_nanos();
+        for(uint32_t i = 0; i < ESCAPE_RUNS; i++)
+            bench_sink = bench_sink + naive_escape(text.c_str(), text.size(), dest, sizeof(dest));
+        snprintf(name, sizeof(name), "%s: byte loop", text_names[t]);
+        bench_result(name, (uint64_t)text.size() * ESCAPE_RUNS, ESCAPE_RUNS, bench_nanos() - t0);
+
+        t0 = bench_nanos();
+        for(uint32_t i = 0; i < ESCAPE_RUNS; i++)
+        {
+            bench_sink = bench_sink + uTLGBotTests::json_escape_str(text.c_str(), text.size(),
+                dest, sizeof(dest));
+        }
+        snprintf(name, sizeof(name), "%s: json_escape_str", text_names[t]);
+        bench_result(name, (uint64_t)text.size() * ESCAPE_RUNS, ESCAPE_RUNS, bench_nanos() - t0);
+    }
+}
+
+// Unescape of received texts (as they come in the JSON, the escaped broadcast texts and a text
+// with "\\uXXXX" escaped emojis), library kernel against the byte by byte loop
+static void bench_unescape(void)
+{
+    static char src[(TEXT_LEN * 6) + 1];
+    static char dest[TEXT_LEN * 2];
+    const char* names[] = { "plain", "markdown", "utf8", "code", "emoji escapes" };
+    std::string text;
+    char name[64];
+    size_t len;
+    uint64_t t0;
+
+    printf("bench_unescape (%u bytes texts)\n", TEXT_LEN);
+    for(uint32_t t = 0; t < sizeof(names)/sizeof(names[0]); t++)
+    {
+        if(t < sizeof(text_samples)/sizeof(text_samples[0]))
+        {
+            text = make_text(text_samples[t]);
+            len = uTLGBotTests::json_escape_str(text.c_str(), text.size(), src, sizeof(src));
+        }
+        else
+        {
+            text = make_text("Done \\ud83d\\ude00 \\u2705 ");
+            len = text.size();
+            memcpy(src, text.c_str(), len + 1);
+        }
+
+        t0 = bench_nanos();
+        for(uint32_t i = 0; i < UNESCAPE_RUNS; i++)
+            bench_sink = bench_sink + naive_unescape(src, len, dest, sizeof(dest));
+        snprintf(name, sizeof(name), "%s: byte loop", names[t]);
+        bench_result(name, (uint64_t)len * UNESCAPE_RUNS, UNESCAPE_RUNS, bench_nanos() - t0);
+
+        t0 = bench_nanos();
+        for(uint32_t i = 0; i < UNESCAPE_RUNS; i++)
+            bench_sink = bench_sink + uTLGBotTests::json_unescape_str(src, len, dest, sizeof(dest));
+        snprintf(name, sizeof(name), "%s: json_unescape_str", names[t]);
+        bench_result(name, (uint64_t)len * UNESCAPE_RUNS, UNESCAPE_RUNS, bench_nanos() - t0);
+    }
+}
+
+// Lookup of the keys of an update (update, message, from and chat objects), linear scans of the
+// tokens for each key against a single pass over the keys of each object with the hash table
+static void bench_keys(void)
+{
+    static const char* root_keys[] = { "update_id", "message" };
+    static const char* msg_keys[] = { "message_id", "date", "text", "from", "chat", "entities",
+        "caption", "document", "photo", "sticker", "reply_to_message", "forward_from" };
+    static const char* user_keys[] = { "id", "is_bot", "first_name", "last_name", "username",
+        "language_code" };
+    static const char* chat_keys[] = { "id", "type", "title", "username", "first_name",
+        "last_name", "all_members_are_administrators" };
+    static jsmntok_t tokens[MAX_TOKENS];
+    static uint32_t subtree_len[MAX_TOKENS];
+    uint32_t keys_position[TLG_NUM_KEYS];
+    uTLGBot bot("123:ABC");
+    jsmn_parser parser;
+    uint32_t msg, from, chat, end;
+    uint64_t t0;
+    int num_tokens;
+
+    jsmn_init(&parser);
+    num_tokens = jsmn_parse(&parser, update_json, strlen(update_json), tokens, MAX_TOKENS);
+    if(num_tokens <= 0)
+        return;
+    printf("bench_keys (%d tokens update)\n", num_tokens);
+
+    // Nested objects keys are looked up in the tokens of the object
+    t0 = bench_nanos();
+    for(uint32_t i = 0; i < KEYS_RUNS; i++)
+    {
+        for(uint32_t k = 0; k < sizeof(root_keys)/sizeof(root_keys[0]); k++)
+            bench_sink = bench_sink + linear_has_key(update_json, tokens, num_tokens, root_keys[k]);
+        for(uint32_t k = 0; k < sizeof(msg_keys)/sizeof(msg_keys[0]); k++)
+            bench_sink = bench_sink + linear_has_key(update_json, tokens, num_tokens, msg_keys[k]);
+        from = linear_has_key(update_json, tokens, num_tokens, "from") + 1;
+        chat = linear_has_key(update_json, tokens, num_tokens, "chat") + 1;
+        for(end = from + 1; (end < (uint32_t)num_tokens) && (tokens[end].start <
+            tokens[from].end); end++) {}
+        for(uint32_t k = 0; k < sizeof(user_keys)/sizeof(user_keys[0]); k++)
+        {
+            bench_sink = bench_sink + linear_has_key(update_json, tokens + from, end - from,
+                user_keys[k]);
+        }
+        for(end = chat + 1; (end < (uint32_t)num_tokens) && (tokens[end].start <
+            tokens[chat].end); end++) {}
+        for(uint32_t k = 0; k < sizeof(chat_keys)/sizeof(chat_keys[0]); k++)
+        {
+            bench_sink = bench_sink + linear_has_key(update_json, tokens + chat, end - chat,
+                chat_keys[k]);
+        }
+    }
+    bench_result("linear scans (json_has_key)", (uint64_t)strlen(update_json) * KEYS_RUNS,
+        KEYS_RUNS, bench_nanos() - t0);
+
+    t0 = bench_nanos();
+    for(uint32_t i = 0; i < KEYS_RUNS; i++)
+    {
+        uTLGBotTests::json_index_subtrees(bot, tokens, num_tokens, subtree_len);
+        uTLGBotTests::json_map_keys(bot, update_json, tokens, subtree_len, 0, keys_position);
+        msg = keys_position[TLG_KEY_MESSAGE] + 1;
+        uTLGBotTests::json_map_keys(bot, update_json, tokens, subtree_len, msg, keys_position);
+        from = keys_position[TLG_KEY_FROM] + 1;
+        chat = keys_position[TLG_KEY_CHAT] + 1;
+        uTLGBotTests::json_map_keys(bot, update_json, tokens, subtree_len, from, keys_position);
+        bench_sink = bench_sink + keys_position[TLG_KEY_ID];
+        uTLGBotTests::json_map_keys(bot, update_json, tokens, subtree_len, chat, keys_position);
+        bench_sink = bench_sink + keys_position[TLG_KEY_ID];
+    }
+    bench_result("keys hash (json_map_keys)", (uint64_t)strlen(update_json) * KEYS_RUNS,
+        KEYS_RUNS, bench_nanos() - t0);
+}
+
+// Tokenize a getUpdates response (one update and a batch of updates), jsmn against the SIMD
+// tokenizer
+static void bench_tokenize(void)
+{
+    static jsmntok_t tokens[MAX_TOKENS];
+    const char* names[] = { "1 update", "batch" };
+    std::string responses[2];
+    jsmn_parser parser;
+    char name[64];
+    uint32_t runs;
+    uint64_t t0;
+
+    responses[0] = make_updates_response(1);
+    responses[1] = make_updates_response(BATCH_UPDATES);
+    printf("bench_tokenize (%u and %u bytes responses)\n", (unsigned)responses[0].size(),
+        (unsigned)responses[1].size());
+    for(uint32_t r = 0; r < 2; r++)
+    {
+        const char* json = responses[r].c_str();
+        size_t len = responses[r].size();
+
+        runs = TOKENIZE_BYTES / len;
+        t0 = bench_nanos();
+        for(uint32_t i = 0; i < runs; i++)
+        {
+            jsmn_init(&parser);
+            bench_sink = bench_sink + jsmn_parse(&parser, json, len, tokens, MAX_TOKENS);
+        }
+        snprintf(name, sizeof(name), "%s: jsmn", names[r]);
+        bench_result(name, (uint64_t)len * runs, runs, bench_nanos() - t0);
+
+#if defined(UTLGBOT_SIMD_WIDTH)
+        t0 = bench_nanos();
+        for(uint32_t i = 0; i < runs; i++)
+            bench_sink = bench_sink + json_simd_parse(json, len, tokens, MAX_TOKENS);
+        snprintf(name, sizeof(name), "%s: json_simd_parse", names[r]);
+        bench_result(name, (uint64_t)len * runs, runs, bench_nanos() - t0);
+#endif
+    }
+}
+
+/**************************************************************************************************/
+
+/* Main Function */
+
+int main(void)
+{
+#if defined(UTLGBOT_SIMD_WIDTH)
+    printf("bench_json (SIMD, %d bytes)\n", UTLGBOT_SIMD_WIDTH);
+#else
+    printf("bench_json (no SIMD)\n");
+#endif
+    bench_escape();
+    bench_unescape();
+    bench_keys();
+    bench_tokenize();
+
+    return 0;
+}
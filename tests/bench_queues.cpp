@@ -0,0 +1,171 @@
+/**************************************************************************************************/
+// Project: uTLGBotLib
+// File: bench_queues.cpp
+// Description: Lock-free queues benchmarks (SPSC and MPSC queues under contention against a queue
+//              protected by a mutex and condition variables).
+// Created on: 19 oct. 2026
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "utlgbotlib.h"
+#include "test.h"
+
+/**************************************************************************************************/
+
+/* Constants */
+
+#define QUEUE_SIZE 64
+#define QUEUE_ITEMS 1000000
+
+/**************************************************************************************************/
+
+/* Mutex Queue */
+
+// Bounded FIFO protected by a mutex, producers and consumer wait on condition variables while it
+// is full or empty
+template<typename T, size_t N>
+class mutex_queue
+{
+    public:
+        mutex_queue() : _head(0), _tail(0) {}
+
+        void push(T&& item)
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+
+            _not_full.wait(lock, [this]() { return (_tail - _head < N); });
+            _items[_tail % N] = std::move(item);
+            _tail = _tail + 1;
+            lock.unlock();
+            _not_empty.notify_one();
+        }
+
+        void pop(T& item)
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+
+            _not_empty.wait(lock, [this]() { return (_tail != _head); });
+            item = std::move(_items[_head % N]);
+            _head = _head + 1;
+            lock.unlock();
+            _not_full.notify_one();
+        }
+
+    private:
+        std::mutex _mutex;
+        std::condition_variable _not_full;
+        std::condition_variable _not_empty;
+        T _items[N];
+        size_t _head;
+        size_t _tail;
+};
+
+/**************************************************************************************************/
+
+/* Functions */
+
+// Push to a lock-free queue, yielding while it is full
+template<typename Q>
+static void lockfree_push(Q& queue, uint64_t item)
+{
+    while(!queue.push(std::move(item)))
+        std::this_thread::yield();
+}
+
+// Pop from a lock-free queue, yielding while it is empty
+template<typename Q>
+static uint64_t lockfree_pop(Q& queue)
+{
+    uint64_t item;
+
+    while(!queue.pop(item))
+        std::this_thread::yield();
+    return item;
+}
+
+// Push to a mutex queue
+template<typename Q>
+static void mutex_push(Q& queue, uint64_t item)
+{
+    queue.push(std::move(item));
+}
+
+// Pop from a mutex queue
+template<typename Q>
+static uint64_t mutex_pop(Q& queue)
+{
+    uint64_t item;
+
+    queue.pop(item);
+    return item;
+}
+
+// Pass the items from the producers threads to the consumer one (this thread) through a queue
+template<typename Q>
+static void bench_run(const char* name, Q& queue, const uint32_t producers,
+    void (*push)(Q&, uint64_t), uint64_t (*pop)(Q&))
+{
+    std::thread threads[8];
+    uint64_t t0;
+
+    t0 = bench_nanos();
+    for(uint32_t p = 0; p < producers; p++)
+    {
+        threads[p] = std::thread([&queue, push, producers]()
+        {
+            for(uint32_t i = 0; i < QUEUE_ITEMS/producers; i++)
+                push(queue, i);
+        });
+    }
+    for(uint32_t i = 0; i < (QUEUE_ITEMS/producers) * producers; i++)
+        bench_sink = bench_sink + pop(queue);
+    for(uint32_t p = 0; p < producers; p++)
+        threads[p].join();
+    bench_result(name, (uint64_t)QUEUE_ITEMS * sizeof(uint64_t), QUEUE_ITEMS,
+        bench_nanos() - t0);
+}
+
+/**************************************************************************************************/
+
+/* Benchmarks */
+
+// One producer thread and one consumer thread
+static void bench_spsc(void)
+{
+    static uTLGBotSPSCQueue<uint64_t, QUEUE_SIZE> spsc;
+    static mutex_queue<uint64_t, QUEUE_SIZE> mutexq;
+
+    printf("bench_spsc (%u items, %u slots)\n", QUEUE_ITEMS, QUEUE_SIZE);
+    bench_run("lock-free SPSC", spsc, 1, lockfree_push, lockfree_pop);
+    bench_run("mutex and condvars", mutexq, 1, mutex_push, mutex_pop);
+}
+
+// Many producers threads and one consumer thread
+static void bench_mpsc(const uint32_t producers)
+{
+    static uTLGBotMPSCQueue<uint64_t, QUEUE_SIZE> mpsc;
+    static mutex_queue<uint64_t, QUEUE_SIZE> mutexq;
+
+    printf("bench_mpsc (%u items, %u slots, %u producers)\n", QUEUE_ITEMS, QUEUE_SIZE,
+        producers);
+    bench_run("lock-free MPSC", mpsc, producers, lockfree_push, lockfree_pop);
+    bench_run("mutex and condvars", mutexq, producers, mutex_push, mutex_pop);
+}
+
+/**************************************************************************************************/
+
+/* Main Function */
+
+int main(void)
+{
+    printf("%u CPUs\n", std::thread::hardware_concurrency());
+    bench_spsc();
+    bench_mpsc(2);
+    bench_mpsc(4);
+
+    return 0;
+}
@@ -0,0 +1,111 @@
+/**************************************************************************************************/
+// Project: uTLGBotLib
+// File: bench_updates.cpp
+// Description: Received updates benchmarks (eager against lazy decoding for the access pattern of
+//              a command bot, and memory of the received messages kept as packed records against
+//              tlg_type_message copies).
+// Created on: 19 oct. 2026
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include "unit.h"
+#include "test.h"
+
+/**************************************************************************************************/
+
+/* Constants */
+
+#define DECODE_RUNS 200000
+#define QUEUE_MESSAGES 10000
+#define QUEUE_MEMORY_SIZE (4*1024*1024)
+
+/**************************************************************************************************/
+
+/* Updates */
+
+// getUpdates result with a text message update (command with entities, from a user in a group)
+static const char update_result[] =
+    "[{\"update_id\":784512390,\"message\":{\"message_id\":5531,\"from\":{\"id\":611234567,"
+    "\"is_bot\":false,\"first_name\":\"Alice\",\"last_name\":\"Smith\",\"username\":\"alice_s\","
+    "\"language_code\":\"en\"},\"chat\":{\"id\":-1001234567890,\"title\":\"Ops team\","
+    "\"username\":\"ops_team\",\"type\":\"supergroup\"},\"date\":1760870400,"
+    "\"text\":\"/status web-01 please\",\"entities\":[{\"offset\":0,\"length\":7,"
+    "\"type\":\"bot_command\"}]}}]";
+
+/**************************************************************************************************/
+
+/* Benchmarks */
+
+// Receive an update and handle it as a command bot does (just the chat ID and the text are read,
+// or all the message fields)
+static void bench_decode_run(const char* name, const bool lazy, const bool all_fields)
+{
+    uTLGBot bot("123:ABC");
+    uint64_t t0;
+
+    bot.set_lazy_decode(lazy);
+    t0 = bench_nanos();
+    for(uint32_t i = 0; i < DECODE_RUNS; i++)
+    {
+        if(uTLGBotTests::receive_updates(bot, update_result) != TLG_UPDATE_MESSAGE)
+            return;
+        bench_sink = bench_sink + bot.get_msg_chat_id() + bot.get_msg_text()[0];
+        if(all_fields)
+            bench_sink = bench_sink + bot.get_msg(TLG_MSG_HAS_ALL).from.first_name[0];
+    }
+    bench_result(name, (uint64_t)strlen(update_result) * DECODE_RUNS, DECODE_RUNS,
+        bench_nanos() - t0);
+}
+
+// Eager against lazy decoding of the received messages
+static void bench_decode(void)
+{
+    printf("bench_decode (%u bytes update)\n", (unsigned)strlen(update_result));
+    bench_decode_run("eager: chat id and text", false, false);
+    bench_decode_run("lazy: chat id and text", true, false);
+    bench_decode_run("eager: all fields", false, true);
+    bench_decode_run("lazy: all fields", true, true);
+}
+
+// Memory used to keep 10k received messages (the command update, with short names and text) as
+// packed records of the records queue, against keeping them as tlg_type_message copies
+static void bench_queue_memory(void)
+{
+    static uint64_t memory[QUEUE_MEMORY_SIZE/sizeof(uint64_t)];
+    uTLGBotMsgQueue queue(memory, sizeof(memory));
+    uTLGBot bot("123:ABC");
+    uint64_t t0;
+
+    printf("bench_queue_memory (%u messages)\n", QUEUE_MESSAGES);
+    bot.set_lazy_decode(true);
+    t0 = bench_nanos();
+    for(uint32_t i = 0; i < QUEUE_MESSAGES; i++)
+    {
+        if((uTLGBotTests::receive_updates(bot, update_result) != TLG_UPDATE_MESSAGE) ||
+            !queue.push(bot))
+        {
+            printf("  push %u failed\n", i);
+            return;
+        }
+    }
+    bench_result("receive and push", (uint64_t)strlen(update_result) * QUEUE_MESSAGES,
+        QUEUE_MESSAGES, bench_nanos() - t0);
+    printf("  %-36s %9lu bytes %10.1f bytes/msg\n", "records queue",
+        (unsigned long)queue.get_used(), (double)queue.get_used() / QUEUE_MESSAGES);
+    printf("  %-36s %9lu bytes %10.1f bytes/msg\n", "tlg_type_message copies",
+        (unsigned long)(sizeof(tlg_type_message) * QUEUE_MESSAGES),
+        (double)sizeof(tlg_type_message));
+}
+
+/**************************************************************************************************/
+
+/* Main Function */
+
+int main(void)
+{
+    bench_decode();
+    bench_queue_memory();
+
+    return 0;
+}
@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+# Telegram Bot API mock server for the uTLGBotLib tests (HTTPS, keep-alive connections)
+#
+# Usage: mock_server.py port cert.pem key.pem config.json log.jsonl
+#
+# Config (all keys are optional):
+#   updates: List of updates that getUpdates provides (confirmed ones are removed, as Telegram
+#            does, when an offset greater than their update_id is requested)
+#   late_updates: List of {"after_ms": time, "update": update} that are added to the updates
+#                 once the time since the server start has elapsed
+#   fail_chats: Chat IDs that sendMessage rejects (400 Bad Request: chat not found)
+#   send_delay_ms: Delay before answer sendMessage, editMessageText and editMessageReplyMarkup
+#   split_ms: Send each response in two parts (the header with half the body, and the rest of the
+#             body after this delay)
+#   stall_accepts: Number of first accepted connections that are held open without ever doing
+#                  the TLS handshake (a server that doesn't answer)
+#
+# Each request is written in the log file as a JSON line ({"method":..., "body":...}), and each
+# accepted connection (once its TLS handshake is done) as {"method":"_accept"}. Once listening,
+# "READY" is written to stdout.
+
+import json
+import socket
+import ssl
+import sys
+import threading
+import time
+
+PORT = int(sys.argv[1])
+CONFIG = json.load(open(sys.argv[4]))
+LOG = open(sys.argv[5], 'a', buffering=1)
+
+updates = list(CONFIG.get('updates', []))
+late_updates = list(CONFIG.get('late_updates', []))
+t_start = time.monotonic()
+fail_chats = [str(chat) for chat in CONFIG.get('fail_chats', [])]
+send_delay_ms = CONFIG.get('send_delay_ms', 0)
+split_ms = CONFIG.get('split_ms', 0)
+stall_accepts = [CONFIG.get('stall_accepts', 0)]
+stalled = []
+lock = threading.Lock()
+msg_id = [1000]
+
+
+def log(entry):
+    with lock:
+        LOG.write(json.dumps(entry) + '\n')
+
+
+def get_updates(body):
+    req = json.loads(body) if body else {}
+    offset = req.get('offset', 0)
+    limit = req.get('limit', 100)
+    with lock:
+        elapsed_ms = (time.monotonic() - t_start) * 1000
+        while late_updates and late_updates[0]['after_ms'] <= elapsed_ms:
+            updates.append(late_updates.pop(0)['update'])
+        # Initial offset (UINT64_MAX) doesn't confirm anything
+        if offset < 2**62:
+            updates[:] = [u for u in updates if u['update_id'] >= offset]
+        result = updates[:limit]
+    if not result:
+        time.sleep(0.02)
+    return {"ok": True, "result": result}
+
+
+def send_message(body):
+    if send_delay_ms:
+        time.sleep(send_delay_ms / 1000.0)
+    req = json.loads(body)
+    with lock:
+        msg_id[0] += 1
+        mid = req.get('message_id', msg_id[0])
+    if str(req.get('chat_id')) in fail_chats:
+        return {"ok": False, "error_code": 400, "description": "Bad Request: chat not found"}
+    return {"ok": True, "result": {"message_id": mid, "from": {"id": 1, "is_bot": True,
+            "first_name": "bot"}, "chat": {"id": req.get('chat_id'), "type": "private"},
+            "date": 1, "text": req.get('text', '')}}
+
+
+def handle_api(method, body):
+    if method == 'getUpdates':
+        return get_updates(body)
+    if method in ('sendMessage', 'editMessageText', 'editMessageReplyMarkup'):
+        return send_message(body)
+    if method == 'answerCallbackQuery':
+        json.loads(body)
+        return {"ok": True, "result": True}
+    if method == 'getMe':
+        return {"ok": True, "result": {"id": 1, "is_bot": True, "first_name": "bot"}}
+    return {"ok": False, "error_code": 404, "description": "Not Found"}
+
+
+def serve(ctx, conn):
+    try:
+        conn = ctx.wrap_socket(conn, server_side=True)
+    except (OSError, ssl.SSLError):
+        conn.close()
+        return
+    log({"method": "_accept"})
+    f = conn.makefile('rb')
+    try:
+        while True:
+            line = f.readline()
+            if not line:
+                return
+            headers = {}
+            while True:
+                header = f.readline().decode()
+                if header in ('\r\n', '\n', ''):
+                    break
+                key, value = header.split(':', 1)
+                headers[key.strip().lower()] = value.strip()
+            length = int(headers.get('content-length', 0))
+            body = f.read(length).decode() if length else ''
+            method = line.decode().split()[1].rsplit('/', 1)[-1]
+            try:
+                res = handle_api(method, body)
+                log({"method": method, "body": body})
+            except ValueError as e:
+                log({"method": method, "body": body, "error": str(e)})
+                res = {"ok": False, "error_code": 400, "description": "Bad Request: bad JSON"}
+            payload = json.dumps(res, separators=(',', ':')).encode()
+            status = "200 OK" if res["ok"] else "400 Bad Request"
+            header = ("HTTP/1.1 %s\r\nServer: mock\r\nContent-Type: application/json\r\n"
+                      "Content-Length: %d\r\nConnection: keep-alive\r\n\r\n" %
+                      (status, len(payload))).encode()
+            if split_ms:
+                conn.sendall(header + payload[:len(payload) // 2])
+                time.sleep(split_ms / 1000.0)
+                conn.sendall(payload[len(payload) // 2:])
+            else:
+                conn.sendall(header + payload)
+    except (OSError, ssl.SSLError):
+        pass
+    finally:
+        conn.close()
+
+
+def main():
+    ctx = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+    ctx.load_cert_chain(sys.argv[2], sys.argv[3])
+    server = socket.socket()
+    server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    server.bind(('127.0.0.1', PORT))
+    server.listen(512)
+    print('READY', flush=True)
+    while True:
+        conn, _ = server.accept()
+        if stall_accepts[0] > 0:
+            stall_accepts[0] -= 1
+            stalled.append(conn)
+            continue
+        threading.Thread(target=serve, args=(ctx, conn), daemon=True).start()
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,218 @@
+/**************************************************************************************************/
+// Project: uTLGBotLib
+// File: test.h
+// Description: uTLGBotLib tests checks, benchmarks timing and Telegram Bot API mock server
+//              control.
+// Created on: 19 oct. 2026
+/**************************************************************************************************/
+
+#ifndef UTLGBOT_TEST_H_
+#define UTLGBOT_TEST_H_
+
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <time.h>
+
+/**************************************************************************************************/
+
+/* Checks */
+
+static unsigned test_checks = 0;
+static unsigned test_fails = 0;
+
+// Check a condition, showing the failed ones
+#define CHECK(cond) do { \
+    test_checks = test_checks + 1; \
+    if(!(cond)) \
+    { \
+        test_fails = test_fails + 1; \
+        printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+    } \
+} while(0)
+
+// Show the checks result and get the program exit code
+static inline int test_result(const char* name)
+{
+    printf("%s: %u checks, %u failed\n", name, test_checks, test_fails);
+    return (test_fails == 0) ? 0 : 1;
+}
+
+// Get current time in milliseconds (monotonic)
+static inline unsigned long test_millis(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (unsigned long)((now.tv_sec * 1000) + (now.tv_nsec / 1000000));
+}
+
+/**************************************************************************************************/
+
+/* Benchmarks */
+
+// Get current time in nanoseconds (monotonic)
+static inline uint64_t bench_nanos(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+}
+
+// Show a benchmark result as throughput (MB/s of the processed bytes) and time per run
+static inline void bench_result(const char* name, const uint64_t bytes, const uint32_t runs,
+    const uint64_t nanos)
+{
+    printf("  %-36s %9.1f MB/s %10.1f ns/run\n", name,
+        (nanos > 0) ? ((double)bytes * 1000.0 / (double)nanos) : 0.0,
+        (double)nanos / (double)runs);
+}
+
+// Keep a result alive, so the compiler doesn't remove the benchmarked code
+static volatile uint64_t bench_sink = 0;
+
+/**************************************************************************************************/
+
+/* Mock Server */
+
+// Mock server files (the certificate is created by the Makefile)
+#define MOCK_SERVER "./mock_server.py"
+#define MOCK_CERT "build/mock_cert.pem"
+#define MOCK_KEY "build/mock_key.pem"
+#define MOCK_CONFIG "build/mock_config.json"
+#define MOCK_LOG "build/mock_log.jsonl"
+
+static pid_t mock_pid = -1;
+static int mock_out = -1;
+static bool mock_stop_at_exit = false;
+
+// Stop the mock server
+static inline void mock_stop(void)
+{
+    if(mock_pid == -1)
+        return;
+    kill(mock_pid, SIGTERM);
+    waitpid(mock_pid, NULL, 0);
+    close(mock_out);
+    mock_pid = -1;
+    mock_out = -1;
+}
+
+// Start the mock server with the given config (JSON object), waiting until it is listening
+static inline bool mock_start(const char* config)
+{
+    char port[16];
+    char ready[16];
+    int out[2];
+    FILE* file;
+    ssize_t len;
+
+    mock_stop();
+    file = fopen(MOCK_CONFIG, "w");
+    if(file == NULL)
+        return false;
+    fputs(config, file);
+    fclose(file);
+    file = fopen(MOCK_LOG, "w");
+    if(file == NULL)
+        return false;
+    fclose(file);
+
+    snprintf(port, sizeof(port), "%d", HTTPS_PORT);
+    if(pipe(out) != 0)
+        return false;
+    mock_pid = fork();
+    if(mock_pid == 0)
+    {
+        dup2(out[1], STDOUT_FILENO);
+        close(out[0]);
+        close(out[1]);
+        execlp("python3", "python3", MOCK_SERVER, port, MOCK_CERT, MOCK_KEY, MOCK_CONFIG,
+            MOCK_LOG, (char*)NULL);
+        _exit(127);
+    }
+    close(out[1]);
+    mock_out = out[0];
+    len = read(mock_out, ready, sizeof(ready)-1);
+    if((mock_pid == -1) || (len < 5) || (strncmp(ready, "READY", 5) != 0))
+    {
+        mock_stop();
+        return false;
+    }
+    if(!mock_stop_at_exit)
+        atexit(mock_stop);
+    mock_stop_at_exit = true;
+
+    return true;
+}
+
+// Create a getUpdates text message update JSON object
+static inline std::string mock_update(const uint32_t update_id, const int64_t chat_id,
+    const char* text)
+{
+    char json[256];
+
+    snprintf(json, sizeof(json), "{\"update_id\":%u,\"message\":{\"message_id\":%u,\"date\":1,"
+        "\"chat\":{\"id\":%lld,\"type\":\"private\"},\"text\":\"%s\"}}", update_id, update_id,
+        (long long)chat_id, text);
+    return json;
+}
+
+// Get the number of requests of a method (or accepted connections, "_accept") in the mock log
+static inline unsigned mock_count(const char* method)
+{
+    char pattern[64];
+    char line[8192];
+    unsigned count = 0;
+    FILE* file;
+
+    snprintf(pattern, sizeof(pattern), "{\"method\": \"%s\"", method);
+    file = fopen(MOCK_LOG, "r");
+    if(file == NULL)
+        return 0;
+    while(fgets(line, sizeof(line), file) != NULL)
+    {
+        if(strncmp(line, pattern, strlen(pattern)) == 0)
+            count = count + 1;
+    }
+    fclose(file);
+
+    return count;
+}
+
+// Get the number of requests of a method which body contains a text in the mock log (the body is
+// a JSON string in the log, so any quote of the text must be escaped)
+static inline unsigned mock_count_body(const char* method, const char* text)
+{
+    char pattern[64];
+    char line[8192];
+    unsigned count = 0;
+    FILE* file;
+
+    snprintf(pattern, sizeof(pattern), "{\"method\": \"%s\"", method);
+    file = fopen(MOCK_LOG, "r");
+    if(file == NULL)
+        return 0;
+    while(fgets(line, sizeof(line), file) != NULL)
+    {
+        if((strncmp(line, pattern, strlen(pattern)) == 0) && (strstr(line, text) != NULL))
+            count = count + 1;
+    }
+    fclose(file);
+
+    return count;
+}
+
+/**************************************************************************************************/
+
+#endif
@@ -0,0 +1,181 @@
+/**************************************************************************************************/
+// Project: uTLGBotLib
+// File: test_dispatcher.cpp
+// Description: Updates dispatcher tests (a new update is dispatched at once while a handler is
+//              busy, stopping requests again the updates from the oldest pending one, and a
+//              stuck chat doesn't stop the other ones nor makes the poller request in a loop).
+// Created on: 19 oct. 2026
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <atomic>
+#include <thread>
+#include "utlgbotlib.h"
+#include "test.h"
+
+/**************************************************************************************************/
+
+/* Constants */
+
+#define CHAT_A 1001
+#define CHAT_B 2002
+#define LATE_UPDATE_MS 300
+#define MAX_LATENCY_MS 500
+#define TEST_TIMEOUT_MS 5000
+#define NUM_FLOWING_MSGS 40
+#define FLOWING_TEXT_LENGTH 100
+#define STUCK_MS 3000
+
+/**************************************************************************************************/
+
+/* Handler */
+
+static std::atomic<bool> release_stuck(false);
+static std::atomic<unsigned long> late_handled_t(0);
+static std::atomic<uint32_t> num_handled(0);
+static std::atomic<uint32_t> num_flowing(0);
+static std::atomic<uint32_t> flowing_in_order(0);
+
+// Messages handler ("stuck" message blocks until it is released, and flowing messages texts are
+// "f" and their number)
+static void handle_msg(const tlg_msg_record& record, const uint8_t worker, void* arg)
+{
+    const char* text = uTLGBotMsgQueue::get_str(&record, TLG_MSG_RECORD_TEXT);
+
+    (void)worker;
+    (void)arg;
+    if(strcmp(text, "stuck") == 0)
+    {
+        while(!release_stuck)
+            usleep(1000);
+    }
+    else if(strcmp(text, "late") == 0)
+        late_handled_t = test_millis();
+    else if(text[0] == 'f')
+    {
+        if(atoi(text + 1) == (int)num_flowing)
+            flowing_in_order.fetch_add(1);
+        num_flowing.fetch_add(1);
+    }
+    num_handled.fetch_add(1);
+}
+
+/**************************************************************************************************/
+
+/* Tests */
+
+// A message of other chat received while the handler of the oldest one is busy is dispatched at
+// once (once it is requested again, as the poller waits a while between requests that just get
+// the pending updates), and stopping the dispatcher requests again from the oldest pending update (a completed
+// one after it is received again too, at-least-once delivery)
+static void test_busy_handler(void)
+{
+    static uint64_t memory[8192];
+    uTLGBot bot("123:ABC");
+    uTLGBotDispatcher dispatcher(bot, memory, sizeof(memory), handle_msg, NULL, 2);
+    std::string config;
+    unsigned long t0;
+
+    printf("test_busy_handler\n");
+
+    // Chat A oldest message blocks its handler (its next message waits for it), and a message of
+    // chat B arrives later
+    config = "{\"updates\":[" + mock_update(1, CHAT_A, "stuck") + "," +
+        mock_update(2, CHAT_A, "queued") + "],\"late_updates\":[{\"after_ms\":" +
+        std::to_string(LATE_UPDATE_MS) + ",\"update\":" + mock_update(3, CHAT_B, "late") + "}]}";
+    CHECK(mock_start(config.c_str()));
+    t0 = test_millis();
+
+    CHECK(dispatcher.start());
+    while((late_handled_t == 0) && (test_millis() - t0 < TEST_TIMEOUT_MS))
+        dispatcher.poll();
+    CHECK(late_handled_t != 0);
+    CHECK(late_handled_t - t0 < LATE_UPDATE_MS + DISPATCHER_REPOLL_MS + MAX_LATENCY_MS);
+    CHECK(dispatcher.get_num_pending() == 3);
+    CHECK(dispatcher.get_commit_offset() == 1);
+
+    // Stop while chat A is busy (its queued message is not handled)
+    std::thread release_thread([]()
+    {
+        usleep(200000);
+        release_stuck = true;
+    });
+    dispatcher.stop();
+    release_thread.join();
+    CHECK(num_handled == 2);
+
+    // The bot receives again from the queued message (the completed late one after it too)
+    CHECK(bot.getUpdates() == TLG_UPDATE_MESSAGE);
+    CHECK(strcmp(bot.get_msg_text(), "queued") == 0);
+    CHECK(bot.getUpdates() == TLG_UPDATE_MESSAGE);
+    CHECK(strcmp(bot.get_msg_text(), "late") == 0);
+    mock_stop();
+}
+
+// While a chat is stuck, the messages of other chat keep being handled up to the ones that fit in
+// the response buffer with the pending ones (without requesting the updates in a loop), and the
+// rest of them are handled once it is released
+static void test_stuck_chat(void)
+{
+    static uint64_t memory[8192];
+    uTLGBot bot("123:ABC");
+    uTLGBotDispatcher dispatcher(bot, memory, sizeof(memory), handle_msg, NULL, 2);
+    std::atomic<uint32_t> stuck_flowing(0);
+    std::atomic<uint32_t> stuck_requests(0);
+    char text[FLOWING_TEXT_LENGTH + 1];
+    std::string config;
+    unsigned long t0;
+
+    printf("test_stuck_chat\n");
+
+    // Chat A oldest message blocks its handler, and many big messages of chat B arrive after it
+    config = "{\"updates\":[" + mock_update(1, CHAT_A, "stuck");
+    memset(text, 'x', FLOWING_TEXT_LENGTH);
+    text[FLOWING_TEXT_LENGTH] = '\0';
+    for(uint32_t i = 0; i < NUM_FLOWING_MSGS; i++)
+    {
+        text[0] = 'f';
+        text[1] = (char)('0' + (i / 10));
+        text[2] = (char)('0' + (i % 10));
+        config = config + "," + mock_update(i + 2, CHAT_B, text);
+    }
+    config = config + "]}";
+    CHECK(mock_start(config.c_str()));
+    release_stuck = false;
+
+    // Release chat A after a while (the poller may be waiting for it)
+    std::thread release_thread([&]()
+    {
+        usleep(STUCK_MS * 1000);
+        stuck_flowing = num_flowing.load();
+        stuck_requests = mock_count("getUpdates");
+        release_stuck = true;
+    });
+    CHECK(dispatcher.start());
+    t0 = test_millis();
+    while((num_flowing < NUM_FLOWING_MSGS) && (test_millis() - t0 < STUCK_MS + TEST_TIMEOUT_MS))
+        dispatcher.poll();
+    release_thread.join();
+
+    // Chat B got the messages that fit in the window while chat A was stuck, with a request for
+    // each one (and the one that didn't fit, at most), and all of them in order at the end
+    CHECK(stuck_flowing >= 10);
+    CHECK(stuck_requests <= stuck_flowing + 2);
+    CHECK(num_flowing == NUM_FLOWING_MSGS);
+    CHECK(flowing_in_order == NUM_FLOWING_MSGS);
+    dispatcher.stop();
+    CHECK(dispatcher.get_commit_offset() == NUM_FLOWING_MSGS + 2);
+    mock_stop();
+}
+
+/**************************************************************************************************/
+
+/* Main Function */
+
+int main(void)
+{
+    test_busy_handler();
+    test_stuck_chat();
+    return test_result("test_dispatcher");
+}
@@ -0,0 +1,212 @@
+/**************************************************************************************************/
+// Project: uTLGBotLib
+// File: test_fanout.cpp
+// Description: Updates fan-out tests (a worker that never acknowledges its record doesn't stop
+//              the messages of the other chats, even if they don't fit in the response buffer
+//              with the pending ones, and closing requests again the pending ones).
+// Created on: 19 oct. 2026
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <atomic>
+#include <thread>
+#include "utlgbotlib.h"
+#include "test.h"
+
+/**************************************************************************************************/
+
+/* Constants */
+
+#define NUM_WORKERS 2
+#define NUM_FLOWING_MSGS 24
+#define TEST_TIMEOUT_MS 15000
+#define NUM_BIG_MSGS 40
+#define BIG_TEXT_LENGTH 100
+#define SLOW_MS 3000
+
+/**************************************************************************************************/
+
+/* Functions */
+
+// Get the fan-out worker of a chat (same hash as uTLGBotFanout::publish())
+static uint32_t chat_worker(const int64_t chat_id)
+{
+    return (uint32_t)((((uint64_t)chat_id * 0x9E3779B97F4A7C15ULL) >> 32) % NUM_WORKERS);
+}
+
+// Get a chat ID handled by the given worker
+static int64_t worker_chat(const uint32_t worker, int64_t from)
+{
+    while(chat_worker(from) != worker)
+        from = from + 1;
+    return from;
+}
+
+/**************************************************************************************************/
+
+/* Tests */
+
+// A stuck worker holds its record, while the messages of the chats of the other worker keep
+// flowing (updates are requested again from the stuck one, up to the fan-out window or the ones
+// that fit in the response buffer)
+static void test_stuck_worker(void)
+{
+    uTLGBot bot("123:ABC");
+    uTLGBotFanout poller;
+    uTLGBotFanout worker;
+    int64_t stuck_chat = worker_chat(0, 1000);
+    int64_t chats[4];
+    std::atomic<uint32_t> received(0);
+    uint32_t in_order = 0;
+    std::string config;
+    char text[16];
+
+    printf("test_stuck_worker\n");
+
+    // First update goes to the stuck worker, then many updates to chats of the other one
+    chats[0] = worker_chat(1, 2000);
+    for(uint32_t i = 1; i < 4; i++)
+        chats[i] = worker_chat(1, chats[i-1] + 1);
+    config = "{\"updates\":[" + mock_update(1, stuck_chat, "stuck");
+    for(uint32_t i = 0; i < NUM_FLOWING_MSGS; i++)
+    {
+        snprintf(text, sizeof(text), "%u", i);
+        config = config + "," + mock_update(i + 2, chats[i % 4], text);
+    }
+    config = config + "]}";
+    CHECK(mock_start(config.c_str()));
+
+    // Poll the updates while worker 1 acknowledges its records (worker 0 is not attached)
+    CHECK(poller.create(bot, NULL, NUM_WORKERS, 8));
+    CHECK(worker.attach(poller.get_fd(), 1));
+    std::thread worker_thread([&]()
+    {
+        const tlg_msg_record* record;
+        unsigned long t0 = test_millis();
+
+        while((received < NUM_FLOWING_MSGS) && (test_millis() - t0 < TEST_TIMEOUT_MS))
+        {
+            record = worker.receive(100);
+            if(record == NULL)
+                continue;
+            if(atoi(uTLGBotMsgQueue::get_str(record, TLG_MSG_RECORD_TEXT)) == (int)received)
+                in_order = in_order + 1;
+            received.fetch_add(1);
+            worker.ack();
+        }
+    });
+    unsigned long t0 = test_millis();
+    while((received < NUM_FLOWING_MSGS) && (test_millis() - t0 < TEST_TIMEOUT_MS))
+        poller.poll();
+    worker_thread.join();
+
+    CHECK(received == NUM_FLOWING_MSGS);
+    CHECK(in_order == NUM_FLOWING_MSGS);
+    CHECK(poller.get_num_pending() == 1);
+    CHECK(poller.get_commit_offset() == 1);
+
+    // Closing requests again from the stuck update (the acknowledged ones after it too)
+    worker.close();
+    poller.close();
+    CHECK(bot.getUpdates() == TLG_UPDATE_MESSAGE);
+    CHECK(bot.get_msg_chat_id() == stuck_chat);
+    CHECK(strcmp(bot.get_msg_text(), "stuck") == 0);
+    CHECK(bot.getUpdates() == TLG_UPDATE_MESSAGE);
+    CHECK(strcmp(bot.get_msg_text(), "0") == 0);
+    mock_stop();
+}
+
+// While a worker is slow to acknowledge its record, the other worker keeps getting big messages up
+// to the ones that fit in the response buffer with the pending ones (without requesting them in a
+// loop), and the rest of them once the slow one is acknowledged
+static void test_slow_worker(void)
+{
+    uTLGBot bot("123:ABC");
+    uTLGBotFanout poller;
+    uTLGBotFanout slow_worker;
+    uTLGBotFanout worker;
+    int64_t slow_chat = worker_chat(0, 1000);
+    int64_t chat = worker_chat(1, 2000);
+    std::atomic<uint32_t> received(0);
+    std::atomic<uint32_t> slow_received(0);
+    std::atomic<uint32_t> slow_requests(0);
+    std::atomic<bool> slow_acked(false);
+    uint32_t in_order = 0;
+    char text[BIG_TEXT_LENGTH + 1];
+    std::string config;
+    unsigned long t0;
+
+    printf("test_slow_worker\n");
+
+    // First update goes to the slow worker, then many big updates to a chat of the other one
+    config = "{\"updates\":[" + mock_update(1, slow_chat, "slow");
+    memset(text, 'x', BIG_TEXT_LENGTH);
+    text[BIG_TEXT_LENGTH] = '\0';
+    for(uint32_t i = 0; i < NUM_BIG_MSGS; i++)
+    {
+        snprintf(text, 4, "%03u", i);
+        text[3] = 'x';
+        config = config + "," + mock_update(i + 2, chat, text);
+    }
+    config = config + "]}";
+    CHECK(mock_start(config.c_str()));
+
+    // Poll the updates while worker 1 acknowledges its records, and worker 0 acknowledges its
+    // record after a while (the poller may be waiting for it)
+    CHECK(poller.create(bot, NULL, NUM_WORKERS, 8));
+    CHECK(slow_worker.attach(poller.get_fd(), 0));
+    CHECK(worker.attach(poller.get_fd(), 1));
+    std::thread slow_thread([&]()
+    {
+        usleep(SLOW_MS * 1000);
+        slow_received = received.load();
+        slow_requests = mock_count("getUpdates");
+        slow_acked = ((slow_worker.receive(0) != NULL) && slow_worker.ack());
+    });
+    std::thread worker_thread([&]()
+    {
+        const tlg_msg_record* record;
+        unsigned long t0 = test_millis();
+
+        while((received < NUM_BIG_MSGS) && (test_millis() - t0 < SLOW_MS + TEST_TIMEOUT_MS))
+        {
+            record = worker.receive(100);
+            if(record == NULL)
+                continue;
+            if(atoi(uTLGBotMsgQueue::get_str(record, TLG_MSG_RECORD_TEXT)) == (int)received)
+                in_order = in_order + 1;
+            received.fetch_add(1);
+            worker.ack();
+        }
+    });
+    t0 = test_millis();
+    while((received < NUM_BIG_MSGS) && (test_millis() - t0 < SLOW_MS + TEST_TIMEOUT_MS))
+        poller.poll();
+    slow_thread.join();
+    worker_thread.join();
+
+    // Worker 1 got the messages that fit in the window while worker 0 was slow, with a request
+    // for each one (and the one that didn't fit, at most), and all of them in order at the end
+    CHECK(slow_acked);
+    CHECK(slow_received >= 10);
+    CHECK(slow_received < NUM_BIG_MSGS);
+    CHECK(slow_requests <= slow_received + 2);
+    CHECK(received == NUM_BIG_MSGS);
+    CHECK(in_order == NUM_BIG_MSGS);
+    worker.close();
+    slow_worker.close();
+    poller.close();
+    mock_stop();
+}
+
+/**************************************************************************************************/
+
+/* Main Function */
+
+int main(void)
+{
+    test_stuck_worker();
+    test_slow_worker();
+    return test_result("test_fanout");
+}
@@ -0,0 +1,580 @@
+/**************************************************************************************************/
+// Project: uTLGBotLib
+// File: test_json.cpp
+// Description: JSON kernels tests (each one checked against a plain reference, with the SIMD
+//              blocks and the scalar tail, and in the no SIMD build).
+// Created on: 19 oct. 2026
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include "unit.h"
+#include "test.h"
+
+/**************************************************************************************************/
+
+/* Constants */
+
+// Strings up to this length have SIMD blocks and a scalar tail of any length (AVX2 is 32 bytes)
+#define MAX_TEST_LEN 100
+
+// Maximum number of tokens of the tokenized JSON
+#define MAX_TOKENS 256
+
+// Bytes written after the destination size to check that they are not modified
+#define GUARD_LEN 64
+#define GUARD_BYTE '#'
+
+/**************************************************************************************************/
+
+/* Reference Implementations */
+
+// Escape a string byte by byte
+static std::string ref_escape(const char* src, const size_t src_len)
+{
+    static const char hex[] = "0123456789abcdef";
+    std::string dest;
+
+    for(size_t i = 0; i < src_len; i++)
+    {
+        char c = src[i];
+        switch(c)
+        {
+            case '"':  dest += "\\\""; break;
+            case '\\': dest += "\\\\"; break;
+            case '\b': dest += "\\b";  break;
+            case '\f': dest += "\\f";  break;
+            case '\n': dest += "\\n";  break;
+            case '\r': dest += "\\r";  break;
+            case '\t': dest += "\\t";  break;
+            default:
+                if((uint8_t)c < 0x20)
+                {
+                    dest += "\\u00";
+                    dest += hex[(uint8_t)c >> 4];
+                    dest += hex[(uint8_t)c & 0x0F];
+                }
+                else
+                    dest += c;
+                break;
+        }
+    }
+    return dest;
+}
+
+/**************************************************************************************************/
+
+/* Tests */
+
+// Check the escape of a string against the reference (and that the destination size is kept)
+static bool check_escape(const char* src, const size_t src_len)
+{
+    std::string expected = ref_escape(src, src_len);
+    char dest[(MAX_TEST_LEN * 6) + 1 + GUARD_LEN];
+    int32_t len;
+
+    memset(dest, GUARD_BYTE, sizeof(dest));
+    len = uTLGBotTests::json_escape_str(src, src_len, dest, expected.size() + 1);
+    if((len != (int32_t)expected.size()) || (memcmp(dest, expected.c_str(), len + 1) != 0))
+        return false;
+    for(size_t i = expected.size() + 1; i < sizeof(dest); i++)
+    {
+        if(dest[i] != GUARD_BYTE)
+            return false;
+    }
+    return true;
+}
+
+// Each byte that needs escape, at any position of strings of any length (so in any SIMD block
+// lane and in the scalar tail), is escaped as the reference does
+static void test_escape_positions(void)
+{
+    static const char specials[] = { '"', '\\', '\b', '\f', '\n', '\r', '\t', 0x00, 0x01, 0x1B,
+        0x1F };
+    char src[MAX_TEST_LEN];
+    uint32_t fails = 0;
+
+    printf("test_escape_positions\n");
+    for(size_t len = 0; len <= MAX_TEST_LEN; len++)
+    {
+        memset(src, 'a', sizeof(src));
+        if(!check_escape(src, len))
+            fails = fails + 1;
+        for(size_t pos = 0; pos < len; pos++)
+        {
+            for(size_t i = 0; i < sizeof(specials); i++)
+            {
+                memset(src, 'a', sizeof(src));
+                src[pos] = specials[i];
+                if(!check_escape(src, len))
+                    fails = fails + 1;
+            }
+        }
+    }
+    CHECK(fails == 0);
+}
+
+// Every byte value is escaped as the reference does (bytes next to the escaped ranges, like
+// space, 0x7F and UTF-8 bytes, are copied as they are), alone and in runs
+static void test_escape_bytes(void)
+{
+    char src[MAX_TEST_LEN];
+    uint32_t fails = 0;
+
+    printf("test_escape_bytes\n");
+    for(uint32_t c = 0; c < 256; c++)
+    {
+        memset(src, (char)c, sizeof(src));
+        if(!check_escape(src, 1) || !check_escape(src, sizeof(src)))
+            fails = fails + 1;
+    }
+    for(uint32_t c = 0; c < sizeof(src); c++)
+        src[c] = (char)(c * 7);
+    if(!check_escape(src, sizeof(src)))
+        fails = fails + 1;
+    CHECK(fails == 0);
+}
+
+// A destination smaller than the escaped string is rejected without writing after its size
+static void test_escape_dest_size(void)
+{
+    const char* src = "Line \"one\"\n\tLine two with a longer run of clean text \\ and \x01 end";
+    std::string expected = ref_escape(src, strlen(src));
+    char dest[256 + GUARD_LEN];
+    bool guard_kept = true;
+    bool rejected = true;
+
+    printf("test_escape_dest_size\n");
+    for(size_t size = 0; size <= expected.size(); size++)
+    {
+        memset(dest, GUARD_BYTE, sizeof(dest));
+        if(uTLGBotTests::json_escape_str(src, strlen(src), dest, size) != -1)
+            rejected = false;
+        for(size_t i = size; i < sizeof(dest); i++)
+        {
+            if(dest[i] != GUARD_BYTE)
+                guard_kept = false;
+        }
+    }
+    CHECK(rejected);
+    CHECK(guard_kept);
+    CHECK(check_escape(src, strlen(src)));
+}
+
+// Each known key is identified by the perfect hash table, and keys that share its hash inputs
+// (length, first and two last characters) or are a prefix of it are unknown
+static void test_key_ids(void)
+{
+    uTLGBot bot("123:ABC");
+    jsmntok_t token;
+    char key[64];
+    uint32_t fails = 0;
+
+    printf("test_key_ids\n");
+    token.type = JSMN_STRING;
+    token.start = 0;
+    for(uint8_t id = 0; id < TLG_NUM_KEYS; id++)
+    {
+        size_t len = strlen(tlg_keys[id]);
+
+        memcpy(key, tlg_keys[id], len + 1);
+        token.end = (int)len;
+        if(uTLGBotTests::json_get_key_id(bot, key, &token) != id)
+            fails = fails + 1;
+
+        // Same hash inputs, other key
+        if(len > 3)
+        {
+            key[1] = (key[1] == 'x') ? 'y' : 'x';
+            if(uTLGBotTests::json_get_key_id(bot, key, &token) != TLG_KEY_UNKNOWN)
+                fails = fails + 1;
+        }
+
+        // Prefix of the key
+        memcpy(key, tlg_keys[id], len + 1);
+        token.end = (int)len - 1;
+        if(uTLGBotTests::json_get_key_id(bot, key, &token) == id)
+            fails = fails + 1;
+    }
+    CHECK(fails == 0);
+}
+
+// Get the length of the UTF-8 character that starts with the given byte
+static uint32_t utf8_char_len(const char c)
+{
+    if(((uint8_t)c & 0x80) == 0x00)
+        return 1;
+    if(((uint8_t)c & 0xE0) == 0xC0)
+        return 2;
+    if(((uint8_t)c & 0xF0) == 0xE0)
+        return 3;
+    return 4;
+}
+
+// Check the unescape of a JSON string value, out of place and in place
+static bool check_unescape(const char* src, const char* expected)
+{
+    char dest[512];
+    char in_place[512];
+    uint32_t len;
+
+    len = uTLGBotTests::json_unescape_str(src, strlen(src), dest, sizeof(dest));
+    if((len != strlen(expected)) || (strcmp(dest, expected) != 0))
+    {
+        printf("  json_unescape_str \"%s\": \"%s\"\n", src, dest);
+        return false;
+    }
+    strcpy(in_place, src);
+    len = uTLGBotTests::json_unescape_str(in_place, strlen(in_place), in_place,
+        sizeof(in_place));
+    return ((len == strlen(expected)) && (strcmp(in_place, expected) == 0));
+}
+
+// Simple escapes and "\uXXXX" escapes are converted to UTF-8 (1 to 3 bytes characters, and 4
+// bytes ones from surrogate pairs), and runs without escapes longer than a block are kept
+static void test_unescape(void)
+{
+    std::string run(150, 'r');
+    uint32_t fails = 0;
+
+    printf("test_unescape\n");
+    if(!check_unescape("", "") ||
+        !check_unescape("plain text", "plain text") ||
+        !check_unescape("a\\nb\\tc\\\"d\\\\e\\/f\\bg\\fh\\ri", "a\nb\tc\"d\\e/f\bg\fh\ri") ||
+        !check_unescape("\\u0041\\u00e9\\u20AC", "A\xc3\xa9\xe2\x82\xac") ||
+        !check_unescape("\\ud83d\\ude00!", "\xf0\x9f\x98\x80!") ||
+        !check_unescape("\\uD83D\\uDE00\\udbff\\udfff", "\xf0\x9f\x98\x80\xf4\x8f\xbf\xbf") ||
+        !check_unescape("\xd0\xbf\xd1\x80\xd0\xb8 \\u00e9", "\xd0\xbf\xd1\x80\xd0\xb8 \xc3\xa9") ||
+        !check_unescape((run + "\\n" + run).c_str(), (run + "\n" + run).c_str()))
+    {
+        fails = fails + 1;
+    }
+    CHECK(fails == 0);
+}
+
+// Lone surrogates (high one at the end, not followed by an escape or followed by other than a
+// low one, and low one alone) are replaced by U+FFFD, and invalid escapes are kept as the char
+static void test_unescape_invalid(void)
+{
+    uint32_t fails = 0;
+
+    printf("test_unescape_invalid\n");
+    if(!check_unescape("\\ud83d", "\xef\xbf\xbd") ||
+        !check_unescape("\\ud83dx", "\xef\xbf\xbdx") ||
+        !check_unescape("\\ud83d\\u0041", "\xef\xbf\xbd" "A") ||
+        !check_unescape("\\ud83d\\ud83d\\ude00", "\xef\xbf\xbd\xf0\x9f\x98\x80") ||
+        !check_unescape("\\ude00\\ud83d", "\xef\xbf\xbd\xef\xbf\xbd") ||
+        !check_unescape("\\ud83d\\ude0", "\xef\xbf\xbdude0") ||
+        !check_unescape("\\u12G4", "u12G4") ||
+        !check_unescape("\\u12", "u12") ||
+        !check_unescape("\\q", "q") ||
+        !check_unescape("end\\", "end"))
+    {
+        fails = fails + 1;
+    }
+    CHECK(fails == 0);
+}
+
+// A destination smaller than the unescaped string gets the longest prefix of whole characters
+// that fits (UTF-8 characters from the source runs and from escapes are not split)
+static void test_unescape_truncate(void)
+{
+    static const char src[] = "ab\\u00e9\\ud83d\\ude00 \xd0\xbf\xd1\x80\xf0\x9f\x98\x80\\n"
+        "\\u20ac\xe2\x82\xac!";
+    char full[128];
+    char dest[128 + GUARD_LEN];
+    uint32_t full_len, len;
+    uint32_t fails = 0;
+
+    printf("test_unescape_truncate\n");
+    full_len = uTLGBotTests::json_unescape_str(src, strlen(src), full, sizeof(full));
+    for(size_t size = 1; size <= full_len + 1; size++)
+    {
+        memset(dest, GUARD_BYTE, sizeof(dest));
+        len = uTLGBotTests::json_unescape_str(src, strlen(src), dest, size);
+
+        // Prefix of whole characters, and the next character doesn't fit
+        if((len >= size) || (dest[len] != '\0') || (memcmp(dest, full, len) != 0) ||
+            ((len < full_len) && (len + utf8_char_len(full[len]) < size)) ||
+            (dest[size] != GUARD_BYTE))
+        {
+            printf("  json_unescape_str truncated to %u bytes (size %u)\n", len, (unsigned)size);
+            fails = fails + 1;
+        }
+    }
+    CHECK(full_len == strlen("ab\xc3\xa9\xf0\x9f\x98\x80 \xd0\xbf\xd1\x80\xf0\x9f\x98\x80\n"
+        "\xe2\x82\xac\xe2\x82\xac!"));
+    CHECK(fails == 0);
+}
+
+// Check the conversion of a decimal string against strtoll() (invalid strings must be rejected
+// without modifying the value)
+static bool check_to_int64(const char* str, const bool valid)
+{
+    int64_t value = 12345;
+    bool rc;
+
+    rc = uTLGBotTests::cstr_to_int64(str, strlen(str), &value);
+    if(rc != valid)
+    {
+        printf("  cstr_to_int64 %s: \"%s\"\n", rc ? "accepts" : "rejects", str);
+        return false;
+    }
+    if(valid)
+        return (value == strtoll(str, NULL, 10));
+    return (value == 12345);
+}
+
+// Integers of any number of digits (below, at and above the 8 digits blocks), and the int64
+// limits, are converted as strtoll() does
+static void test_to_int64_digits(void)
+{
+    static const char* limits[] = { "9223372036854775807", "-9223372036854775808",
+        "0000000000000000001", "-0", "00000000", "0000000000000000" };
+    static const char* out_of_range[] = { "9223372036854775808", "-9223372036854775809",
+        "9999999999999999999", "-9999999999999999999", "10000000000000000000" };
+    char str[32];
+    uint32_t fails = 0;
+
+    printf("test_to_int64_digits\n");
+    for(uint32_t len = 1; len <= 19; len++)
+    {
+        // Each digit at each position (1-9 cycled, and all 9s), positive and negative
+        for(uint32_t i = 0; i < len; i++)
+            str[i] = (char)('1' + ((i + len) % 9));
+        str[len] = '\0';
+        if(!check_to_int64(str, true))
+            fails = fails + 1;
+        memset(str, '9', len);
+        if((len < 19) && !check_to_int64(str, true))
+            fails = fails + 1;
+        str[0] = '-';
+        for(uint32_t i = 0; i < len; i++)
+            str[i+1] = (char)('0' + ((i * 7) % 10));
+        str[len+1] = '\0';
+        if(!check_to_int64(str, true))
+            fails = fails + 1;
+    }
+    for(uint32_t i = 0; i < sizeof(limits)/sizeof(limits[0]); i++)
+    {
+        if(!check_to_int64(limits[i], true))
+            fails = fails + 1;
+    }
+    for(uint32_t i = 0; i < sizeof(out_of_range)/sizeof(out_of_range[0]); i++)
+    {
+        if(!check_to_int64(out_of_range[i], false))
+            fails = fails + 1;
+    }
+    CHECK(fails == 0);
+}
+
+// Non digit bytes (the ones next to '0'-'9', and others that could pass a wrong block check) are
+// rejected at any position of 8, 16 and 19 digits integers, and in empty or sign only strings
+static void test_to_int64_non_digits(void)
+{
+    static const char non_digits[] = { '/', ':', ' ', '+', '-', '.', 'a', 'A', 0x0A, 0x3F, 0x70,
+        (char)0x80, (char)0xB0, (char)0xB9, (char)0xF9, (char)0xFA, (char)0xFF };
+    static const uint32_t lens[] = { 8, 16, 19 };
+    char str[32];
+    uint32_t fails = 0;
+
+    printf("test_to_int64_non_digits\n");
+    for(uint32_t l = 0; l < sizeof(lens)/sizeof(lens[0]); l++)
+    {
+        for(uint32_t pos = 0; pos < lens[l]; pos++)
+        {
+            for(uint32_t i = 0; i < sizeof(non_digits); i++)
+            {
+                memset(str, '1', lens[l]);
+                str[lens[l]] = '\0';
+                str[pos] = non_digits[i];
+                if((pos == 0) && (non_digits[i] == '-'))
+                    continue;
+                if(!check_to_int64(str, false))
+                    fails = fails + 1;
+            }
+        }
+    }
+    if(!check_to_int64("", false) || !check_to_int64("-", false) ||
+        !check_to_int64("--1", false) || !check_to_int64("+1", false))
+    {
+        fails = fails + 1;
+    }
+    CHECK(fails == 0);
+}
+
+// Integers are written as snprintf() does and converted back to the same value
+static void test_from_int64(void)
+{
+    int64_t values[64];
+    uint32_t num_values = 0;
+    char expected[32];
+    char str[32];
+    int64_t value;
+    uint32_t fails = 0;
+    uint32_t len;
+
+    printf("test_from_int64\n");
+    values[num_values++] = 0;
+    values[num_values++] = INT64_MAX;
+    values[num_values++] = INT64_MIN;
+    values[num_values++] = INT64_MIN + 1;
+    for(int64_t pow10 = 1; pow10 <= INT64_MAX / 10; pow10 = pow10 * 10)
+    {
+        values[num_values++] = pow10 * 10 - 1;
+        values[num_values++] = -pow10;
+    }
+    for(uint32_t i = 0; i < num_values; i++)
+    {
+        snprintf(expected, sizeof(expected), "%lld", (long long)values[i]);
+        len = uTLGBotTests::cstr_from_int64(values[i], str);
+        if((len != strlen(expected)) || (strcmp(str, expected) != 0) ||
+            !uTLGBotTests::cstr_to_int64(str, len, &value) || (value != values[i]))
+        {
+            printf("  cstr_from_int64 %s: \"%s\"\n", expected, str);
+            fails = fails + 1;
+        }
+    }
+    CHECK(fails == 0);
+}
+
+#if defined(UTLGBOT_SIMD_WIDTH)
+
+// Check that the SIMD tokenizer gets the same result and tokens than jsmn, with the JSON at any
+// position of the 64 bytes blocks (shifted by leading whitespaces) and with fewer tokens than
+// needed
+static bool check_simd_parse(const char* json)
+{
+    static jsmntok_t jsmn_tokens[MAX_TOKENS];
+    static jsmntok_t simd_tokens[MAX_TOKENS];
+    jsmn_parser parser;
+    std::string shifted;
+    int jsmn_rc, simd_rc;
+
+    for(uint32_t shift = 0; shift <= 64; shift++)
+    {
+        shifted = std::string(shift, ' ') + json;
+        jsmn_init(&parser);
+        jsmn_rc = jsmn_parse(&parser, shifted.c_str(), shifted.size(), jsmn_tokens, MAX_TOKENS);
+        simd_rc = json_simd_parse(shifted.c_str(), shifted.size(), simd_tokens, MAX_TOKENS);
+        if(jsmn_rc != simd_rc)
+        {
+            printf("  json_simd_parse %d, jsmn %d (shift %u): %s\n", simd_rc, jsmn_rc, shift,
+                json);
+            return false;
+        }
+        for(int i = 0; i < jsmn_rc; i++)
+        {
+            if((jsmn_tokens[i].type != simd_tokens[i].type) ||
+                (jsmn_tokens[i].start != simd_tokens[i].start) ||
+                (jsmn_tokens[i].end != simd_tokens[i].end) ||
+                (jsmn_tokens[i].size != simd_tokens[i].size))
+            {
+                printf("  json_simd_parse token %d differs (shift %u): %s\n", i, shift, json);
+                return false;
+            }
+        }
+    }
+    jsmn_init(&parser);
+    jsmn_rc = jsmn_parse(&parser, json, strlen(json), jsmn_tokens, MAX_TOKENS);
+    for(int num_tokens = 1; num_tokens < jsmn_rc; num_tokens++)
+    {
+        if(json_simd_parse(json, strlen(json), simd_tokens, num_tokens) != JSMN_ERROR_NOMEM)
+        {
+            printf("  json_simd_parse with %d tokens not rejected: %s\n", num_tokens, json);
+            return false;
+        }
+    }
+    return true;
+}
+
+// The SIMD tokenizer gets the same tokens than jsmn for valid JSON (getUpdates responses,
+// escaped quotes and backslashes, primitives, whitespaces, UTF-8, strings longer than a block
+// and nesting deeper than its stack, that is tokenized by jsmn)
+static void test_simd_parse(void)
+{
+    static const char* jsons[] =
+    {
+        "{}",
+        "[]",
+        "[true]",
+        "{\"ok\":true,\"result\":[]}",
+        "{\"ok\":true,\"result\":[{\"update_id\":784512390,\"message\":{\"message_id\":5531,"
+        "\"from\":{\"id\":611234567,\"is_bot\":false,\"first_name\":\"Alice\"},\"chat\":{"
+        "\"id\":-1001234567890,\"title\":\"Ops\",\"type\":\"supergroup\"},\"date\":1760870400,"
+        "\"text\":\"/status web-01\",\"entities\":[{\"offset\":0,\"length\":7,"
+        "\"type\":\"bot_command\"}]}},{\"update_id\":784512391,\"callback_query\":{"
+        "\"id\":\"4382bfdwdsb323b2d9\",\"data\":\"page:2\"}}]}",
+        "{\"text\":\"say \\\"hi\\\" \\\\ C:\\\\bot\\\\\",\"q\":\"\\\"\",\"b\":\"\\\\\",\"m\":"
+        "\"a\\\\\\\"b\\\\\\\\\\\"c\"}",
+        "{\"a\":-12.5e3,\"b\":true,\"c\":null,\"d\":[1,2,[3,false]],\"e\":{},\"f\":0}",
+        "{ \"a\" :\t1 ,\r\n \"b\" : [ ] ,\n\"c\":\"x y\"\t}",
+        "{\"t\":\"\\u00e9 \\ud83d\\ude00 \xd0\xbf\xd1\x80\xd0\xb8 {[,:]}\"}",
+        "{\"long\":\"0123456789012345678901234567890123456789012345678901234567890\\\\\\\"x"
+        "0123456789012345678901234567890123456789012345678901234567890\\\\\",\"n\":1}",
+        "[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[1]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]",
+        "[1,2,3]",
+    };
+    uint32_t fails = 0;
+
+    printf("test_simd_parse\n");
+    for(uint32_t i = 0; i < sizeof(jsons)/sizeof(jsons[0]); i++)
+    {
+        if(!check_simd_parse(jsons[i]))
+            fails = fails + 1;
+    }
+    CHECK(fails == 0);
+}
+
+// Unbalanced or mismatched containers are rejected as jsmn does
+static void test_simd_parse_invalid(void)
+{
+    static const char* jsons[] = { "}", "]", "{]", "[}", "{\"a\":[1}", "{\"a\":1}}" };
+    static jsmntok_t tokens[MAX_TOKENS];
+    jsmn_parser parser;
+    uint32_t fails = 0;
+
+    printf("test_simd_parse_invalid\n");
+    for(uint32_t i = 0; i < sizeof(jsons)/sizeof(jsons[0]); i++)
+    {
+        jsmn_init(&parser);
+        if(jsmn_parse(&parser, jsons[i], strlen(jsons[i]), tokens, MAX_TOKENS) >= 0)
+            continue;
+        if(json_simd_parse(jsons[i], strlen(jsons[i]), tokens, MAX_TOKENS) >= 0)
+        {
+            printf("  json_simd_parse accepts: %s\n", jsons[i]);
+            fails = fails + 1;
+        }
+    }
+    CHECK(fails == 0);
+}
+
+#endif
+
+/**************************************************************************************************/
+
+/* Main Function */
+
+int main(void)
+{
+    test_escape_positions();
+    test_escape_bytes();
+    test_escape_dest_size();
+    test_key_ids();
+    test_unescape();
+    test_unescape_invalid();
+    test_unescape_truncate();
+    test_to_int64_digits();
+    test_to_int64_non_digits();
+    test_from_int64();
+#if defined(UTLGBOT_SIMD_WIDTH)
+    test_simd_parse();
+    test_simd_parse_invalid();
+#endif
+
+#if defined(UTLGBOT_SIMD_WIDTH)
+    return test_result("test_json (SIMD)");
+#else
+    return test_result("test_json (no SIMD)");
+#endif
+}
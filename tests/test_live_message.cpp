@@ -0,0 +1,71 @@
+/**************************************************************************************************/
+// Project: uTLGBotLib
+// File: test_live_message.cpp
+// Description: Live message tests (a "@channelusername" chat ID of the longest username is kept
+//              complete, and a longer one is rejected instead of truncated).
+// Created on: 19 oct. 2026
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include "utlgbotlib.h"
+#include "test.h"
+
+/**************************************************************************************************/
+
+/* Constants */
+
+// Chat ID of a 32 characters username (the longest one) and of a longer one
+#define LONG_CHAT_ID "@abcdefghijklmnopqrstuvwxyz_12345"
+#define TOO_LONG_CHAT_ID "@abcdefghijklmnopqrstuvwxyz_12345_6789"
+
+#define TEXT_BUFFER_SIZE 256
+
+/**************************************************************************************************/
+
+/* Tests */
+
+// The message is sent and edited with the complete chat ID
+static void test_long_chat_id(void)
+{
+    uTLGBot bot("123:ABC");
+    char buffer[TEXT_BUFFER_SIZE];
+    uTLGBotLiveMessage live(bot, LONG_CHAT_ID, buffer, sizeof(buffer), 0);
+
+    printf("test_long_chat_id\n");
+    CHECK(live.update("first"));
+    CHECK(live.get_message_id() != 0);
+    CHECK(live.update("second"));
+    CHECK(!live.is_pending());
+    CHECK(mock_count_body("sendMessage", "\\\"" LONG_CHAT_ID "\\\"") == 1);
+    CHECK(mock_count_body("editMessageText", "\\\"" LONG_CHAT_ID "\\\"") == 1);
+}
+
+// A chat ID longer than any username is not sent truncated (the message is kept pending)
+static void test_too_long_chat_id(void)
+{
+    uTLGBot bot("123:ABC");
+    char buffer[TEXT_BUFFER_SIZE];
+    uTLGBotLiveMessage live(bot, TOO_LONG_CHAT_ID, buffer, sizeof(buffer), 0);
+
+    printf("test_too_long_chat_id\n");
+    CHECK(!live.update("first"));
+    CHECK(live.is_pending());
+    CHECK(live.get_message_id() == 0);
+    CHECK(mock_count("sendMessage") == 0);
+}
+
+/**************************************************************************************************/
+
+/* Main Function */
+
+int main(void)
+{
+    CHECK(mock_start("{}"));
+    test_long_chat_id();
+    CHECK(mock_start("{}"));
+    test_too_long_chat_id();
+    mock_stop();
+
+    return test_result("test_live_message");
+}
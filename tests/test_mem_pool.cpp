@@ -0,0 +1,193 @@
+/**************************************************************************************************/
+// Project: uTLGBotLib
+// File: test_mem_pool.cpp
+// Description: TLS client memory pool tests (requests over a kept connection make no system heap
+//              allocation, and blocks are released to their pool whatever pool is set when they
+//              are freed).
+// Created on: 19 oct. 2026
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include "utlgbotlib.h"
+#include "test.h"
+
+/**************************************************************************************************/
+
+/* Constants */
+
+#define POOL_SIZE (256*1024)
+#define STEADY_REQUESTS 50
+
+/**************************************************************************************************/
+
+/* System Heap Allocations Counter */
+
+// Count the system heap allocations (glibc allocation functions are wrapped)
+extern "C"
+{
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t num, size_t size);
+    void* __libc_realloc(void* ptr, size_t size);
+    void __libc_free(void* ptr);
+}
+
+static volatile unsigned long heap_allocs = 0;
+
+extern "C" void* malloc(size_t size)
+{
+    heap_allocs = heap_allocs + 1;
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t num, size_t size)
+{
+    heap_allocs = heap_allocs + 1;
+    return __libc_calloc(num, size);
+}
+
+extern "C" void* realloc(void* ptr, size_t size)
+{
+    heap_allocs = heap_allocs + 1;
+    return __libc_realloc(ptr, size);
+}
+
+extern "C" void free(void* ptr)
+{
+    __libc_free(ptr);
+}
+
+/**************************************************************************************************/
+
+/* Functions */
+
+// Get the pool statistics
+static multihttpsclient_mem_stats pool_stats(MultiHTTPSClientMemPool& pool)
+{
+    multihttpsclient_mem_stats stats;
+
+    pool.get_stats(&stats);
+    return stats;
+}
+
+/**************************************************************************************************/
+
+/* Tests */
+
+// Once connected, getUpdates and sendMessage requests make no system heap allocation (TLS
+// allocations are from the pool)
+static void test_steady_state(void)
+{
+    static uint64_t memory[POOL_SIZE/sizeof(uint64_t)];
+    MultiHTTPSClientMemPool pool(memory, sizeof(memory));
+    uTLGBot bot("123:ABC");
+    unsigned long allocs;
+    uint32_t sent = 0;
+
+    printf("test_steady_state\n");
+    CHECK(bot.set_tls_mem_pool(&pool));
+
+    // Connect and make the first requests
+    CHECK(bot.sendMessage((int64_t)5, "warm up"));
+    bot.getUpdates();
+    CHECK(pool_stats(pool).allocs > 0);
+    CHECK(pool_stats(pool).fails == 0);
+
+    allocs = heap_allocs;
+    for(uint32_t i = 0; i < STEADY_REQUESTS; i++)
+    {
+        if(bot.sendMessage((int64_t)5, "hello"))
+            sent = sent + 1;
+        bot.getUpdates();
+    }
+    CHECK(sent == STEADY_REQUESTS);
+    CHECK(heap_allocs == allocs);
+    CHECK(mock_count("_accept") == 1);
+}
+
+// Blocks allocated from a pool are released to it after the client is moved to other pool (and
+// after it is moved to the system heap)
+static void test_change_pool(void)
+{
+    static uint64_t memory_a[POOL_SIZE/sizeof(uint64_t)];
+    static uint64_t memory_b[POOL_SIZE/sizeof(uint64_t)];
+    MultiHTTPSClientMemPool pool_a(memory_a, sizeof(memory_a));
+    MultiHTTPSClientMemPool pool_b(memory_b, sizeof(memory_b));
+    uTLGBot bot("123:ABC");
+
+    printf("test_change_pool\n");
+    CHECK(bot.set_tls_mem_pool(&pool_a));
+    CHECK(bot.sendMessage((int64_t)5, "from pool A"));
+    CHECK(pool_stats(pool_a).current > 0);
+
+    // Connection blocks of pool A are released while pool B is set
+    CHECK(bot.set_tls_mem_pool(&pool_b));
+    bot.disconnect();
+    CHECK(pool_stats(pool_a).current == 0);
+    CHECK(bot.sendMessage((int64_t)5, "from pool B"));
+    CHECK(pool_stats(pool_a).allocs == pool_stats(pool_a).frees);
+    CHECK(pool_stats(pool_b).current > 0);
+
+    // Connection blocks of pool B are released without pool
+    CHECK(bot.set_tls_mem_pool(NULL));
+    bot.disconnect();
+    CHECK(pool_stats(pool_b).current == 0);
+    CHECK(bot.sendMessage((int64_t)5, "from heap"));
+    CHECK(pool_stats(pool_b).allocs == pool_stats(pool_b).frees);
+}
+
+// The send path connection uses the pool too once paths are split, before or after set it
+static void test_split_paths(void)
+{
+    static uint64_t memory[POOL_SIZE/sizeof(uint64_t)];
+    MultiHTTPSClientMemPool pool(memory, sizeof(memory));
+    uTLGBot bot_a("123:ABC");
+    uTLGBot bot_b("456:DEF");
+    unsigned long allocs;
+    uint32_t pool_allocs;
+    uint32_t sent = 0;
+
+    printf("test_split_paths\n");
+    CHECK(bot_a.set_tls_mem_pool(&pool));
+    CHECK(bot_a.split_paths());
+    CHECK(bot_b.split_paths());
+    CHECK(bot_b.set_tls_mem_pool(&pool));
+
+    // Send paths connections are made from the pool
+    pool_allocs = pool_stats(pool).allocs;
+    CHECK(bot_a.sendMessage((int64_t)5, "warm up"));
+    CHECK(pool_stats(pool).allocs > pool_allocs);
+    pool_allocs = pool_stats(pool).allocs;
+    CHECK(bot_b.sendMessage((int64_t)5, "warm up"));
+    CHECK(pool_stats(pool).allocs > pool_allocs);
+    bot_a.getUpdates();
+    bot_b.getUpdates();
+    CHECK(mock_count("_accept") == 4);
+
+    allocs = heap_allocs;
+    for(uint32_t i = 0; i < STEADY_REQUESTS; i++)
+    {
+        if(bot_a.sendMessage((int64_t)5, "hello") && bot_b.sendMessage((int64_t)5, "hello"))
+            sent = sent + 1;
+    }
+    CHECK(sent == STEADY_REQUESTS);
+    CHECK(heap_allocs == allocs);
+    CHECK(pool_stats(pool).fails == 0);
+}
+
+/**************************************************************************************************/
+
+/* Main Function */
+
+int main(void)
+{
+    CHECK(mock_start("{}"));
+    test_steady_state();
+    CHECK(mock_start("{}"));
+    test_change_pool();
+    CHECK(mock_start("{}"));
+    test_split_paths();
+    mock_stop();
+
+    return test_result("test_mem_pool");
+}
@@ -0,0 +1,241 @@
+/**************************************************************************************************/
+// Project: uTLGBotLib
+// File: test_queues.cpp
+// Description: Lock-free queues tests (SPSC and MPSC queues keep the FIFO order of each producer
+//              under contention, and move-only objects are neither lost nor duplicated).
+// Created on: 19 oct. 2026
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <atomic>
+#include <thread>
+#include "utlgbotlib.h"
+#include "test.h"
+
+/**************************************************************************************************/
+
+/* Constants */
+
+#define QUEUE_SIZE 64
+#define QUEUE_ITEMS 200000
+#define QUEUE_PRODUCERS 4
+
+/**************************************************************************************************/
+
+/* Test Item */
+
+// Number of test items that own a value (not moved-from ones)
+static std::atomic<long> live_items(0);
+
+// Move-only item that owns its value (producer and sequence number), so a lost or duplicated
+// item is seen in the live items count
+class test_item
+{
+    public:
+        test_item() : _value(NULL) {}
+
+        test_item(const uint32_t producer, const uint32_t seq) : _value(new uint64_t)
+        {
+            *_value = ((uint64_t)producer << 32) | seq;
+            live_items++;
+        }
+
+        test_item(test_item&& item) : _value(item._value)
+        {
+            item._value = NULL;
+        }
+
+        test_item& operator=(test_item&& item)
+        {
+            if(this != &item)
+            {
+                release();
+                _value = item._value;
+                item._value = NULL;
+            }
+            return *this;
+        }
+
+        ~test_item()
+        {
+            release();
+        }
+
+        bool is_valid() { return (_value != NULL); }
+        uint32_t producer() { return (uint32_t)(*_value >> 32); }
+        uint32_t seq() { return (uint32_t)(*_value & 0xFFFFFFFF); }
+
+    private:
+        uint64_t* _value;
+
+        void release()
+        {
+            if(_value == NULL)
+                return;
+            delete _value;
+            _value = NULL;
+            live_items--;
+        }
+
+        // Not copyable
+        test_item(const test_item&);
+        test_item& operator=(const test_item&);
+};
+
+/**************************************************************************************************/
+
+/* Tests */
+
+// A push to a full queue fails without moving the object, a pop of an empty one fails, and the
+// objects left in a queue are released with it
+static void test_full_empty(void)
+{
+    printf("test_full_empty\n");
+    {
+        uTLGBotSPSCQueue<test_item, 4> spsc;
+        uTLGBotMPSCQueue<test_item, 4> mpsc;
+        test_item item;
+        uint32_t pushed = 0;
+
+        CHECK(!spsc.pop(item));
+        CHECK(!mpsc.pop(item));
+        for(uint32_t i = 0; i < 4; i++)
+        {
+            if(spsc.push(test_item(0, i)) && mpsc.push(test_item(1, i)))
+                pushed = pushed + 1;
+        }
+        CHECK(pushed == 4);
+        CHECK(spsc.get_count() == 4);
+        item = test_item(2, 0);
+        CHECK(!spsc.push(std::move(item)));
+        CHECK(!mpsc.push(std::move(item)));
+        CHECK(item.is_valid());
+        CHECK(spsc.pop(item) && (item.producer() == 0) && (item.seq() == 0));
+        CHECK(mpsc.pop(item) && (item.producer() == 1) && (item.seq() == 0));
+        CHECK(live_items == 7);
+    }
+    CHECK(live_items == 0);
+}
+
+// Objects passed from a producer thread to a consumer one through a small SPSC queue (so it is
+// full and empty many times) keep their order
+static void test_spsc_order(void)
+{
+    static uTLGBotSPSCQueue<test_item, QUEUE_SIZE> queue;
+    uint32_t expected = 0;
+    uint32_t fails = 0;
+    test_item item;
+
+    printf("test_spsc_order\n");
+    std::thread producer([]()
+    {
+        test_item item;
+
+        for(uint32_t i = 0; i < QUEUE_ITEMS; i++)
+        {
+            item = test_item(0, i);
+            while(!queue.push(std::move(item)))
+                std::this_thread::yield();
+        }
+    });
+    while(expected < QUEUE_ITEMS)
+    {
+        if(!queue.pop(item))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        if(!item.is_valid() || (item.seq() != expected))
+            fails = fails + 1;
+        expected = expected + 1;
+    }
+    producer.join();
+    item = test_item();
+    CHECK(fails == 0);
+    CHECK(!queue.pop(item));
+    CHECK(live_items == 0);
+}
+
+// Objects passed from many producer threads to a consumer one through a small MPSC queue keep
+// the order of each producer, and all of them are received once
+static void test_mpsc_order(void)
+{
+    static uTLGBotMPSCQueue<test_item, QUEUE_SIZE> queue;
+    std::thread producers[QUEUE_PRODUCERS];
+    uint32_t expected[QUEUE_PRODUCERS];
+    uint32_t received = 0;
+    uint32_t fails = 0;
+    test_item item;
+
+    printf("test_mpsc_order\n");
+    for(uint32_t p = 0; p < QUEUE_PRODUCERS; p++)
+    {
+        expected[p] = 0;
+        producers[p] = std::thread([p]()
+        {
+            test_item item;
+
+            for(uint32_t i = 0; i < QUEUE_ITEMS/QUEUE_PRODUCERS; i++)
+            {
+                item = test_item(p, i);
+                while(!queue.push(std::move(item)))
+                    std::this_thread::yield();
+            }
+        });
+    }
+    while(received < (QUEUE_ITEMS/QUEUE_PRODUCERS) * QUEUE_PRODUCERS)
+    {
+        if(!queue.pop(item))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        if(!item.is_valid() || (item.producer() >= QUEUE_PRODUCERS) ||
+            (item.seq() != expected[item.producer()]))
+            fails = fails + 1;
+        else
+            expected[item.producer()] = expected[item.producer()] + 1;
+        received = received + 1;
+    }
+    for(uint32_t p = 0; p < QUEUE_PRODUCERS; p++)
+    {
+        producers[p].join();
+        if(expected[p] != QUEUE_ITEMS/QUEUE_PRODUCERS)
+            fails = fails + 1;
+    }
+    item = test_item();
+    CHECK(fails == 0);
+    CHECK(!queue.pop(item));
+    CHECK(live_items == 0);
+}
+
+// Outbound messages are moved through the queue (the popped one is valid, the pushed one isn't)
+static void test_out_msgs(void)
+{
+    uTLGBotMPSCQueue<uTLGBotOutMsg, 4> queue;
+    uTLGBotOutMsg msg(5, "Done", "Markdown");
+    uTLGBotOutMsg received;
+
+    printf("test_out_msgs\n");
+    CHECK(msg.is_valid());
+    CHECK(queue.push(std::move(msg)));
+    CHECK(!msg.is_valid());
+    CHECK(!received.is_valid());
+    CHECK(queue.pop(received));
+    CHECK(received.is_valid());
+}
+
+/**************************************************************************************************/
+
+/* Main Function */
+
+int main(void)
+{
+    test_full_empty();
+    test_spsc_order();
+    test_mpsc_order();
+    test_out_msgs();
+
+    return test_result("test_queues");
+}
@@ -0,0 +1,140 @@
+/**************************************************************************************************/
+// Project: uTLGBotLib
+// File: test_reactor.cpp
+// Description: Reactor tests (a response received in parts is read once all its body arrived, and
+//              a bot which server doesn't answer the TLS handshake doesn't stop the other bots).
+// Created on: 19 oct. 2026
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include "utlgbotlib.h"
+#include "test.h"
+
+/**************************************************************************************************/
+
+/* Constants */
+
+#define TEST_TIMEOUT_MS 3000
+#define RUN_WAIT_MS 20
+#define RUN_MAX_MS 150
+#define SPLIT_MS 300
+
+/**************************************************************************************************/
+
+/* Functions */
+
+// Updates received by a bot (number of messages and text of the last one)
+typedef struct test_updates
+{
+    uint32_t count;
+    char text[32];
+} test_updates;
+
+// Reactor update handler that keeps the received messages
+static void handle_update(uTLGBot& bot, const uint8_t update_type, void* arg)
+{
+    test_updates* updates = (test_updates*)arg;
+
+    if(update_type != TLG_UPDATE_MESSAGE)
+        return;
+    snprintf(updates->text, sizeof(updates->text), "%s", bot.get_msg_text());
+    updates->count = updates->count + 1;
+}
+
+// Run the reactor until the bots receive the given number of messages or the time elapses
+// Return the longest time of a run
+static unsigned long run_until(uTLGBotReactor& reactor, test_updates* updates,
+    const uint32_t num_bots, const uint32_t count, const unsigned long timeout_ms)
+{
+    unsigned long t0 = test_millis();
+    unsigned long t_run;
+    unsigned long longest = 0;
+    uint32_t received = 0;
+
+    while((received < count) && (test_millis() - t0 < timeout_ms))
+    {
+        t_run = test_millis();
+        reactor.run_once(RUN_WAIT_MS);
+        t_run = test_millis() - t_run;
+        if(t_run > longest)
+            longest = t_run;
+        received = 0;
+        for(uint32_t i = 0; i < num_bots; i++)
+            received = received + updates[i].count;
+    }
+
+    return longest;
+}
+
+/**************************************************************************************************/
+
+/* Tests */
+
+// A response which body arrives in two parts is received complete, and the reactor runs while it
+// waits for the second part
+static void test_split_response(void)
+{
+    uTLGBot bot("123:ABC");
+    uTLGBotReactor reactor;
+    test_updates updates = { 0, "" };
+    unsigned long longest;
+    std::string config;
+    char split[16];
+
+    printf("test_split_response\n");
+    snprintf(split, sizeof(split), "%u", SPLIT_MS);
+    config = std::string("{\"split_ms\":") + split + ",\"updates\":[" +
+        mock_update(1, 42, "split in two parts") + "]}";
+    CHECK(mock_start(config.c_str()));
+    CHECK(reactor.add_bot(bot, handle_update, &updates));
+
+    longest = run_until(reactor, &updates, 1, 1, TEST_TIMEOUT_MS);
+    CHECK(updates.count == 1);
+    CHECK(strcmp(updates.text, "split in two parts") == 0);
+    CHECK(longest < RUN_MAX_MS);
+    mock_stop();
+}
+
+// A bot which connection never gets the TLS handshake answered doesn't stop the updates of other
+// bot (its request is connected again once it times out)
+static void test_stalled_bot(void)
+{
+    uTLGBot bot_1("123:ABC");
+    uTLGBot bot_2("456:DEF");
+    uTLGBotReactor reactor;
+    test_updates updates[2] = { { 0, "" }, { 0, "" } };
+    unsigned long longest;
+    std::string config;
+
+    printf("test_stalled_bot\n");
+    config = "{\"stall_accepts\":1,\"updates\":[" + mock_update(1, 42, "flowing") + "]}";
+    CHECK(mock_start(config.c_str()));
+    CHECK(reactor.add_bot(bot_1, handle_update, &updates[0]));
+    CHECK(reactor.add_bot(bot_2, handle_update, &updates[1]));
+
+    // One bot gets the stalled connection, the other one gets the update before its timeout
+    longest = run_until(reactor, updates, 2, 1, TEST_TIMEOUT_MS);
+    CHECK(updates[0].count + updates[1].count == 1);
+    CHECK((strcmp(updates[0].text, "flowing") == 0) || (strcmp(updates[1].text, "flowing") == 0));
+    CHECK(longest < RUN_MAX_MS);
+    CHECK(mock_count("_accept") == 1);
+
+    // Once it times out, the stalled bot connects again (there are no more updates)
+    longest = run_until(reactor, updates, 2, UINT32_MAX, HTTP_WAIT_RESPONSE_TIMEOUT + 1000);
+    CHECK(longest < RUN_MAX_MS);
+    CHECK(mock_count("_accept") == 2);
+    mock_stop();
+}
+
+/**************************************************************************************************/
+
+/* Main Function */
+
+int main(void)
+{
+    test_split_response();
+    test_stalled_bot();
+
+    return test_result("test_reactor");
+}
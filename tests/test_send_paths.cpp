@@ -0,0 +1,83 @@
+/**************************************************************************************************/
+// Project: uTLGBotLib
+// File: test_send_paths.cpp
+// Description: Split send paths tests (a callback answer is not delayed by a broadcast that is
+//              being sent from other thread).
+// Created on: 19 oct. 2026
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include <thread>
+#include "utlgbotlib.h"
+#include "test.h"
+
+/**************************************************************************************************/
+
+/* Constants */
+
+#define NUM_BROADCAST_CHATS 10
+#define SEND_DELAY_MS 200
+#define ANSWER_AFTER_MS 300
+#define MAX_ANSWER_MS 1000
+
+/**************************************************************************************************/
+
+/* Tests */
+
+// A callback answer made while a broadcast is being sent (that holds the send path until it ends)
+// is sent at once through its own path
+static void test_answer_during_broadcast(void)
+{
+    uTLGBot bot("123:ABC");
+    int64_t chat_ids[NUM_BROADCAST_CHATS];
+    unsigned long broadcast_end_t = 0;
+    unsigned long answer_t;
+    unsigned long answer_end_t;
+    uint32_t sent = 0;
+    bool answered;
+
+    printf("test_answer_during_broadcast\n");
+    for(uint32_t i = 0; i < NUM_BROADCAST_CHATS; i++)
+        chat_ids[i] = 100 + i;
+    CHECK(bot.split_paths());
+
+    std::thread broadcaster([&bot, &chat_ids, &sent, &broadcast_end_t]()
+    {
+        sent = bot.broadcast(chat_ids, NUM_BROADCAST_CHATS, "news");
+        broadcast_end_t = test_millis();
+    });
+
+    // The broadcast takes NUM_BROADCAST_CHATS*SEND_DELAY_MS, the answer just its own request
+    usleep(ANSWER_AFTER_MS*1000);
+    answer_t = test_millis();
+    answered = bot.answerCallbackQuery("cb1", "done");
+    answer_end_t = test_millis();
+    answer_t = answer_end_t - answer_t;
+    broadcaster.join();
+
+    CHECK(answered);
+    CHECK(answer_t < MAX_ANSWER_MS);
+    CHECK(sent == NUM_BROADCAST_CHATS);
+    CHECK(answer_end_t < broadcast_end_t);
+    CHECK(mock_count("answerCallbackQuery") == 1);
+    CHECK(mock_count("sendMessage") == NUM_BROADCAST_CHATS);
+}
+
+/**************************************************************************************************/
+
+/* Main Function */
+
+int main(void)
+{
+    std::string config;
+    char delay[16];
+
+    snprintf(delay, sizeof(delay), "%u", SEND_DELAY_MS);
+    config = std::string("{\"send_delay_ms\":") + delay + "}";
+    CHECK(mock_start(config.c_str()));
+    test_answer_during_broadcast();
+    mock_stop();
+
+    return test_result("test_send_paths");
+}
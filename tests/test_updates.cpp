@@ -0,0 +1,286 @@
+/**************************************************************************************************/
+// Project: uTLGBotLib
+// File: test_updates.cpp
+// Description: Received updates tests (lazy decoding gets the same fields as the eager one, the
+//              fields of a message replaced by a new one are not mixed with it, and the records
+//              queue keeps the FIFO order when it wraps around its memory).
+// Created on: 19 oct. 2026
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include "unit.h"
+#include "test.h"
+
+/**************************************************************************************************/
+
+/* Constants */
+
+#define QUEUE_MEMORY_SIZE 1024
+#define QUEUE_PUSHES 200
+
+/**************************************************************************************************/
+
+/* Functions */
+
+// Create a getUpdates result with a text message update (from a user, in the given chat, and
+// without username if it is empty)
+static std::string make_result(const uint32_t update_id, const int64_t chat_id,
+    const char* chat_fields, const char* text, const char* username)
+{
+    char json[1024];
+
+    snprintf(json, sizeof(json), "[{\"update_id\":%u,\"message\":{\"message_id\":%u,"
+        "\"from\":{\"id\":611234567,\"is_bot\":false,\"first_name\":\"Alice\","
+        "\"last_name\":\"Smith\"%s%s%s,\"language_code\":\"en\"},\"chat\":{\"id\":%lld,%s},"
+        "\"date\":1760870400,\"text\":\"%s\",\"entities\":[{\"offset\":0,\"length\":7,"
+        "\"type\":\"bot_command\"}]}}]", update_id, update_id + 1000,
+        (username[0] != '\0') ? ",\"username\":\"" : "", username,
+        (username[0] != '\0') ? "\"" : "", (long long)chat_id, chat_fields, text);
+    return json;
+}
+
+// Get the text of a queue test message (from 0 to 60 characters, so records have different sizes)
+static std::string queue_text(const uint32_t update_id)
+{
+    return std::string((update_id * 7) % 61, (char)('a' + (update_id % 26)));
+}
+
+// Check that two users are equal
+static bool same_user(const tlg_type_user& a, const tlg_type_user& b)
+{
+    return ((a.id == b.id) && (a.is_bot == b.is_bot) &&
+        (strcmp(a.first_name, b.first_name) == 0) && (strcmp(a.last_name, b.last_name) == 0) &&
+        (strcmp(a.username, b.username) == 0) &&
+        (strcmp(a.language_code, b.language_code) == 0));
+}
+
+// Check that two chats are equal
+static bool same_chat(const tlg_type_chat& a, const tlg_type_chat& b)
+{
+    return ((a.id == b.id) && (strcmp(a.type, b.type) == 0) &&
+        (strcmp(a.title, b.title) == 0) && (strcmp(a.username, b.username) == 0) &&
+        (strcmp(a.first_name, b.first_name) == 0) && (strcmp(a.last_name, b.last_name) == 0));
+}
+
+// Receive a text message with a text of given length (each message ID gets its own text) and push
+// it to a records queue
+static bool queue_push(uTLGBot& bot, uTLGBotMsgQueue& queue, const uint32_t update_id,
+    const bool overwrite_oldest)
+{
+    std::string text = queue_text(update_id);
+    std::string result;
+
+    result = make_result(update_id, 611234567, "\"type\":\"private\"", text.c_str(), "alice_s");
+    if(uTLGBotTests::receive_updates(bot, result.c_str()) != TLG_UPDATE_MESSAGE)
+        return false;
+    return queue.push(bot, overwrite_oldest);
+}
+
+// Check that a record is the message of given update ID pushed by queue_push()
+static bool queue_record_is(const tlg_msg_record* record, const uint32_t update_id)
+{
+    return ((record != NULL) && (record->message_id == update_id + 1000) &&
+        (record->chat_id == 611234567) &&
+        (strcmp(uTLGBotMsgQueue::get_str(record, TLG_MSG_RECORD_TEXT),
+            queue_text(update_id).c_str()) == 0) &&
+        (strcmp(uTLGBotMsgQueue::get_str(record, TLG_MSG_RECORD_FROM_USERNAME),
+            "@alice_s") == 0) &&
+        (strcmp(uTLGBotMsgQueue::get_str(record, TLG_MSG_RECORD_CHAT_TYPE), "private") == 0) &&
+        (strcmp(uTLGBotMsgQueue::get_str(record, TLG_MSG_RECORD_CHAT_TITLE), "") == 0));
+}
+
+/**************************************************************************************************/
+
+/* Tests */
+
+// Fields decoded on access get the same values as the eager decoding (chat ID alone, and then
+// the full chat)
+static void test_lazy_fields(void)
+{
+    std::string results[3];
+    uTLGBot eager("123:ABC");
+    uTLGBot lazy("123:ABC");
+    uint32_t fails = 0;
+
+    printf("test_lazy_fields\n");
+    results[0] = make_result(1, 611234567, "\"first_name\":\"Alice\",\"type\":\"private\"",
+        "/status web-01", "alice_s");
+    results[1] = make_result(2, -1001234567890, "\"title\":\"Ops \\\"team\\\"\","
+        "\"username\":\"ops\",\"type\":\"supergroup\"", "/deploy \\u00e9 \\ud83d\\ude00", "");
+    results[2] = make_result(3, -42, "\"title\":\"Group\",\"type\":\"group\"", "", "bob");
+    lazy.set_lazy_decode(true);
+    for(uint32_t i = 0; i < 3; i++)
+    {
+        if((uTLGBotTests::receive_updates(eager, results[i].c_str()) != TLG_UPDATE_MESSAGE) ||
+            (uTLGBotTests::receive_updates(lazy, results[i].c_str()) != TLG_UPDATE_MESSAGE))
+        {
+            fails = fails + 1;
+            continue;
+        }
+        if((lazy.get_msg_chat_id() != eager.get_msg_chat_id()) ||
+            (strcmp(lazy.get_msg_text(), eager.get_msg_text()) != 0) ||
+            (lazy.get_msg_id() != eager.get_msg_id()) ||
+            (lazy.get_msg_date() != eager.get_msg_date()) ||
+            !same_chat(lazy.get_msg_chat(), eager.get_msg_chat()) ||
+            !same_user(lazy.get_msg_from(), eager.get_msg_from()))
+        {
+            printf("  lazy decoding of update %u differs\n", i + 1);
+            fails = fails + 1;
+        }
+    }
+    CHECK(fails == 0);
+}
+
+// Fields not accessed yet are decoded when the received data buffer is reused by other request,
+// so they are still available after it
+static void test_lazy_release(void)
+{
+    uTLGBot bot("123:ABC");
+    std::string result;
+
+    printf("test_lazy_release\n");
+    result = make_result(1, 611234567, "\"first_name\":\"Alice\",\"type\":\"private\"",
+        "/start", "alice_s");
+    bot.set_lazy_decode(true);
+    CHECK(uTLGBotTests::receive_updates(bot, result.c_str()) == TLG_UPDATE_MESSAGE);
+    CHECK(bot.get_msg_chat_id() == 611234567);
+    CHECK(uTLGBotTests::release_buffer(bot));
+    CHECK(strcmp(bot.received_msg.from.username, "@alice_s") == 0);
+    CHECK(strcmp(bot.received_msg.chat.type, "private") == 0);
+    CHECK(strcmp(bot.get_msg_text(), "/start") == 0);
+}
+
+// A message replaced by a new one is not decoded (its fields not accessed are dropped), and none
+// of its fields is kept in the new one
+static void test_lazy_replaced(void)
+{
+    uTLGBot bot("123:ABC");
+    std::string first;
+    std::string second;
+
+    printf("test_lazy_replaced\n");
+    first = make_result(1, -42, "\"title\":\"Group\",\"type\":\"group\"", "first", "alice_s");
+    second = make_result(2, 611234567, "\"type\":\"private\"", "second", "");
+    bot.set_lazy_decode(true);
+    CHECK(uTLGBotTests::receive_updates(bot, first.c_str()) == TLG_UPDATE_MESSAGE);
+    CHECK(bot.get_msg_chat_id() == -42);
+    CHECK(uTLGBotTests::receive_updates(bot, second.c_str()) == TLG_UPDATE_MESSAGE);
+    CHECK(strcmp(bot.received_msg.from.username, "") == 0);
+    CHECK(strcmp(bot.get_msg_from().username, "") == 0);
+    CHECK(strcmp(bot.get_msg_chat().title, "") == 0);
+    CHECK(strcmp(bot.get_msg_text(), "second") == 0);
+
+    // No new message: the replaced one is not available
+    CHECK(uTLGBotTests::receive_updates(bot, "[]") == TLG_UPDATE_NONE);
+    CHECK(strcmp(bot.get_msg_text(), "") == 0);
+}
+
+// Records pushed and popped past the end of the queue memory (wrapping to its start) keep the
+// FIFO order and their content, and a push only fails when the queue is full
+static void test_queue_wrap(void)
+{
+    static uint64_t memory[QUEUE_MEMORY_SIZE/sizeof(uint64_t)];
+    uTLGBotMsgQueue queue(memory, sizeof(memory));
+    uTLGBot bot("123:ABC");
+    const tlg_msg_record* last = NULL;
+    uint32_t oldest = 1;
+    uint32_t wraps = 0;
+    uint32_t fails = 0;
+
+    printf("test_queue_wrap\n");
+    bot.set_lazy_decode(true);
+    for(uint32_t id = 1; id <= QUEUE_PUSHES; id++)
+    {
+        // Pop the oldest records until the new one fits
+        while(!queue_push(bot, queue, id, false))
+        {
+            if(queue.get_count() == 0)
+            {
+                printf("  push of update %u fails with the queue empty\n", id);
+                fails = fails + 1;
+                break;
+            }
+            if(!queue_record_is(queue.front(), oldest))
+            {
+                printf("  front is not update %u\n", oldest);
+                fails = fails + 1;
+            }
+            queue.pop();
+            oldest = oldest + 1;
+        }
+        if(!queue_record_is(queue.back(), id))
+        {
+            printf("  back is not update %u\n", id);
+            fails = fails + 1;
+        }
+        if((last != NULL) && (queue.back() < last))
+            wraps = wraps + 1;
+        last = queue.back();
+        if(queue.get_count() != id - oldest + 1)
+            fails = fails + 1;
+        if(queue.get_used() > sizeof(memory))
+            fails = fails + 1;
+    }
+
+    // Remaining records are the newest ones in order
+    while(queue.get_count() > 0)
+    {
+        if(!queue_record_is(queue.front(), oldest))
+            fails = fails + 1;
+        queue.pop();
+        oldest = oldest + 1;
+    }
+    CHECK(fails == 0);
+    CHECK(wraps > 0);
+    CHECK(oldest == QUEUE_PUSHES + 1);
+    CHECK(queue.get_used() == 0);
+    CHECK(queue.front() == NULL);
+}
+
+// Push with overwrite_oldest keeps the last records that fit (a history of consecutive messages
+// ending at the last one)
+static void test_queue_overwrite(void)
+{
+    static uint64_t memory[QUEUE_MEMORY_SIZE/sizeof(uint64_t)];
+    uTLGBotMsgQueue queue(memory, sizeof(memory));
+    uTLGBot bot("123:ABC");
+    uint32_t pushed = 0;
+    uint32_t oldest;
+    uint32_t fails = 0;
+
+    printf("test_queue_overwrite\n");
+    for(uint32_t id = 1; id <= QUEUE_PUSHES; id++)
+    {
+        if(queue_push(bot, queue, id, true))
+            pushed = pushed + 1;
+    }
+    CHECK(pushed == QUEUE_PUSHES);
+    CHECK(queue.get_count() > 1);
+    CHECK(queue_record_is(queue.back(), QUEUE_PUSHES));
+
+    oldest = QUEUE_PUSHES - queue.get_count() + 1;
+    while(queue.get_count() > 0)
+    {
+        if(!queue_record_is(queue.front(), oldest))
+            fails = fails + 1;
+        queue.pop();
+        oldest = oldest + 1;
+    }
+    CHECK(fails == 0);
+}
+
+/**************************************************************************************************/
+
+/* Main Function */
+
+int main(void)
+{
+    test_lazy_fields();
+    test_lazy_release();
+    test_lazy_replaced();
+    test_queue_wrap();
+    test_queue_overwrite();
+
+    return test_result("test_updates");
+}
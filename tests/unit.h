@@ -0,0 +1,87 @@
+/**************************************************************************************************/
+// Project: uTLGBotLib
+// File: unit.h
+// Description: Access to the library internals for unit tests and benchmarks (they include the
+//              library source, so they are built with UTLGBOT_TESTS and without the library
+//              object, and the file static functions are reachable too).
+// Created on: 19 oct. 2026
+/**************************************************************************************************/
+
+#ifndef UTLGBOT_UNIT_H_
+#define UTLGBOT_UNIT_H_
+
+/**************************************************************************************************/
+
+/* Libraries */
+
+#include "../src/utlgbotlib.cpp"
+
+/**************************************************************************************************/
+
+/* Library Internals */
+
+class uTLGBotTests
+{
+    public:
+        static int32_t json_escape_str(const char* src, const size_t src_len, char* dest,
+            const size_t dest_max_size)
+        {
+            return uTLGBot::json_escape_str(src, src_len, dest, dest_max_size);
+        }
+
+        static uint32_t json_unescape_str(const char* src, const size_t src_len, char* dest,
+            const size_t dest_max_size)
+        {
+            return uTLGBot::json_unescape_str(src, src_len, dest, dest_max_size);
+        }
+
+        static bool cstr_to_int64(const char* str, const size_t str_len, int64_t* value)
+        {
+            return uTLGBot::cstr_to_int64(str, str_len, value);
+        }
+
+        static uint32_t cstr_from_int64(const int64_t value, char* str)
+        {
+            return uTLGBot::cstr_from_int64(value, str);
+        }
+
+        // Receive a getUpdates response result (list of updates) as getUpdates() does
+        static uint8_t receive_updates(uTLGBot& bot, const char* result)
+        {
+            size_t len = strlen(result);
+
+            if(!bot.updates_arena_acquire() || (len >= HTTP_MAX_RES_LENGTH))
+                return TLG_UPDATE_NONE;
+            memcpy(bot._buffer, result, len + 1);
+            bot._rx_path.result_pos = 0;
+            bot._rx_path.result_len = (uint32_t)len;
+            return bot.parse_updates();
+        }
+
+        // Get the received data buffer for other request (as send requests do)
+        static bool release_buffer(uTLGBot& bot)
+        {
+            return bot.arena_acquire();
+        }
+
+        static uint8_t json_get_key_id(uTLGBot& bot, const char* json_str, jsmntok_t* token)
+        {
+            return bot.json_get_key_id(json_str, token);
+        }
+
+        static void json_index_subtrees(uTLGBot& bot, jsmntok_t* json_tokens,
+            const uint32_t num_tokens, uint32_t* subtree_len)
+        {
+            bot.json_index_subtrees(json_tokens, num_tokens, subtree_len);
+        }
+
+        static void json_map_keys(uTLGBot& bot, const char* json_str, jsmntok_t* json_tokens,
+            const uint32_t* subtree_len, const uint32_t obj_token, uint32_t* keys_position)
+        {
+            bot.json_map_keys(json_str, json_tokens, subtree_len, obj_token, keys_position);
+        }
+};
+
+/**************************************************************************************************/
+
+#endif